@@ -0,0 +1,529 @@
+/**
+ * @file stan_export.cpp
+ * @brief Command line tool which renders every frame of an animation into
+ *        a numbered PNG sequence, without a display or GUI event loop.
+ *        Optionally generates tweened in-betweens between the frames.
+ * @date 10-18-26
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+
+#include <fstream>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <wx/wx.h>
+#include <wx/init.h>
+#include <wx/image.h>
+#include <wx/mstream.h>
+
+#include "archive_io.h"
+#include "indexed_animation.h"
+#include "tween.h"
+#include "soft_render.h"
+#include "work_pool.h"
+#include "ordered_writer.h"
+
+using namespace stan;
+
+namespace {
+
+class export_options
+{
+public:
+    export_options() :
+        width_(0),
+        height_(0),
+        first_(0),
+        last_(-1),
+        threads_(0),
+        steps_(0),
+        input_(),
+        prefix_()
+    {
+    }
+
+    int width_;         // 0 = use the frame size
+    int height_;
+    int first_;         // first frame to render (0 based)
+    int last_;          // last frame to render, -1 = last frame of the animation
+    int threads_;       // 0 = one per hardware thread
+    int steps_;         // in-betweens generated after every frame but the last
+    std::string input_;
+    std::string prefix_;
+};
+
+void usage()
+{
+    std::cerr << "usage: stan_export [options] <animation> <output prefix>" << std::endl
+              << "  Writes <output prefix>00000.png, <output prefix>00001.png, ..." << std::endl
+              << "options:" << std::endl
+              << "  -s <width>x<height>  output size (default: frame size)" << std::endl
+              << "  -f <first>           first frame, 0 based (default: 0)" << std::endl
+              << "  -l <last>            last frame (default: last frame of the animation)" << std::endl
+              << "  -j <threads>         number of worker threads (default: all cores)" << std::endl
+              << "  -t <steps>           tween <steps> frames between consecutive frames (default: 0)" << std::endl;
+}
+
+bool parse_args(int argc, char* argv[], export_options& opts)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if ( (arg.size() == 2) && (arg[0] == '-') ) {
+            if (i + 1 >= argc) {
+                return false;
+            }
+            const char* value = argv[++i];
+            if (arg == "-s") {
+                if ( (sscanf(value, "%dx%d", &opts.width_, &opts.height_) != 2) ||
+                     (opts.width_ <= 0) || (opts.height_ <= 0) ) {
+                    return false;
+                }
+            }
+            else if (arg == "-f") {
+                opts.first_ = atoi(value);
+            }
+            else if (arg == "-l") {
+                opts.last_ = atoi(value);
+            }
+            else if (arg == "-j") {
+                opts.threads_ = atoi(value);
+            }
+            else if (arg == "-t") {
+                opts.steps_ = atoi(value);
+            }
+            else {
+                return false;
+            }
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    if ( (files.size() != 2) || (opts.threads_ < 0) || (opts.first_ < 0) || (opts.steps_ < 0) ) {
+        return false;
+    }
+    opts.input_ = files[0];
+    opts.prefix_ = files[1];
+    return true;
+}
+
+/**
+ * Copy a wxImage into a soft_image. Masked pixels become transparent.
+ */
+void to_soft_image(wxImage& image, soft_image& out)
+{
+    out = soft_image(image.GetWidth(), image.GetHeight());
+
+    const unsigned char* rgb = image.GetData();
+    for (int y = 0; y < image.GetHeight(); y++) {
+        for (int x = 0; x < image.GetWidth(); x++) {
+            unsigned char* p = out.get_pixel(x, y);
+            p[0] = rgb[0];
+            p[1] = rgb[1];
+            p[2] = rgb[2];
+            if (image.HasAlpha()) {
+                p[3] = image.GetAlpha(x, y);
+            }
+            else {
+                p[3] = image.IsTransparent(x, y) ? 0 : 255;
+            }
+            rgb += 3;
+        }
+    }
+}
+
+/**
+ * Load every image of a meta store into the renderer (once per path).
+ */
+void load_images(meta_store* meta, SoftRender& sr, std::set<std::string>& loaded)
+{
+    BOOST_FOREACH(meta_data* md, meta->get_meta_table()) {
+        if ( (md == NULL) || (md->get_type() != META_IMAGE) ) {
+            continue;
+        }
+
+        std::string path = md->get_path();
+        if (!loaded.insert(path).second) {
+            continue;
+        }
+
+        wxImage image;
+        if (!image.LoadFile(wxString(path.c_str(), wxConvUTF8))) {
+            std::cerr << "Invalid image file " << path << std::endl;
+            continue;
+        }
+        soft_image pixels;
+        to_soft_image(image, pixels);
+        sr.add_image(path, pixels);
+    }
+}
+
+typedef boost::shared_ptr<std::string> png_data;
+typedef boost::shared_ptr<frame> frame_ptr;
+
+/**
+ * The frames of the animation being exported, by frame number.
+ */
+class frame_source
+{
+public:
+    virtual ~frame_source() {}
+
+    virtual int get_frame_count() = 0;
+
+    /**
+     * @return The frame or an empty pointer if it can not be read
+     */
+    virtual frame_ptr get_frame(int n) = 0;
+
+    virtual meta_store* get_meta_store() = 0;
+};
+
+/**
+ * Deleter for frames owned by an animation.
+ */
+void keep_frame(frame*)
+{
+}
+
+/**
+ * Deleter for generated in-betweens, which own their figures.
+ */
+void delete_frame(frame* fr)
+{
+    fr->delete_figures();
+    delete fr;
+}
+
+/**
+ * A completely loaded animation (XML and binary archives).
+ */
+class animation_source : public frame_source
+{
+public:
+    animation_source(animation* anim) :
+        anim_(anim),
+        frames_(anim->get_frames().begin(), anim->get_frames().end())
+    {
+    }
+
+    virtual ~animation_source() { delete anim_; }
+
+    virtual int get_frame_count() { return static_cast<int>(frames_.size()); }
+    virtual frame_ptr get_frame(int n) { return frame_ptr(frames_[n], keep_frame); }
+    virtual meta_store* get_meta_store() { return anim_->get_meta_store(); }
+
+private:
+    animation* anim_;
+    std::vector<frame*> frames_;
+};
+
+/**
+ * An indexed animation, deserialized one frame at a time: only the frames
+ * being rendered and the resident frames of the container are in memory,
+ * however long the animation is.
+ */
+class indexed_source : public frame_source
+{
+public:
+    indexed_source() :
+        indexed_()
+    {
+    }
+
+    bool open(const std::string& path) { return indexed_.open(path); }
+
+    virtual int get_frame_count() { return indexed_.get_frame_count(); }
+    virtual frame_ptr get_frame(int n) { return indexed_.get_frame(n); }
+    virtual meta_store* get_meta_store() { return indexed_.get_meta_store(); }
+
+private:
+    indexed_animation indexed_;
+};
+
+/**
+ * Open an animation archive of any format.
+ * @return The frames (owned by the caller) or NULL on failure
+ */
+frame_source* open_source(const std::string& path)
+{
+    if (detect_archive_format(path) == ARCHIVE_INDEXED) {
+        indexed_source* source = new indexed_source();
+        if (!source->open(path)) {
+            delete source;
+            return NULL;
+        }
+        return source;
+    }
+
+    animation* anim = load_animation(path);
+    return (anim != NULL) ? new animation_source(anim) : NULL;
+}
+
+/**
+ * Encode a rendered image as PNG in memory.
+ * @return The PNG bytes or an empty pointer on failure
+ */
+png_data encode_png(const soft_image& target)
+{
+    int width = target.get_width();
+    int height = target.get_height();
+
+    // wxImage takes ownership of malloc'ed buffers
+    unsigned char* rgb = static_cast<unsigned char*>(malloc(width * height * 3));
+    unsigned char* alpha = static_cast<unsigned char*>(malloc(width * height));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const unsigned char* p = target.get_pixel(x, y);
+            int i = (y * width) + x;
+            rgb[i * 3] = p[0];
+            rgb[i * 3 + 1] = p[1];
+            rgb[i * 3 + 2] = p[2];
+            alpha[i] = p[3];
+        }
+    }
+
+    wxImage image(width, height, rgb, alpha);
+    wxMemoryOutputStream stream;
+    if (!image.SaveFile(stream, wxBITMAP_TYPE_PNG)) {
+        return png_data();
+    }
+
+    png_data data(new std::string(stream.GetLength(), '\0'));
+    if (!data->empty()) {
+        stream.CopyTo(&(*data)[0], data->size());
+    }
+    return data;
+}
+
+/**
+ * Renders a list of frames on a work stealing pool. Every worker renders
+ * into its own buffer and encodes the PNG itself; the encoded frames go
+ * through an ordered writer so files are written in frame order, with at
+ * most a window of frames held in memory. Frames are fetched from the
+ * source by the submitting thread (the indexed container is not thread
+ * safe) and each task keeps its frame alive until it is rendered.
+ *
+ * With tweening, output n * (steps + 1) is frame n of the animation and the
+ * outputs up to the next frame are in-betweens, posed on the submitting
+ * thread by a tween_sequence of the two frames. Frames which can not be
+ * tweened (different figures) are held instead: rendered once, with the
+ * encoded image written for each of their outputs. A frame is never handed
+ * to more than one worker, rendering fills caches of its figures.
+ */
+class export_job
+{
+public:
+    export_job(const export_options& opts, frame_source& source, const SoftRender& proto) :
+        opts_(opts),
+        source_(source),
+        meta_(source.get_meta_store()),
+        proto_(proto),
+        backgrounds_(),
+        numbers_(),
+        renders_(),
+        failures_(0)
+    {
+    }
+
+    virtual ~export_job()
+    {
+        BOOST_FOREACH(SoftRender* sr, renders_) {
+            delete sr;
+        }
+    }
+
+    void add_frame(int number, int background)
+    {
+        backgrounds_.push_back(background);
+        numbers_.push_back(number);
+    }
+
+    /**
+     * Render all frames.
+     * @return The number of frames which could not be written
+     */
+    int run()
+    {
+        work_pool pool(opts_.threads_);
+
+        // one render buffer per worker, sharing the loaded images
+        for (int i = 0; i < pool.get_thread_count(); i++) {
+            renders_.push_back(new SoftRender(proto_));
+        }
+
+        ordered_writer<png_data> writer(boost::bind(&export_job::write, this, _1, _2));
+        int window = 4 * pool.get_thread_count();
+        int span = opts_.steps_ + 1;
+        frame_ptr to;
+        if (!numbers_.empty()) {
+            to = source_.get_frame(numbers_[0]);
+        }
+        for (int key = 0; key < static_cast<int>(numbers_.size()); key++) {
+            frame_ptr from = to;
+            bool last = (key + 1 == static_cast<int>(numbers_.size()));
+            to = last ? frame_ptr() : source_.get_frame(numbers_[key + 1]);
+
+            int index = key * span;
+            bool tweened = !last && from && to && tween(from.get(), to.get()).is_compatible();
+            writer.wait_for_slot(index, window);
+            submit(pool, writer, index, (last || tweened) ? 1 : span, from);
+            if (!tweened) {
+                continue;
+            }
+
+            tween_sequence sequence;
+            sequence.add_key(from.get(), opts_.steps_);
+            sequence.add_key(to.get(), 0);
+            for (int step = 1; step < span; step++) {
+                writer.wait_for_slot(index + step, window);
+
+                frame_ptr posed(sequence.create_frame(), delete_frame);
+                if (!sequence.get_frame(step, posed.get())) {
+                    posed.reset();
+                }
+                submit(pool, writer, index + step, 1, posed);
+            }
+        }
+        pool.wait();
+
+        return failures_;
+    }
+
+private:
+    /**
+     * Queue a frame for the outputs index to index + copies - 1; a frame
+     * which could not be read counts as a failure.
+     */
+    void submit(work_pool& pool, ordered_writer<png_data>& writer, int index, int copies, frame_ptr fr)
+    {
+        if (!fr) {
+            for (int i = 0; i < copies; i++) {
+                writer.put(index + i, png_data());  // reported by write()
+            }
+            return;
+        }
+        pool.submit(boost::bind(&export_job::render, this, &writer, index, copies, fr, _1));
+    }
+
+    /**
+     * Render and encode one frame once for all of its outputs (runs on a
+     * pool worker).
+     */
+    void render(ordered_writer<png_data>* writer, int index, int copies, frame_ptr fr, int worker)
+    {
+        SoftRender* sr = renders_[worker];
+
+        int width = (opts_.width_ > 0) ? opts_.width_ : fr->get_width();
+        int height = (opts_.height_ > 0) ? opts_.height_ : fr->get_height();
+        if ( (sr->get_width() != width) || (sr->get_height() != height) ) {
+            sr->resize(width, height);
+        }
+        sr->render_frame(fr.get(), meta_, backgrounds_[index / (opts_.steps_ + 1)]);
+
+        png_data data = encode_png(sr->get_target());
+        for (int i = 0; i < copies; i++) {
+            writer->put(index + i, data);
+        }
+    }
+
+    /**
+     * Write one encoded frame (called in frame order, one at a time).
+     */
+    void write(int index, png_data& data)
+    {
+        char name[32];
+        int span = opts_.steps_ + 1;
+        sprintf(name, "%05d.png", numbers_[index / span] * span + index % span);
+        std::string path = opts_.prefix_ + name;
+
+        bool ok = false;
+        if (data) {
+            std::ofstream ofs(path.c_str(), std::ios::out | std::ios::binary);
+            ofs.write(data->data(), data->size());
+            ok = ofs.good();
+        }
+        if (!ok) {
+            std::cerr << "Unable to write " << path << std::endl;
+            failures_++;
+        }
+    }
+
+    const export_options& opts_;
+    frame_source& source_;
+    meta_store* meta_;
+    const SoftRender& proto_;
+    std::vector<int> backgrounds_;  // background image used for each frame
+    std::vector<int> numbers_;      // frame number in the animation
+    std::vector<SoftRender*> renders_;  // render buffer of each worker
+    int failures_;                  // only touched by the writer
+};
+
+};  // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    export_options opts;
+    if (!parse_args(argc, argv, opts)) {
+        usage();
+        return 2;
+    }
+
+    wxInitializer initializer;
+    if (!initializer) {
+        std::cerr << "Failed to initialize wxWidgets" << std::endl;
+        return 1;
+    }
+    wxInitAllImageHandlers();
+
+    frame_source* source = open_source(opts.input_);
+    if (source == NULL) {
+        return 1;
+    }
+
+    // load the images up front, the workers only read them; frames are
+    // visited one at a time, so an indexed animation is never loaded whole
+    SoftRender proto(1, 1);
+    std::set<std::string> loaded;
+    load_images(source->get_meta_store(), proto, loaded);
+
+    // as in playback, a frame without a background shows the last one set
+    export_job job(opts, *source, proto);
+    int count = source->get_frame_count();
+    int last = ((opts.last_ < 0) || (opts.last_ >= count)) ? (count - 1) : opts.last_;
+    int background = -1;
+    for (int number = 0; number <= last; number++) {
+        frame_ptr fr = source->get_frame(number);
+        if (!fr) {
+            std::cerr << "Unable to read frame " << number << std::endl;
+            delete source;
+            return 1;
+        }
+        if (fr->get_image_index() >= 0) {
+            background = fr->get_image_index();
+        }
+        if (number >= opts.first_) {
+            BOOST_FOREACH(figure* f, fr->get_figures()) {
+                load_images(f->get_meta_store(), proto, loaded);
+            }
+            job.add_frame(number, background);
+        }
+    }
+
+    int failures = job.run();
+    delete source;
+
+    return (failures == 0) ? 0 : 1;
+}
+
+// END of this file -----------------------------------------------------------
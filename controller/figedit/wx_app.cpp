@@ -13,6 +13,7 @@
 
 #include "wx_frame.h"
 #include "wx_canvas.h"
+#include "wx_render.h"
 #include "animation.h"
 
 BEGIN_EVENT_TABLE(MyFrame, wxFrame)
@@ -81,7 +82,9 @@ bool MyApp::OnInit()
 
 int MyApp::OnExit()
 {
-    // cleanup
+    // the render caches hold wx objects but are statics, destroyed after
+    // wx has been cleaned up
+    WxRender::clear_caches();
     return 0;
 }
 
@@ -224,7 +224,7 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
             }
             else if (mode_ == M_IMAGE) {
                 if (sel_image_ptr_ != NULL) {
-                    meta_store* meta = fig_->get_meta_store();
+                    meta_store* meta = fig_->edit_meta_store();
                     int index = meta->add_meta_data(sel_image_path_, static_cast<void*>(sel_image_ptr_), META_IMAGE);
                     eindex = fig->create_image(selected_, event.m_x, event.m_y, index);
                     edge* e = fig->get_edge(eindex);
@@ -279,7 +279,7 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
             }
             else if (mode_ == M_IMAGE) {
                 if (sel_image_ptr_ != NULL) {
-                    meta_store* meta = fig_->get_meta_store();
+                    meta_store* meta = fig_->edit_meta_store();
                     int index = meta->add_meta_data(sel_image_path_, static_cast<void*>(sel_image_ptr_), META_IMAGE);
                     int eindex = fig_->create_image(fig_->get_root(), x, y - 50, index);
                     edge* e = fig_->get_edge(eindex);
@@ -386,19 +386,7 @@ void MyCanvas::grow()
 void MyCanvas::rotate(double angle)
 {
     std::cout << "Rotate figure." << std::endl;
-
-    figure* rot_fig = new figure(*fig_);    // new instance for rotation
-    std::list<int> nodes;
-    fig_->get_decendants(nodes, fig_->get_root());
-
-    // void rotate_figure(figure* fig_, figure *dst_fig, int origin_node, std::list<int> rot_nodes, double angle)
-    rotate_figure(fig_, rot_fig, fig_->get_root(), nodes, angle);
-    
-    frame_->remove_figure(fig_);
-    delete fig_;
-    fig_ = rot_fig;
-    frame_->add_figure(fig_);
-
+    fig_->rotate(angle);    // in place, about the root
     Refresh();
 }
 
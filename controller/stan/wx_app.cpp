@@ -18,17 +18,21 @@
 #include "wx/wx.h"
 
 #include "wx_frame.h"
+#include "wx_render.h"
 #include "wx_canvas.h"
 #include "animation.h"
 #include "filmstripctrl.h"
 
 BEGIN_EVENT_TABLE(MyFrame, wxFrame)
     EVT_TIMER(TIMER_ID, MyFrame::OnTimer)
+    EVT_TIMER(LOAD_TIMER_ID, MyFrame::OnLoadTimer)
     EVT_MENU(ID_New, MyFrame::OnNew)
     EVT_MENU(ID_Open, MyFrame::OnOpen)
     EVT_MENU(ID_Save, MyFrame::OnSave)
     EVT_MENU(ID_Quit, MyFrame::OnQuit)
     EVT_MENU(ID_About, MyFrame::OnAbout)
+    EVT_MENU(ID_Undo, MyFrame::OnUndo)
+    EVT_MENU(ID_Redo, MyFrame::OnRedo)
     
     // Frame commands
     EVT_MENU(ID_CopyFrame, MyFrame::OnCopyFrame)
@@ -114,7 +118,9 @@ bool MyApp::OnInit()
 
 int MyApp::OnExit()
 {
-    // cleanup
+    // the render caches hold wx objects but are statics, destroyed after
+    // wx has been cleaned up
+    WxRender::clear_caches();
     return 0;
 }
 
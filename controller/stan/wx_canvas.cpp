@@ -14,7 +14,9 @@ BEGIN_EVENT_TABLE(MyCanvas, wxScrolledWindow)
     EVT_MOTION (MyCanvas::OnMouseMove)
     EVT_LEFT_DOWN (MyCanvas::OnLeftDown)
     EVT_LEFT_UP (MyCanvas::OnLeftUp)
+    EVT_RIGHT_DOWN (MyCanvas::OnRightDown)
     EVT_ERASE_BACKGROUND(MyCanvas::OnEraseBackground)
+    EVT_IDLE(MyCanvas::OnIdle)
 END_EVENT_TABLE()
 
 MyCanvas::MyCanvas(wxWindow *parent, wxWindowID winid, const wxPoint& pos, const wxSize& size) :
@@ -26,14 +28,21 @@ MyCanvas::MyCanvas(wxWindow *parent, wxWindowID winid, const wxPoint& pos, const
     grab_fig_(),
     grab_x_(0),
     grab_y_(0),
+    grab_start_x_(0),
+    grab_start_y_(0),
     pivot_nodes_(),
     pivot_point_(),
+    pivot_(NULL),
     selected_(),
+    draw_edge_(-1),
+    edit_(NULL),
+    journal_(),
     selected_frame_(NULL),
     selected_fig_(NULL),
     anim_(NULL),
     animating_(false),
     bg_image_index_(-1),
+    bg_cache_(),
     mode_(M_SELECT),
     sel_color_(),
     sel_image_ptr_(NULL),
@@ -83,20 +92,50 @@ void MyCanvas::OnPaint(wxPaintEvent &WXUNUSED(event))
 
             bg_image_index_ = img_index;
             wxImage* sel_image = static_cast<wxImage*>(md->get_meta_ptr());
-            wxImage scale_image = sel_image->Scale(selected_frame_->get_width(), selected_frame_->get_height());
-            wxBitmap imageBitmap(scale_image);
-            dc.DrawBitmap(imageBitmap, static_cast<wxCoord>(selected_frame_->get_xpos()),
-                          static_cast<wxCoord>(selected_frame_->get_ypos()), true);
+
+            // scaled once per size, not on every paint
+            wxBitmap* bg_bitmap = bg_cache_.get_bitmap(img_index, sel_image,
+                    selected_frame_->get_width(), selected_frame_->get_height());
+            if (bg_bitmap != NULL) {
+                dc.DrawBitmap(*bg_bitmap, static_cast<wxCoord>(selected_frame_->get_xpos()),
+                              static_cast<wxCoord>(selected_frame_->get_ypos()), true);
+            }
+            else if (m_owner->get_asset_loader().is_loading(md->get_path())) {
+                // placeholder until the background is decoded
+                dc.SetPen(wxPen(wxColor(136, 136, 136), 1, wxSHORT_DASH));
+                dc.SetBrush(wxBrush(wxColor(232, 232, 232), wxSOLID));
+                dc.DrawRectangle(static_cast<wxCoord>(selected_frame_->get_xpos()),
+                                 static_cast<wxCoord>(selected_frame_->get_ypos()),
+                                 selected_frame_->get_width(), selected_frame_->get_height());
+                dc.DrawText(wxT("Loading..."), static_cast<wxCoord>(selected_frame_->get_xpos()) + 10,
+                            static_cast<wxCoord>(selected_frame_->get_ypos()) + 10);
+            }
         }
 
         //
         // render the figures
         //
 
+        // damaged part of the canvas in logical coordinates, everything
+        // outside of it is clipped away by the paint DC. Mapped through the
+        // DC itself so that any origin or scale set up above is honoured.
+        wxRect box = GetUpdateRegion().GetBox();
+        wxRect view(wxPoint(dc.DeviceToLogicalX(box.GetLeft()), dc.DeviceToLogicalY(box.GetTop())),
+                    wxPoint(dc.DeviceToLogicalX(box.GetRight()), dc.DeviceToLogicalY(box.GetBottom())));
+
         BOOST_FOREACH(figure* f, selected_frame_->get_figures()) {
             wxRect rc;
             rc.SetX(selected_frame_->get_xpos());
             rc.SetY(selected_frame_->get_ypos());
+
+            // skip figures which do not touch the damaged area
+            wxRect bounds;
+            WxRender::get_bounding_rect(f, bounds);
+            bounds.Offset(rc.GetX(), rc.GetY());
+            if (!view.Intersects(bounds)) {
+                continue;
+            }
+
             WxRender::render_figure(f, dc, rc, !animating_);
             if (in_pivot_) {  // if pivoting, color pivot nodes
                 dc.SetPen( wxPen(wxT("blue"), 5, wxSOLID));
@@ -120,6 +159,16 @@ void MyCanvas::OnEraseBackground(wxEraseEvent& WXUNUSED(event))
 {
 }
 
+void MyCanvas::OnIdle(wxIdleEvent& WXUNUSED(event))
+{
+    // a burst of motion events during a pivot drag costs one rotation
+    if (in_pivot_ && pivot_->is_pending()) {
+        RefreshRect(get_damage_rect(pivot_fig_), false);
+        pivot_->apply();
+        RefreshRect(get_damage_rect(pivot_fig_), false);
+    }
+}
+
 void MyCanvas::OnMouseMove(wxMouseEvent &event)
 {
     wxClientDC dc(this);
@@ -133,30 +182,30 @@ void MyCanvas::OnMouseMove(wxMouseEvent &event)
     // we have grabbed something
     if (in_grab_) {
         if (grab_fig_ != NULL) {
+            // repaint where the figure was and where it is now
+            RefreshRect(get_damage_rect(grab_fig_), false);
             grab_fig_->move(x - grab_x_, y - grab_y_);
             grab_x_ = x;
             grab_y_= y;
 
-            Refresh();
+            RefreshRect(get_damage_rect(grab_fig_), false);
         }
         else {
             std::cout << "Error: grab active with NULL figure." << std::endl;
         }
     }
     else if (in_pivot_) {
-        // calculate angle between pivot and mouse
-        node* sn = selected_fig_->get_node(selected_);
+        // calculate angle between pivot and mouse, the rotation itself is
+        // done once the queued mouse events are handled (see OnIdle)
         node* pn = pivot_fig_->get_node(pivot_point_);
 
         Point pt_ms(x, y);
-        Point pt_sel(sn->get_x(), sn->get_y());
+        Point pt_sel(pivot_->get_base_x(), pivot_->get_base_y());
         Point pt_piv(pn->get_x(), pn->get_y());
-        double theta = calc_angle(pt_piv, pt_sel, pt_ms);
-        rotate_figure(selected_fig_, pivot_fig_, pivot_point_, pivot_nodes_, theta);
-
-        Refresh();
+        pivot_->set_angle(calc_angle(pt_piv, pt_sel, pt_ms));
     }
     else if (in_draw_) {
+        RefreshRect(get_damage_rect(selected_fig_), false);
         node* sn = selected_fig_->get_node(selected_);
         if (in_stretch_) {
             // decendants move along with selected node
@@ -168,8 +217,36 @@ void MyCanvas::OnMouseMove(wxMouseEvent &event)
             }
         }
         sn->move_to(x, y);
-        Refresh();
+        RefreshRect(get_damage_rect(selected_fig_), false);
+    }
+}
+
+meta_store* MyCanvas::edit_meta_store(figure* fig)
+{
+    bool shared = fig->is_meta_store_shared();
+    meta_store* meta = fig->edit_meta_store();
+    if (shared) {
+        m_owner->get_asset_loader().request(fig->get_shared_meta_store(), WxAssetLoader::PRIORITY_VISIBLE);
     }
+    return meta;
+}
+
+wxRect MyCanvas::get_damage_rect(figure* fig)
+{
+    wxRect rc;
+    WxRender::get_bounding_rect(fig, rc);
+
+    // figures are drawn relative to the frame, include the selection box
+    rc.Offset(selected_frame_->get_xpos(), selected_frame_->get_ypos());
+    rc.Inflate(1, 1);
+
+    // the same transform OnPaint() draws with, scroll position, origin
+    // and scale alike
+    wxClientDC dc(this);
+    PrepareDC(dc);
+    m_owner->PrepareDC(dc);
+    return wxRect(wxPoint(dc.LogicalToDeviceX(rc.GetLeft()), dc.LogicalToDeviceY(rc.GetTop())),
+                  wxPoint(dc.LogicalToDeviceX(rc.GetRight()), dc.LogicalToDeviceY(rc.GetBottom())));
 }
 
 void MyCanvas::OnLeftDown(wxMouseEvent &event)
@@ -192,24 +269,26 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
                     selected_fig_ = fig;             // original figure
                     grab_x_ = event.m_x;
                     grab_y_ = event.m_y;
+                    grab_start_x_ = event.m_x;
+                    grab_start_y_ = event.m_y;
 
                     Refresh();  // new figure may have been selected
                 }
                 else {
                     in_pivot_ = true;
 
-                    pivot_fig_ = new figure(*fig);    // new instance for rotation
-                    pivot_nodes_.clear();
-                    pivot_nodes_.push_back(selected_);   // include this node
-
-                    node *sn = pivot_fig_->get_node(selected_);
-                    pivot_point_ = sn->get_parent(); // we pivot around the selected node's parent
-
                     selected_fig_ = fig;             // original figure
                     pivot_fig_ = new figure(*selected_fig_);    // new instance for rotation
-                    pivot_fig_->get_decendants(pivot_nodes_, selected_);
+
+                    // the selected node and its decendants, in their base pose
+                    pivot_ = new pivot_session(pivot_fig_, selected_);
+                    pivot_point_ = pivot_->get_pivot(); // we pivot around the selected node's parent
+                    pivot_nodes_.assign(pivot_->get_nodes().begin(), pivot_->get_nodes().end());
+                    edit_ = new position_command(selected_fig_, pivot_nodes_);
+
+                    // the working copy is drawn on top, the original keeps its
+                    // place and gets the final pose when the node is dropped
                     selected_frame_->add_figure(pivot_fig_);
-                    selected_frame_->move_to_back(selected_fig_);   // lowest z-order
                     selected_fig_->set_enabled(false);
                     pivot_fig_->set_enabled(true);
 
@@ -226,6 +305,7 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
                 selected_fig_ = fig;
 
                 int eindex;
+                draw_edge_ = -1;
                 int color = get_int_color();
                 wxColour wx_color;
                 WxRender::set_wx_color(color, wx_color);
@@ -235,12 +315,14 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
                     edge* e = fig->get_edge(eindex);
                     e->set_color(color);
                     selected_ = e->get_n2(); // save the index of the new node
+                    draw_edge_ = eindex;
                 }
                 else if (mode_ == M_CIRCLE) {
                     eindex = fig->create_circle(selected_, event.m_x, event.m_y);
                     edge* e = fig->get_edge(eindex);
                     e->set_color(color);
                     selected_ = e->get_n2(); // save the index of the new node
+                    draw_edge_ = eindex;
                 }
                 else if (mode_ == M_SIZE) {
                     if (event.ControlDown()) {
@@ -250,14 +332,22 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
                         fig->get_decendants(pivot_nodes_, selected_);
                         in_stretch_ = true;
                     }
+
+                    std::list<int> moved;
+                    if (in_stretch_) {
+                        moved = pivot_nodes_;
+                    }
+                    moved.push_back(selected_);
+                    edit_ = new position_command(fig, moved);
                 }
                 else if (mode_ == M_IMAGE) {
                     if (sel_image_ptr_ != NULL) {
-                        meta_store* meta = selected_fig_->get_meta_store();
+                        meta_store* meta = edit_meta_store(selected_fig_);
                         int index = meta->add_meta_data(sel_image_path_, static_cast<void*>(sel_image_ptr_), META_IMAGE);
                         eindex = fig->create_image(selected_, event.m_x, event.m_y, index);
                         edge* e = fig->get_edge(eindex);
                         selected_ = e->get_n2(); // save the index of the new node
+                        draw_edge_ = eindex;
                     }
                     else {
                         std::cout << "No image selected." << std::endl;
@@ -272,7 +362,8 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
             else if (mode_ == M_BREAK) {
                 std::cout << "Break operation" << std::endl;
                 if (!fig->is_root_node(selected_)) {
-                    selected_frame_->break_figure(fig, selected_);
+                    figure* nfig = selected_frame_->break_figure(fig, selected_);
+                    journal_.record(new add_figure_command(selected_frame_, nfig));
                     Refresh();
                 }
             }
@@ -283,7 +374,10 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
             else if (mode_ == M_CUT) {
                 std::cout << "Cut operation" << std::endl;
                 if (!fig->is_root_node(selected_)) {
-                    fig->remove_children(selected_);
+                    // leaves empty node slots rather than renumbering the whole
+                    // figure (compacted when the animation is saved), so the
+                    // cut can be undone into the same slots
+                    journal_.execute(new cut_command(fig, selected_));
                     Refresh();
                 }
             }
@@ -299,6 +393,7 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
                 double y = static_cast<double>(event.m_y);
                 selected_fig_ = new figure(x, y);
                 selected_frame_->add_figure(selected_fig_);
+                journal_.record(new add_figure_command(selected_frame_, selected_fig_));
 
                 if (mode_ == M_LINE) {
                     selected_fig_->create_line(selected_fig_->get_root(), x, y + 20);
@@ -310,7 +405,7 @@ void MyCanvas::OnLeftDown(wxMouseEvent &event)
                 }
                 else if (mode_ == M_IMAGE) {
                     if (sel_image_ptr_ != NULL) {
-                        meta_store* meta = selected_fig_->get_meta_store();
+                        meta_store* meta = edit_meta_store(selected_fig_);
                         int index = meta->add_meta_data(sel_image_path_, static_cast<void*>(sel_image_ptr_), META_IMAGE);
                         int eindex = selected_fig_->create_image(selected_fig_->get_root(), x, y - 50, index);
                         edge* e = selected_fig_->get_edge(eindex);
@@ -329,28 +424,97 @@ void MyCanvas::OnLeftUp(wxMouseEvent &event)
     {
         std::cout << "Dropped figure at: " << event.m_x << ", " << event.m_y << std::endl;
         in_grab_ = false;
+
+        int dx = grab_x_ - grab_start_x_;
+        int dy = grab_y_ - grab_start_y_;
+        if ( (grab_fig_ != NULL) && ((dx != 0) || (dy != 0)) ) {
+            journal_.record(new move_command(grab_fig_, dx, dy));
+        }
     }
     if (in_pivot_)
     {
         in_pivot_ = false;
-        selected_frame_->remove_figure(selected_fig_);
-        delete selected_fig_;
-        selected_fig_ = pivot_fig_;
+        pivot_->apply();    // the last angle may still be pending
+        delete pivot_;
+        pivot_ = NULL;
+
+        // the figure keeps its identity (and z-order), only the pivoted
+        // nodes get the new positions
+        copy_positions(pivot_fig_, selected_fig_, pivot_nodes_);
+        selected_fig_->set_enabled(true);
+        selected_frame_->remove_figure(pivot_fig_);
+        delete pivot_fig_;
+        pivot_fig_ = NULL;
 
         Refresh();
     }
     
     if (in_draw_) {
         in_draw_ = false;
+
+        // recorded once the new node has been dragged to its place
+        if (draw_edge_ != -1) {
+            journal_.record(new create_command(selected_fig_, draw_edge_));
+            draw_edge_ = -1;
+        }
     }
 
     if (in_stretch_) {
         in_stretch_ = false;
     }
+
+    if (edit_ != NULL) {
+        if (edit_->commit()) {
+            journal_.record(edit_);
+        }
+        else {
+            delete edit_;
+        }
+        edit_ = NULL;
+    }
+}
+
+void MyCanvas::copy_positions(figure* src, figure* dst, const std::list<int>& nodes)
+{
+    BOOST_FOREACH(int n, nodes) {
+        node* sn = src->get_node(n);
+        dst->get_node(n)->move_to(sn->get_x(), sn->get_y());
+    }
+}
+
+bool MyCanvas::undo()
+{
+    if (!journal_.undo()) {
+        return false;
+    }
+
+    // the selected figure may just have been taken out of the frame
+    if (selected_frame_ != NULL) {
+        selected_fig_ = selected_frame_->get_first_figure();
+    }
+    Refresh();
+    return true;
+}
+
+bool MyCanvas::redo()
+{
+    if (!journal_.redo()) {
+        return false;
+    }
+
+    if (selected_frame_ != NULL) {
+        selected_fig_ = selected_frame_->get_first_figure();
+    }
+    Refresh();
+    return true;
 }
 
 void MyCanvas::OnRightDown(wxMouseEvent &event)
 {
+    if (selected_frame_ == NULL) {
+        return;
+    }
+
     figure* fig;
     if (selected_frame_->get_figure_at_pos(event.m_x, event.m_y, 8, fig, selected_)) {
         std::cout << "Right clicked on a figure." << std::endl;
@@ -363,7 +527,11 @@ void MyCanvas::OnRightDown(wxMouseEvent &event)
         edge* e = fig->find_edge(n1, selected_);
         if (e != NULL) {
             std::cout << "Found the edge." << std::endl;
-            // TODO: e->set_color(sel_color_);
+            int color = get_int_color();
+            if (e->get_color() != color) {
+                journal_.execute(new color_command(fig, fig->get_edge(n1, selected_), e->get_color(), color));
+                Refresh();
+            }
         }
     }
 }
@@ -404,7 +572,9 @@ void MyCanvas::set_image(std::string& path)
 void MyCanvas::shrink()
 {
     std::cout << "Shrink figure." << std::endl;
-    selected_fig_->scale(.8);
+    if (selected_fig_ != NULL) {
+        journal_.execute(new scale_command(selected_fig_, .8));
+    }
 
     Refresh();
 }
@@ -412,7 +582,9 @@ void MyCanvas::shrink()
 void MyCanvas::grow()
 {
     std::cout << "Grow figure." << std::endl;
-    selected_fig_->scale(1.2);
+    if (selected_fig_ != NULL) {
+        journal_.execute(new scale_command(selected_fig_, 1.2));
+    }
     Refresh();
 }
 
@@ -420,17 +592,11 @@ void MyCanvas::rotate(double angle)
 {
     std::cout << "Rotate figure." << std::endl;
 
-    figure* rot_fig = new figure(*selected_fig_);    // new instance for rotation
-    std::list<int> nodes;
-    selected_fig_->get_decendants(nodes, selected_fig_->get_root());
-
-    // void rotate_figure(figure* fig_, figure *dst_fig, int origin_node, std::list<int> rot_nodes, double angle)
-    rotate_figure(selected_fig_, rot_fig, selected_fig_->get_root(), nodes, angle);
-    
-    selected_frame_->remove_figure(selected_fig_);
-    delete selected_fig_;
-    selected_fig_ = rot_fig;
-    selected_frame_->add_figure(selected_fig_);
+    // in place about the root, the figure keeps its place in the frame;
+    // the history only keeps the angle
+    if (selected_fig_ != NULL) {
+        journal_.execute(new rotate_command(selected_fig_, angle));
+    }
 
     Refresh();
 }
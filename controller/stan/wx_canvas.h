@@ -9,13 +9,16 @@
 #include <wx/wx.h>
 #include "animation.h"
 #include "wx_frame.h"
+#include "wx_bg_cache.h"
+#include "edit_journal.h"
+#include "pivot_session.h"
 
 using namespace stan;
 
 typedef struct
 {
     frame* fr_;
-    figure* fig_;
+    figure* fig_;   // a copy owned by the clipboard
 } clipboard;
 
 // define a scrollable canvas for drawing onto
@@ -25,12 +28,15 @@ public:
     MyCanvas(wxWindow *parent, wxWindowID winid = wxID_ANY,
         const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxDefaultSize);
 
+    virtual ~MyCanvas() { set_clip(NULL); }
+
     void OnPaint(wxPaintEvent &event);
     void OnEraseBackground(wxEraseEvent& event);
     void OnMouseMove(wxMouseEvent &event);
     void OnLeftDown(wxMouseEvent &event);
     void OnLeftUp(wxMouseEvent &event);
     void OnRightDown(wxMouseEvent &event);
+    void OnIdle(wxIdleEvent& event);
 
     // set or remove the clipping region
     void Clip(bool clip) { m_clip = clip; Refresh(); }
@@ -62,7 +68,9 @@ public:
     void set_animation(animation* anim)
     {
         anim_ = anim;
-        clip_.fig_ = NULL;
+        set_clip(NULL);
+        bg_cache_.clear();  // cached by meta index of the old animation
+        journal_.clear();   // refers to figures of the old animation
     }
 
     frame* get_frame() { return selected_frame_; }
@@ -70,7 +78,7 @@ public:
     void add_figure(figure* fig)
     {
         if (selected_frame_ != NULL) {
-            selected_frame_->add_figure(fig);
+            journal_.execute(new add_figure_command(selected_frame_, fig));
             Refresh();
         }
         else {
@@ -81,8 +89,8 @@ public:
     void cut_figure()
     {
         if (selected_fig_ != NULL && selected_frame_ != NULL) {
-            clip_.fig_ = selected_fig_;
-            selected_frame_->remove_figure(selected_fig_);
+            set_clip(new figure(*selected_fig_));
+            journal_.execute(new remove_figure_command(selected_frame_, selected_fig_));
             selected_fig_ = selected_frame_->get_first_figure();
             Refresh();
         }
@@ -91,7 +99,7 @@ public:
     void copy_figure()
     {
         if (selected_fig_ != NULL) {
-            clip_.fig_ = selected_fig_;
+            set_clip(new figure(*selected_fig_));
         }
     }
 
@@ -112,6 +120,17 @@ public:
 
     figure* get_clip_figure() { return clip_.fig_; }
 
+    /**
+     * Replace the clipboard contents (owned by the clipboard from now on).
+     * The clipboard keeps a copy rather than the figure itself, which
+     * undo may delete (see add_figure_command).
+     */
+    void set_clip(figure* fig)
+    {
+        delete clip_.fig_;
+        clip_.fig_ = fig;
+    }
+
     void set_animating(bool an)
     {
         animating_ = an;
@@ -119,6 +138,20 @@ public:
     }
 
     void play_frame_audio();
+
+    /**
+     * Undo / redo the last figure edit.
+     * @return false if there was nothing to undo / redo
+     */
+    bool undo();
+    bool redo();
+
+    /**
+     * Forget the edit history, e.g. before frames are deleted.
+     */
+    void clear_history() { journal_.clear(); }
+
+    const edit_journal& get_history() const { return journal_; }
 
     /*****************************************************************
      * Figure operations
@@ -180,6 +213,24 @@ public:
     }
 
 private:
+    /**
+     * Get the area a figure of the selected frame covers on screen, in
+     * device coordinates (suitable for RefreshRect()).
+     */
+    wxRect get_damage_rect(figure* fig);
+
+    /**
+     * Get the meta store of a figure for modification. A private copy made
+     * on write is new to the asset loader, so it is requested to have the
+     * entries still loading filled in.
+     */
+    meta_store* edit_meta_store(figure* fig);
+
+    /**
+     * Copy node positions from a working copy back into the figure.
+     */
+    void copy_positions(figure* src, figure* dst, const std::list<int>& nodes);
+
     MyFrame *m_owner;
     bool m_clip;
     bool in_grab_;
@@ -191,13 +242,20 @@ private:
     figure* selected_fig_;     // a figure in pivot operation (a rotation from selected)
     int grab_x_;
     int grab_y_;
+    int grab_start_x_;      // where the grab began, for the undo delta
+    int grab_start_y_;
     std::list<int> pivot_nodes_;    // list of nodes which need to rotate
     int pivot_point_;       // the node we are pivoting about
+    pivot_session* pivot_;  // the pivot drag in progress
     int selected_;          // the node that was grabbed
+    int draw_edge_;         // edge created by the draw in progress, -1 if none
+    position_command* edit_;    // node positions before a pivot / size drag
+    edit_journal journal_;  // undo / redo history
     frame* selected_frame_;
     animation* anim_;
     bool animating_;        // true when animating (don't show nodes)
     int bg_image_index_;    // background image index when animating
+    WxBackgroundCache bg_cache_;    // backgrounds scaled to the frame size
     clipboard clip_;
     Mode mode_;             // selection, line, circle, ...
     wxColour sel_color_;
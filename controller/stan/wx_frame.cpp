@@ -13,6 +13,7 @@
 #include "wx_canvas.h"
 #include "wx_render.h"
 #include "animation.h"
+#include "archive_io.h"
 #include "thumbnaildlg.h"
 #include "filmstripctrl.h"
 
@@ -45,7 +46,10 @@ MyFrame::MyFrame(const wxString& title, const wxPoint& pos, const wxSize& size,
     data_path_(data_path),
     path_(path),
     anim_(NULL),
+    indexed_writer_(),
+    asset_loader_(WxRender::get_asset_cache()),
     timer_(this, TIMER_ID),
+    load_timer_(this, LOAD_TIMER_ID),
     image_()
 {
     // File menu
@@ -57,6 +61,11 @@ MyFrame::MyFrame(const wxString& title, const wxPoint& pos, const wxSize& size,
     menuFile->AppendSeparator();
     menuFile->Append( ID_Quit, _T("E&xit") );
 
+    // Edit menu
+    wxMenu* menuEdit = new wxMenu;
+    menuEdit->Append( ID_Undo, _T("&Undo\tCtrl+Z") );
+    menuEdit->Append( ID_Redo, _T("&Redo\tCtrl+Y") );
+
     // Frame menu
     wxMenu *menuFrame = new wxMenu;
     menuFrame->Append( ID_CutFrame, _T("Cut\tCtrl+X") );
@@ -84,6 +93,7 @@ MyFrame::MyFrame(const wxString& title, const wxPoint& pos, const wxSize& size,
 
     wxMenuBar *menuBar = new wxMenuBar;
     menuBar->Append( menuFile, _T("&File") );
+    menuBar->Append( menuEdit, _T("&Edit") );
     menuBar->Append( menuFrame, _T("F&rame") );
     menuBar->Append( menuFig, _T("F&igure") );
     SetMenuBar( menuBar );
@@ -225,24 +235,17 @@ bool MyFrame::LoadAnimation(char *path)
     std::cout << "Loading animation from: " << path << std::endl;
 
     bool ret = false;
+
+    // pending loads refer to the meta stores of the old animation
+    load_timer_.Stop();
+    asset_loader_.cancel();
     if (anim_ != NULL) {
         delete anim_;
     }
-    anim_ = NULL;
-
-	std::ifstream ifs(path);
-	if (ifs.good())	{
-		boost::archive::xml_iarchive ia(ifs);
-        ia >> boost::serialization::make_nvp("animation", anim_);
-        if (anim_ == NULL) {
-            std::cerr << "Error loading " << path << std::endl;
-            return false;
-        }
-        
-        // create the image cache
-        meta_store* meta = anim_->get_meta_store();
-        WxRender::init_meta_cache(meta);
+    indexed_writer_.reset();
 
+    anim_ = load_animation(path);
+	if (anim_ != NULL) {
         m_canvas->set_animation(anim_);
         m_canvas->set_frame(anim_->get_first_frame());
 
@@ -253,42 +256,66 @@ bool MyFrame::LoadAnimation(char *path)
 		frameBrowser_->SetUnselectedFilmstripBackgroundColour(*wxWHITE);
 		frameBrowser_->SetSelectedFilmstripBackgroundColour(*wxWHITE, *wxWHITE);
 
-        // create the browser objects
+        // the first frame is shown right away, decode its assets first
+        if (anim_->get_first_frame() != NULL) {
+            request_frame_assets(anim_->get_first_frame(), WxAssetLoader::PRIORITY_VISIBLE);
+        }
+
+        // create the browser objects, everything else loads in the
+        // background and is drawn as a placeholder until it is ready
 		std::list<frame*> frames = anim_->get_frames();
 		BOOST_FOREACH(frame* fr, frames) {
 			frameBrowser_->Append(new wxStanFilmstripItem(fr));
-            // for each frame, load the image cache for each figure
-       		BOOST_FOREACH(figure* f, fr->get_figures()) {
-               meta_store* meta = f->get_meta_store();
-               WxRender::init_meta_cache(meta);
-            }
+            request_frame_assets(fr, WxAssetLoader::PRIORITY_BACKGROUND);
         }
+        asset_loader_.request(anim_->get_meta_store(), WxAssetLoader::PRIORITY_BACKGROUND);
 
 		frameBrowser_->Select(0);
 		frameBrowser_->Thaw();
+        load_timer_.Start(50);
         ret = true;
 	}
-    else {
-        std::cout << "Unable to open file:" << path << std::endl;
-    }
-    ifs.close();
 
     return ret;
 }
 
-bool MyFrame::SaveAnimation(char* path)
+void MyFrame::request_frame_assets(frame* fr, int priority)
+{
+    meta_store* meta = anim_->get_meta_store();
+    asset_loader_.request(meta, fr->get_image_index(), priority);
+    asset_loader_.request(meta, fr->get_sound_index(), priority);
+    BOOST_FOREACH(figure* f, fr->get_figures()) {
+        asset_loader_.request(f->get_shared_meta_store(), priority);
+    }
+}
+
+void MyFrame::OnLoadTimer(wxTimerEvent& event)
+{
+    if ( (anim_ == NULL) || (asset_loader_.poll() == 0) ) {
+        return;
+    }
+
+    // only the stores which requested the assets just loaded
+    asset_loader_.attach_ready();
+    m_canvas->Refresh();
+    frameBrowser_->Refresh();
+
+    if (asset_loader_.get_pending() == 0) {
+        load_timer_.Stop();
+        WxRender::get_asset_cache().report(std::cout);
+    }
+}
+
+bool MyFrame::SaveAnimation(char* path, archive_format format)
 {
     std::cout << "Saving animation to: " << path << std::endl;
 
+    // figures the undo history refers to keep their node slots
     if (anim_ != NULL) {
-        std::ofstream ofs(path);
-        assert(ofs.good());
-        {
-            boost::archive::xml_oarchive oa(ofs);
-            oa << boost::serialization::make_nvp("animation", anim_);
-
+        if (format == ARCHIVE_INDEXED) {
+            return indexed_writer_.save(anim_, path, &m_canvas->get_history());
         }
-        ofs.close();
+        return save_animation(anim_, path, format, &m_canvas->get_history());
     }
     return true;
 }
@@ -298,17 +325,9 @@ bool MyFrame::LoadFigure(char *path)
     std::cout << "Loading figure from: " << path << std::endl;
 
     bool ret = false;
-    figure* fig;
-	std::ifstream ifs(path);
-	if (ifs.good())
+    figure* fig = load_figure(path);
+	if (fig != NULL)
 	{
-		boost::archive::xml_iarchive ia(ifs);
-        ia >> boost::serialization::make_nvp("figure", fig);
-        if (fig == NULL) {
-            std::cerr << "Error loading " << path << std::endl;
-            return false;
-        }
-
         // create the image cache
         meta_store* meta = fig->get_meta_store();
         WxRender::init_meta_cache(meta);
@@ -316,7 +335,6 @@ bool MyFrame::LoadFigure(char *path)
         m_canvas->add_figure(fig);
         ret = true;
 	}
-    ifs.close();
 
     return ret;
 }
@@ -328,15 +346,7 @@ bool MyFrame::SaveFigure(char* path)
     figure* fig = m_canvas->get_figure();
     if (fig != NULL) {
 		std::cout << *fig << std::endl;
-
-        std::ofstream ofs(path);
-        assert(ofs.good());
-        {
-            boost::archive::xml_oarchive oa(ofs);
-            oa << boost::serialization::make_nvp("figure", fig);
-
-        }
-        ofs.close();
+        return save_figure(fig, path, ARCHIVE_XML, &m_canvas->get_history());
     }
     return true;
 }
@@ -363,7 +373,7 @@ void MyFrame::OnOpen(wxCommandEvent& WXUNUSED(event))
     char path[200];
     sprintf_s(path, 200, "%s\\animations", data_path_.c_str());
     wxString caption = wxT("Choose a file");
-    wxString wildcard = wxT("ANI files (*.ani)|*.ani|XML files (*.xml)|*.xml");
+    wxString wildcard = wxT("ANI files (*.ani;*.anb;*.anx;*.anp)|*.ani;*.anb;*.anx;*.anp|XML files (*.xml)|*.xml");
     wxString defaultDir = wxT(path);
     wxString defaultFilename = wxEmptyString;
     wxFileDialog dialog(this, caption, defaultDir, defaultFilename, wildcard, wxOPEN);
@@ -382,7 +392,7 @@ void MyFrame::OnOpen(wxCommandEvent& WXUNUSED(event))
 void MyFrame::OnSave(wxCommandEvent& WXUNUSED(event))
 {
     wxString caption = wxT("Save as ?");
-    wxString wildcard = wxT("ANI files (*.ani)|*.ani|XML files (*.xml)|*.xml");
+    wxString wildcard = wxT("ANI files (*.ani)|*.ani|XML files (*.xml)|*.xml|Binary ANI files (*.anb)|*.anb|Indexed ANI files (*.anx)|*.anx|Packed ANI files (*.anp)|*.anp");
     wxString defaultDir = wxT(".");
     wxString defaultFilename = wxEmptyString;
     wxFileDialog dialog(this, caption, defaultDir, defaultFilename, wildcard, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
@@ -392,7 +402,19 @@ void MyFrame::OnSave(wxCommandEvent& WXUNUSED(event))
 
         char path[100];
         strcpy_s( path, 100, (const char*)wx_path.mb_str(wxConvUTF8) );
-        SaveAnimation(path);
+
+        // the format is detected when loading, only saving has to choose
+        archive_format format = ARCHIVE_XML;
+        if (dialog.GetFilterIndex() == 2) {
+            format = ARCHIVE_BINARY;
+        }
+        else if (dialog.GetFilterIndex() == 3) {
+            format = ARCHIVE_INDEXED;
+        }
+        else if (dialog.GetFilterIndex() == 4) {
+            format = ARCHIVE_PACKED;
+        }
+        SaveAnimation(path, format);
 
         m_canvas->Refresh();
     }
@@ -407,6 +429,11 @@ frame* MyFrame::select_frame(int index)
         frameBrowser_->Select(index);
         wxStanFilmstripItem* item = static_cast<wxStanFilmstripItem*>(frameBrowser_->GetItem(index));
         fr = item->get_frame();
+
+        // still loading, move the assets of this frame to the front
+        if (asset_loader_.get_pending() > 0) {
+            request_frame_assets(fr, WxAssetLoader::PRIORITY_VISIBLE);
+        }
     }
     m_canvas->set_frame(fr);
 
@@ -476,6 +503,7 @@ void MyFrame::OnCutFrame(wxCommandEvent& WXUNUSED(event))
         wxStanFilmstripItem* item = static_cast<wxStanFilmstripItem*>(frameBrowser_->GetItem(sel));
         frame* fr = item->get_frame();
         
+        m_canvas->clear_history();  // may refer to figures of the frame
         anim_->del_frame(fr);
         frameBrowser_->Delete(sel);
 
@@ -617,6 +645,20 @@ void MyFrame::OnPaste(wxCommandEvent& WXUNUSED(event))
     m_canvas->paste_figure();
 }
 
+void MyFrame::OnUndo(wxCommandEvent& WXUNUSED(event))
+{
+    if (m_canvas->undo()) {
+        frameBrowser_->Refresh();
+    }
+}
+
+void MyFrame::OnRedo(wxCommandEvent& WXUNUSED(event))
+{
+    if (m_canvas->redo()) {
+        frameBrowser_->Refresh();
+    }
+}
+
 void MyFrame::OnPasteAll(wxCommandEvent& WXUNUSED(event))
 {
     std::cout << "Paste All" << std::endl;
@@ -10,6 +10,9 @@
 #include <wx/wx.h>
 
 #include "animation.h"
+#include "archive_io.h"
+#include "indexed_animation.h"
+#include "wx_asset_loader.h"
 
 using namespace stan;
 
@@ -38,6 +41,8 @@ public:
     void OnCopy(wxCommandEvent& event);
     void OnPaste(wxCommandEvent& event);
     void OnPasteAll(wxCommandEvent& event);
+    void OnUndo(wxCommandEvent& event);
+    void OnRedo(wxCommandEvent& event);
 
     void OnNextFrame(wxCommandEvent& event);
     void OnPrevFrame(wxCommandEvent& event);
@@ -51,6 +56,7 @@ public:
     void OnSelectSound(wxCommandEvent& event);
     void OnThumbNailSelected(wxFilmstripEvent& event);
     void OnTimer(wxTimerEvent& event);
+    void OnLoadTimer(wxTimerEvent& event);
 
     /**
      * Figure commands
@@ -86,7 +92,7 @@ public:
     void OnRotateCCW(wxCommandEvent& event);
 
     bool LoadAnimation(char* path);
-    bool SaveAnimation(char* path);
+    bool SaveAnimation(char* path, archive_format format = ARCHIVE_XML);
     bool LoadFigure(char* path);
     bool SaveFigure(char* path);
 
@@ -95,6 +101,11 @@ public:
      */
     void set_status(const char* str);
 
+    /**
+     * Loads the images and sounds of the animation in the background.
+     */
+    WxAssetLoader& get_asset_loader() { return asset_loader_; }
+
     MyCanvas* m_canvas;
     wxToolBar* m_toolbar;
     wxFilmstripCtrl* frameBrowser_;
@@ -113,16 +124,26 @@ private:
     frame* prev_frame();
     int get_sel_frame();
 
+    /**
+     * Queue the assets used by a frame (background, sound and figure
+     * images) for loading.
+     */
+    void request_frame_assets(frame* fr, int priority);
+
 
     wxStaticText* color_display_;
     std::string path_;
     animation* anim_;
+    indexed_writer indexed_writer_;     // repeated indexed saves only append changed frames
+    WxAssetLoader asset_loader_;
     wxTimer timer_;
+    wxTimer load_timer_;                // polls asset_loader_ while assets are loading
     wxImage image_;
     std::string data_path_;
 };
 
 const int TIMER_ID = 1000;
+const int LOAD_TIMER_ID = 1001;
 
 enum {
     ID_Quit= 1,
@@ -168,6 +189,8 @@ enum {
     ID_FrameTools,
     ID_FigureTools,
     ID_FRAME_THUMB,
+    ID_Undo,
+    ID_Redo,
 };
 
 #endif  // _WX_FRAME_H
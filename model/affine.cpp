@@ -0,0 +1,68 @@
+/**
+ * @file affine.cpp
+ * @brief Batch point transforms.
+ * @date 10-18-26
+ */
+
+#include "affine.h"
+
+// SSE2 is always there on x64, on x86 only when asked for (/arch:SSE2)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STAN_SSE2       1
+#include <emmintrin.h>
+#endif
+
+namespace stan {
+
+void translate_points(double* x, double* y, unsigned count, double dx, double dy)
+{
+    unsigned n = 0;
+#ifdef STAN_SSE2
+    __m128d vdx = _mm_set1_pd(dx);
+    __m128d vdy = _mm_set1_pd(dy);
+    for (; n + 2 <= count; n += 2) {
+        _mm_storeu_pd(x + n, _mm_add_pd(_mm_loadu_pd(x + n), vdx));
+        _mm_storeu_pd(y + n, _mm_add_pd(_mm_loadu_pd(y + n), vdy));
+    }
+#endif
+    for (; n < count; n++) {
+        x[n] += dx;
+        y[n] += dy;
+    }
+}
+
+void scale_points(double* x, double* y, unsigned count, double factor, double ox, double oy)
+{
+    transform_points(x, y, count, affine::scaling(factor, ox, oy));
+}
+
+void rotate_points(double* x, double* y, unsigned count, double angle, double ox, double oy)
+{
+    transform_points(x, y, count, affine::rotation(angle, ox, oy));
+}
+
+void transform_points(double* x, double* y, unsigned count, const affine& m)
+{
+    unsigned n = 0;
+#ifdef STAN_SSE2
+    __m128d a = _mm_set1_pd(m.a_);
+    __m128d b = _mm_set1_pd(m.b_);
+    __m128d c = _mm_set1_pd(m.c_);
+    __m128d d = _mm_set1_pd(m.d_);
+    __m128d ox = _mm_set1_pd(m.ox_);
+    __m128d oy = _mm_set1_pd(m.oy_);
+    __m128d tx = _mm_set1_pd(m.tx_);
+    __m128d ty = _mm_set1_pd(m.ty_);
+    for (; n + 2 <= count; n += 2) {
+        __m128d px = _mm_sub_pd(_mm_loadu_pd(x + n), ox);
+        __m128d py = _mm_sub_pd(_mm_loadu_pd(y + n), oy);
+        _mm_storeu_pd(x + n, _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, px), _mm_mul_pd(b, py)), tx));
+        _mm_storeu_pd(y + n, _mm_add_pd(_mm_add_pd(_mm_mul_pd(c, px), _mm_mul_pd(d, py)), ty));
+    }
+#endif
+    m.apply(x + n, y + n, count - n);     // the rest, or all without SSE2
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,208 @@
+/**
+ * @file archive_io.cpp
+ * @brief Implementation of archive loading and saving.
+ * @date 10-18-26
+ */
+
+#include <fstream>
+#include <cstring>
+#include <set>
+
+#include <boost/archive/xml_iarchive.hpp>
+#include <boost/archive/xml_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include "archive_io.h"
+#include "indexed_animation.h"
+#include "packed_animation.h"
+#include "edit_journal.h"
+
+namespace stan {
+
+namespace {
+
+// every boost archive header carries this signature
+const char ARCHIVE_SIGNATURE[] = "serialization::archive";
+
+/**
+ * Read a single object from an archive in either format.
+ */
+template <class T>
+T* load_archive(const std::string& path, const char* name)
+{
+    archive_format format = detect_archive_format(path);
+    if ( (format != ARCHIVE_XML) && (format != ARCHIVE_BINARY) ) {
+        std::cerr << "Unable to open file: " << path << std::endl;
+        return NULL;
+    }
+
+    T* obj = NULL;
+    try {
+        if (format == ARCHIVE_BINARY) {
+            std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary);
+            boost::archive::binary_iarchive ia(ifs);
+            ia >> boost::serialization::make_nvp(name, obj);
+        }
+        else {
+            std::ifstream ifs(path.c_str());
+            boost::archive::xml_iarchive ia(ifs);
+            ia >> boost::serialization::make_nvp(name, obj);
+        }
+    }
+    catch (boost::archive::archive_exception& e) {
+        std::cerr << "Error loading " << path << ": " << e.what() << std::endl;
+        obj = NULL;
+    }
+
+    if (obj == NULL) {
+        std::cerr << "Error loading " << path << std::endl;
+    }
+    return obj;
+}
+
+/**
+ * Write a single object to an archive.
+ */
+template <class T>
+bool save_archive(T* obj, const std::string& path, const char* name, archive_format format)
+{
+    std::ofstream ofs;
+    if (format == ARCHIVE_BINARY) {
+        ofs.open(path.c_str(), std::ios::out | std::ios::binary);
+    }
+    else {
+        ofs.open(path.c_str());
+    }
+    if (!ofs.good()) {
+        std::cerr << "Unable to write file: " << path << std::endl;
+        return false;
+    }
+
+    if (format == ARCHIVE_BINARY) {
+        boost::archive::binary_oarchive oa(ofs);
+        oa << boost::serialization::make_nvp(name, obj);
+    }
+    else {
+        boost::archive::xml_oarchive oa(ofs);
+        oa << boost::serialization::make_nvp(name, obj);
+    }
+    return ofs.good();
+}
+
+};  // anonymous namespace
+
+archive_format detect_archive_format(const std::string& path)
+{
+    std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary);
+    if (!ifs.good()) {
+        return ARCHIVE_UNKNOWN;
+    }
+
+    char header[64];
+    ifs.read(header, sizeof(header));
+    std::string head(header, static_cast<std::string::size_type>(ifs.gcount()));
+
+    if (indexed_animation::has_signature(head.data(), head.size())) {
+        return ARCHIVE_INDEXED;
+    }
+    if (packed_animation::has_signature(head.data(), head.size())) {
+        return ARCHIVE_PACKED;
+    }
+
+    // XML starts with a tag, possibly after a byte order mark or whitespace
+    std::string::size_type start = 0;
+    if (head.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        start = 3;
+    }
+    start = head.find_first_not_of(" \t\r\n", start);
+    if ( (start != std::string::npos) && (head[start] == '<') ) {
+        return ARCHIVE_XML;
+    }
+
+    // binary archives start with the length prefixed signature
+    if (head.find(ARCHIVE_SIGNATURE) != std::string::npos) {
+        return ARCHIVE_BINARY;
+    }
+    return ARCHIVE_UNKNOWN;
+}
+
+animation* load_animation(const std::string& path)
+{
+    archive_format format = detect_archive_format(path);
+    if (format == ARCHIVE_INDEXED) {
+        indexed_animation indexed;
+        if (!indexed.open(path)) {
+            return NULL;
+        }
+        return indexed.load_all();
+    }
+    if (format == ARCHIVE_PACKED) {
+        return packed_animation::read(path);
+    }
+    return load_archive<animation>(path, "animation");
+}
+
+void compact_animation(animation* anim, const edit_journal* history)
+{
+    // undo commands hold node and edge indices, those figures keep their
+    // empty slots (loading handles them)
+    std::set<figure*> indexed;
+    if (history != NULL) {
+        history->get_indexed_figures(indexed);
+    }
+
+    BOOST_FOREACH(frame* fr, anim->get_frames()) {
+        BOOST_FOREACH(figure* f, fr->get_figures()) {
+            if (indexed.find(f) == indexed.end()) {
+                f->compact();
+            }
+        }
+    }
+}
+
+bool save_animation(animation* anim, const std::string& path, archive_format format,
+                    const edit_journal* history)
+{
+    assert(anim != NULL);
+
+    // drop empty node slots left by cuts
+    compact_animation(anim, history);
+
+    if (format == ARCHIVE_INDEXED) {
+        return indexed_animation::write(anim, path);
+    }
+    if (format == ARCHIVE_PACKED) {
+        return packed_animation::write(anim, path);
+    }
+    return save_archive(anim, path, "animation", format);
+}
+
+figure* load_figure(const std::string& path)
+{
+    return load_archive<figure>(path, "figure");
+}
+
+bool save_figure(figure* fig, const std::string& path, archive_format format,
+                 const edit_journal* history)
+{
+    assert(fig != NULL);
+    if ( (format == ARCHIVE_INDEXED) || (format == ARCHIVE_PACKED) ) {
+        std::cerr << "Figures can only be saved as XML or binary archives: " << path << std::endl;
+        return false;
+    }
+
+    std::set<figure*> indexed;
+    if (history != NULL) {
+        history->get_indexed_figures(indexed);
+    }
+    if (indexed.find(fig) == indexed.end()) {
+        fig->compact();
+    }
+
+    return save_archive(fig, path, "figure", format);
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
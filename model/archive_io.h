@@ -0,0 +1,82 @@
+#ifndef _ARCHIVE_IO_H
+#define _ARCHIVE_IO_H       1
+
+/**
+ * @file archive_io.h
+ * @brief Loading and saving animation and figure archives. Shared by the
+ *        editors and the command line tools.
+ * @date 10-18-26
+ */
+
+#include <string>
+
+#include "animation.h"
+
+namespace stan {
+
+// forward declarations
+class edit_journal;
+
+/**
+ * Archive formats. XML is readable and portable; binary (a boost native
+ * binary archive) loads much faster but is tied to the platform's type
+ * sizes and byte order. Indexed animations (see indexed_animation.h) store
+ * every frame as a separate binary payload for random access. Packed
+ * animations (see packed_animation.h) write the structure shared by
+ * duplicated frames once, so they are the smallest.
+ */
+typedef enum {
+    ARCHIVE_UNKNOWN,
+    ARCHIVE_XML,
+    ARCHIVE_BINARY,
+    ARCHIVE_INDEXED,
+    ARCHIVE_PACKED,
+} archive_format;
+
+/**
+ * Determine the format of an archive file from its header.
+ * @return ARCHIVE_UNKNOWN if the file can not be read or is neither format
+ */
+archive_format detect_archive_format(const std::string& path);
+
+/**
+ * Load an animation archive (the format is detected).
+ * @note Meta data (images, sounds) is not loaded, the view has to do that
+ *       for the meta stores of the animation and of every figure.
+ * @return The new animation or NULL on failure
+ */
+animation* load_animation(const std::string& path);
+
+/**
+ * Drop the empty node slots of the figures of an animation, see
+ * figure::compact().
+ * @param history Figures it refers to by index are left alone
+ */
+void compact_animation(animation* anim, const edit_journal* history = NULL);
+
+/**
+ * Save an animation archive. Empty node slots of all figures are
+ * compacted first, except in figures the edit history refers to.
+ * @return false if the file could not be written
+ */
+bool save_animation(animation* anim, const std::string& path, archive_format format = ARCHIVE_XML,
+                    const edit_journal* history = NULL);
+
+/**
+ * Load a figure archive (the format is detected).
+ * @return The new figure or NULL on failure
+ */
+figure* load_figure(const std::string& path);
+
+/**
+ * Save a figure archive (compacting its node slots first, unless the edit
+ * history refers to them).
+ * @note The indexed and packed formats only hold animations.
+ * @return false if the file could not be written
+ */
+bool save_figure(figure* fig, const std::string& path, archive_format format = ARCHIVE_XML,
+                 const edit_journal* history = NULL);
+
+};  // namespace stan
+
+#endif  // _ARCHIVE_IO_H
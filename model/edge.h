@@ -1,5 +1,5 @@
 #ifndef _EDGE_H
-#define EDGE_H       1
+#define _EDGE_H       1
 
 /**
  * @file edge.h
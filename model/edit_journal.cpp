@@ -0,0 +1,342 @@
+/**
+ * @file edit_journal.cpp
+ * @brief Implementation of the undo / redo journal and its commands.
+ * @date 10-18-26
+ */
+
+#include <algorithm>
+#include <set>
+
+#include "edit_journal.h"
+
+namespace stan {
+
+void edit_journal::record(edit_command* cmd)
+{
+    drop_undone();
+    done_.push_back(cmd);
+    size_ += cmd->get_size();
+    trim();
+}
+
+void edit_journal::execute(edit_command* cmd)
+{
+    cmd->redo();
+    record(cmd);
+}
+
+bool edit_journal::undo()
+{
+    if (done_.empty()) {
+        return false;
+    }
+
+    edit_command* cmd = done_.back();
+    done_.pop_back();
+    cmd->undo();
+    undone_.push_back(cmd);
+    return true;
+}
+
+bool edit_journal::redo()
+{
+    if (undone_.empty()) {
+        return false;
+    }
+
+    edit_command* cmd = undone_.back();
+    undone_.pop_back();
+    cmd->redo();
+    done_.push_back(cmd);
+    return true;
+}
+
+void edit_journal::clear()
+{
+    drop_undone();
+    BOOST_FOREACH(edit_command* cmd, done_) {
+        delete cmd;
+    }
+    done_.clear();
+    size_ = 0;
+}
+
+void edit_journal::get_indexed_figures(std::set<figure*>& figures) const
+{
+    BOOST_FOREACH(edit_command* cmd, done_) {
+        if (cmd->get_indexed_figure() != NULL) {
+            figures.insert(cmd->get_indexed_figure());
+        }
+    }
+    BOOST_FOREACH(edit_command* cmd, undone_) {
+        if (cmd->get_indexed_figure() != NULL) {
+            figures.insert(cmd->get_indexed_figure());
+        }
+    }
+}
+
+void edit_journal::trim()
+{
+    while ( (size_ > budget_) && (done_.size() > 1) ) {
+        edit_command* cmd = done_.front();
+        done_.pop_front();
+        size_ -= cmd->get_size();
+        delete cmd;
+    }
+}
+
+void edit_journal::drop_undone()
+{
+    BOOST_FOREACH(edit_command* cmd, undone_) {
+        size_ -= cmd->get_size();
+        delete cmd;
+    }
+    undone_.clear();
+}
+
+position_command::position_command(figure* fig, const std::list<int>& nodes) :
+    fig_(fig),
+    positions_()
+{
+    positions_.reserve(nodes.size());
+    BOOST_FOREACH(int n, nodes) {
+        capture(n);
+    }
+}
+
+position_command::position_command(figure* fig) :
+    fig_(fig),
+    positions_()
+{
+    std::vector<node*>& nodes = fig_->get_nodes();
+    positions_.reserve(nodes.size());
+    for (unsigned n = 0; n < nodes.size(); n++) {
+        capture(static_cast<int>(n));
+    }
+}
+
+void position_command::capture(int n)
+{
+    node* pn = fig_->get_node(n);
+    if (pn != NULL) {
+        positions_.push_back(node_position(n, pn->get_x(), pn->get_y()));
+    }
+}
+
+bool position_command::commit()
+{
+    unsigned count = 0;
+    for (unsigned i = 0; i < positions_.size(); i++) {
+        node_position& p = positions_[i];
+        node* pn = fig_->get_node(p.node_);
+        if (pn == NULL) {
+            continue;
+        }
+
+        p.new_x_ = pn->get_x();
+        p.new_y_ = pn->get_y();
+        if ( (p.new_x_ != p.old_x_) || (p.new_y_ != p.old_y_) ) {
+            positions_[count++] = p;
+        }
+    }
+
+    // keep only the nodes which moved
+    std::vector<node_position>(positions_.begin(), positions_.begin() + count).swap(positions_);
+    return count > 0;
+}
+
+void position_command::undo()
+{
+    BOOST_FOREACH(node_position& p, positions_) {
+        fig_->get_node(p.node_)->move_to(p.old_x_, p.old_y_);
+    }
+}
+
+void position_command::redo()
+{
+    BOOST_FOREACH(node_position& p, positions_) {
+        fig_->get_node(p.node_)->move_to(p.new_x_, p.new_y_);
+    }
+}
+
+std::size_t position_command::get_size() const
+{
+    return sizeof(*this) + positions_.capacity() * sizeof(node_position);
+}
+
+create_command::create_command(figure* fig, int eindex) :
+    fig_(fig),
+    node_(-1),
+    parent_(-1),
+    x_(0),
+    y_(0),
+    edge_(*fig->get_edge(eindex))
+{
+    node_ = edge_.get_n2();
+    parent_ = edge_.get_n1();
+
+    node* n = fig_->get_node(node_);
+    x_ = n->get_x();
+    y_ = n->get_y();
+}
+
+void create_command::undo()
+{
+    // removes the node and every edge touching it, without compacting a
+    // figure with stable handles, so the slot is the next one reused
+    fig_->remove_children(node_);
+}
+
+void create_command::redo()
+{
+    int eindex = -1;
+    if (edge_.get_type() == edge::edge_circle) {
+        eindex = fig_->create_circle(parent_, x_, y_);
+    }
+    else if (edge_.get_type() == edge::edge_image) {
+        eindex = fig_->create_image(parent_, x_, y_, edge_.get_meta_index());
+    }
+    else {
+        eindex = fig_->create_line(parent_, x_, y_);
+    }
+
+    edge* e = fig_->get_edge(eindex);
+    e->set_color(edge_.get_color());
+    e->set_name(edge_.get_name());
+}
+
+cut_command::cut_command(figure* fig, int n) :
+    fig_(fig),
+    node_(n),
+    nodes_(),
+    edges_()
+{
+    std::list<int> subtree;
+    subtree.push_back(n);
+    fig_->get_decendants(subtree, n);     // pre-order, parents first
+
+    std::set<int> doomed;
+    BOOST_FOREACH(int d, subtree) {
+        node* dn = fig_->get_node(d);
+        int parent = dn->get_parent();
+
+        int child_pos = 0;
+        if (parent != -1) {
+            BOOST_FOREACH(int c, fig_->get_node(parent)->get_children()) {
+                if (c == d) {
+                    break;
+                }
+                child_pos++;
+            }
+        }
+        nodes_.push_back(removed_node(d, parent, dn->get_x(), dn->get_y(), child_pos));
+        doomed.insert(d);
+    }
+
+    std::vector<edge*>& edges = fig_->get_edges();
+    for (unsigned e = 0; e < edges.size(); e++) {
+        if ( (edges[e] != NULL) &&
+             ((doomed.count(edges[e]->get_n1()) > 0) || (doomed.count(edges[e]->get_n2()) > 0)) ) {
+            edges_.push_back(std::make_pair(static_cast<int>(e), *edges[e]));
+        }
+    }
+}
+
+void cut_command::undo()
+{
+    BOOST_FOREACH(removed_node& r, nodes_) {
+        fig_->restore_node(r.node_, r.parent_, r.x_, r.y_, r.child_pos_);
+    }
+
+    // ascending, so every edge lands on its old index
+    for (unsigned i = 0; i < edges_.size(); i++) {
+        fig_->insert_edge(edges_[i].first, edges_[i].second);
+    }
+}
+
+void cut_command::redo()
+{
+    // empty slots instead of renumbering, restore_node() needs them
+    fig_->set_stable_handles(true);
+    fig_->remove_children(node_);
+}
+
+std::size_t cut_command::get_size() const
+{
+    return sizeof(*this) + nodes_.capacity() * sizeof(removed_node) +
+           edges_.capacity() * sizeof(std::pair<int, edge>);
+}
+
+add_figure_command::~add_figure_command()
+{
+    if (owned_) {
+        delete fig_;
+    }
+}
+
+void add_figure_command::undo()
+{
+    frame_->remove_figure(fig_);
+    owned_ = true;
+}
+
+void add_figure_command::redo()
+{
+    // a figure taken over from a caller is already in the frame
+    std::list<figure*>& figures = frame_->get_figures();
+    if (std::find(figures.begin(), figures.end(), fig_) == figures.end()) {
+        frame_->add_figure(fig_);
+    }
+    owned_ = false;
+}
+
+remove_figure_command::~remove_figure_command()
+{
+    if (owned_) {
+        delete fig_;
+    }
+}
+
+void remove_figure_command::undo()
+{
+    // back to where it was in the z-order
+    std::list<figure*>& figures = frame_->get_figures();
+    std::list<figure*>::iterator pos = figures.begin();
+    for (int i = 0; (i < pos_) && (pos != figures.end()); i++) {
+        pos++;
+    }
+    figures.insert(pos, fig_);
+    frame_->touch();
+    owned_ = false;
+}
+
+void remove_figure_command::redo()
+{
+    std::list<figure*>& figures = frame_->get_figures();
+    pos_ = static_cast<int>(std::distance(figures.begin(), std::find(figures.begin(), figures.end(), fig_)));
+    frame_->remove_figure(fig_);
+    owned_ = true;
+}
+
+void color_command::undo()
+{
+    set_color(old_color_);
+}
+
+void color_command::redo()
+{
+    set_color(new_color_);
+}
+
+void color_command::set_color(int color)
+{
+    edge* e = fig_->get_edge(edge_);
+    if (e != NULL) {
+        e->set_color(color);
+        fig_->touch_edges();    // marks the frame modified for saving
+    }
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
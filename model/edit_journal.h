@@ -0,0 +1,403 @@
+#ifndef _EDIT_JOURNAL_H
+#define _EDIT_JOURNAL_H       1
+
+/**
+ * @file edit_journal.h
+ * @brief Undo / redo history of figure and frame edits, kept as small
+ *        per-operation deltas rather than snapshots.
+ * @date 10-18-26
+ */
+
+#include <deque>
+#include <list>
+#include <set>
+#include <vector>
+#include <cstddef>
+
+#include "frame.h"
+
+namespace stan {
+
+/**
+ * One undoable edit. A command is recorded right after its operation was
+ * done (or does it itself when passed to edit_journal::execute()), so it
+ * starts out in the done state; undo() and redo() are always called
+ * alternately.
+ */
+class edit_command
+{
+public:
+    edit_command() {}
+    virtual ~edit_command() {}
+
+    virtual void undo() = 0;
+    virtual void redo() = 0;
+
+    /**
+     * Approximate memory held by the command, for the journal budget.
+     */
+    virtual std::size_t get_size() const = 0;
+
+    /**
+     * The figure whose nodes or edges the command refers to by index,
+     * NULL if none. Its slots must not be renumbered (figure::compact())
+     * while the command is kept.
+     */
+    virtual figure* get_indexed_figure() const { return NULL; }
+
+private:
+    edit_command(const edit_command&);
+    edit_command& operator=(const edit_command&);
+};
+
+/**
+ * Bounded undo / redo stacks. The oldest commands are dropped once the
+ * commands together use more than the byte budget (the latest one is
+ * always kept). Recording a new command drops everything undone.
+ *
+ * Commands refer to figures and frames by pointer: clear the journal
+ * whenever those may be deleted (e.g. another animation is loaded).
+ * Commands may also refer to node and edge slots by index, so figures
+ * returned by get_indexed_figures() must not be compacted.
+ */
+class edit_journal
+{
+public:
+    static const std::size_t DEFAULT_BUDGET = 4 * 1024 * 1024;     // bytes
+
+    edit_journal(std::size_t budget = DEFAULT_BUDGET) :
+        done_(),
+        undone_(),
+        size_(0),
+        budget_(budget)
+    {
+    }
+
+    virtual ~edit_journal() { clear(); }
+
+    /**
+     * Add a command whose operation was already done (owned by the
+     * journal from now on).
+     */
+    void record(edit_command* cmd);
+
+    /**
+     * Do a command's operation and record it.
+     */
+    void execute(edit_command* cmd);
+
+    /**
+     * @return false if there is nothing to undo / redo
+     */
+    bool undo();
+    bool redo();
+
+    bool can_undo() const { return !done_.empty(); }
+    bool can_redo() const { return !undone_.empty(); }
+
+    int get_undo_count() const { return static_cast<int>(done_.size()); }
+    int get_redo_count() const { return static_cast<int>(undone_.size()); }
+
+    std::size_t get_size() const { return size_; }
+    void set_budget(std::size_t budget) { budget_ = budget; trim(); }
+
+    void clear();
+
+    /**
+     * Add the figures whose node or edge indices are held by done or
+     * undone commands.
+     */
+    void get_indexed_figures(std::set<figure*>& figures) const;
+
+private:
+    /**
+     * Drop the oldest commands until the budget is met.
+     */
+    void trim();
+
+    void drop_undone();
+
+    std::deque<edit_command*> done_;    // oldest first
+    std::deque<edit_command*> undone_;  // most recently undone last
+    std::size_t size_;
+    std::size_t budget_;
+};
+
+/**
+ * A whole figure moved by a delta.
+ */
+class move_command : public edit_command
+{
+public:
+    move_command(figure* fig, double dx, double dy) :
+        fig_(fig),
+        dx_(dx),
+        dy_(dy)
+    {
+    }
+
+    virtual void undo() { fig_->move(-dx_, -dy_); }
+    virtual void redo() { fig_->move(dx_, dy_); }
+    virtual std::size_t get_size() const { return sizeof(*this); }
+
+private:
+    figure* fig_;
+    double dx_;
+    double dy_;
+};
+
+/**
+ * A whole figure rotated about its root. Only the angle is kept, undo
+ * rotates back (the root stays in place).
+ */
+class rotate_command : public edit_command
+{
+public:
+    rotate_command(figure* fig, double angle) :
+        fig_(fig),
+        angle_(angle)
+    {
+    }
+
+    virtual void undo() { fig_->rotate(-angle_); }
+    virtual void redo() { fig_->rotate(angle_); }
+    virtual std::size_t get_size() const { return sizeof(*this); }
+
+private:
+    figure* fig_;
+    double angle_;
+};
+
+/**
+ * A whole figure scaled about its root. Only the factor is kept.
+ */
+class scale_command : public edit_command
+{
+public:
+    scale_command(figure* fig, double factor) :
+        fig_(fig),
+        factor_(factor)
+    {
+        assert(factor != 0);
+    }
+
+    virtual void undo() { fig_->scale(1 / factor_); }
+    virtual void redo() { fig_->scale(factor_); }
+    virtual std::size_t get_size() const { return sizeof(*this); }
+
+private:
+    figure* fig_;
+    double factor_;
+};
+
+/**
+ * Some nodes of a figure moved (pivot, stretch). Only the nodes whose
+ * position actually changed are kept.
+ */
+class position_command : public edit_command
+{
+public:
+    /**
+     * Remember the current positions of the nodes which may change.
+     */
+    position_command(figure* fig, const std::list<int>& nodes);
+
+    /**
+     * Remember the positions of every node of the figure.
+     */
+    position_command(figure* fig);
+
+    /**
+     * Take the new positions after the operation.
+     * @return false if no node moved (nothing worth recording)
+     */
+    bool commit();
+
+    virtual void undo();
+    virtual void redo();
+    virtual std::size_t get_size() const;
+    virtual figure* get_indexed_figure() const { return fig_; }
+
+private:
+    class node_position
+    {
+    public:
+        node_position(int n, double x, double y) :
+            node_(n),
+            old_x_(x),
+            old_y_(y),
+            new_x_(x),
+            new_y_(y)
+        {
+        }
+
+        int node_;
+        double old_x_;
+        double old_y_;
+        double new_x_;
+        double new_y_;
+    };
+
+    void capture(int n);
+
+    figure* fig_;
+    std::vector<node_position> positions_;
+};
+
+/**
+ * A node and the edge to it were added (line, circle or image tool).
+ * The node must be a leaf when the command is undone, which holds as long
+ * as commands are undone in order.
+ */
+class create_command : public edit_command
+{
+public:
+    /**
+     * @param eindex The new edge, whose second node is the new node
+     */
+    create_command(figure* fig, int eindex);
+
+    virtual void undo();
+    virtual void redo();
+    virtual std::size_t get_size() const { return sizeof(*this); }
+    virtual figure* get_indexed_figure() const { return fig_; }
+
+private:
+    figure* fig_;
+    int node_;
+    int parent_;
+    double x_;
+    double y_;
+    edge edge_;
+};
+
+/**
+ * A subtree was cut off a figure. The removed nodes and edges are kept so
+ * they can be put back into the same slots; the figure is switched to
+ * stable handles so no other node is renumbered.
+ */
+class cut_command : public edit_command
+{
+public:
+    /**
+     * Capture the subtree below (and including) node n. The cut itself is
+     * done by redo(), see edit_journal::execute().
+     */
+    cut_command(figure* fig, int n);
+
+    virtual void undo();
+    virtual void redo();
+    virtual std::size_t get_size() const;
+    virtual figure* get_indexed_figure() const { return fig_; }
+
+private:
+    class removed_node
+    {
+    public:
+        removed_node(int n, int parent, double x, double y, int child_pos) :
+            node_(n),
+            parent_(parent),
+            x_(x),
+            y_(y),
+            child_pos_(child_pos)
+        {
+        }
+
+        int node_;
+        int parent_;
+        double x_;
+        double y_;
+        int child_pos_;     // position in the parent's child list
+    };
+
+    figure* fig_;
+    int node_;
+    std::vector<removed_node> nodes_;               // parents before children
+    std::vector<std::pair<int, edge> > edges_;      // by ascending index
+};
+
+/**
+ * A figure was added to a frame (new figure, paste, break). While undone
+ * the command owns the figure.
+ */
+class add_figure_command : public edit_command
+{
+public:
+    add_figure_command(frame* fr, figure* fig) :
+        frame_(fr),
+        fig_(fig),
+        owned_(false)
+    {
+    }
+
+    virtual ~add_figure_command();
+
+    virtual void undo();
+    virtual void redo();
+    virtual std::size_t get_size() const { return sizeof(*this); }
+
+private:
+    frame* frame_;
+    figure* fig_;
+    bool owned_;
+};
+
+/**
+ * A figure was removed from a frame (cut). While done the command owns the
+ * figure, so commands recorded before the cut still point at a live object.
+ */
+class remove_figure_command : public edit_command
+{
+public:
+    remove_figure_command(frame* fr, figure* fig) :
+        frame_(fr),
+        fig_(fig),
+        pos_(0),
+        owned_(false)
+    {
+    }
+
+    virtual ~remove_figure_command();
+
+    virtual void undo();
+    virtual void redo();
+    virtual std::size_t get_size() const { return sizeof(*this); }
+
+private:
+    frame* frame_;
+    figure* fig_;
+    int pos_;           // position in the figure list (z-order)
+    bool owned_;
+};
+
+/**
+ * The color of an edge changed.
+ */
+class color_command : public edit_command
+{
+public:
+    color_command(figure* fig, int eindex, int old_color, int new_color) :
+        fig_(fig),
+        edge_(eindex),
+        old_color_(old_color),
+        new_color_(new_color)
+    {
+    }
+
+    virtual void undo();
+    virtual void redo();
+    virtual std::size_t get_size() const { return sizeof(*this); }
+    virtual figure* get_indexed_figure() const { return fig_; }
+
+private:
+    void set_color(int color);
+
+    figure* fig_;
+    int edge_;
+    int old_color_;
+    int new_color_;
+};
+
+};  // namespace stan
+
+#endif  // _EDIT_JOURNAL_H
@@ -5,6 +5,9 @@
  * @author G. Fordyce
  */
 
+#include <cmath>
+#include <algorithm>
+
 #include "figure.h"
 
 namespace stan {
@@ -15,44 +18,134 @@ std::ostream& operator<<(std::ostream &os, const figure &f)
     return os;
 }
 
+figure::~figure()
+{
+    // the last figure using an arena releases all of it at once, only
+    // objects from elsewhere (e.g. deserialized ones) are freed one by one
+    bool bulk = arena_ && (arena_.unique() || arena_release_);
+
+    BOOST_FOREACH(node* n, nodes_) {
+        if ( (n != NULL) && !(bulk && arena_->owns(n)) ) {
+            free_node(n);
+        }
+    }
+    BOOST_FOREACH(edge* e, edges_) {
+        if ( (e != NULL) && !(bulk && arena_->owns(e)) ) {
+            free_edge(e);
+        }
+    }
+}
+
 void figure::disconnect(int nindex)
 {
     node* n = get_node(nindex);
     assert(n != NULL);
 
     int pindex = n->get_parent();
-    node* p = get_node(pindex);
-
-    std::list<int> children = p->get_children();
-    children.remove(nindex);
+    if (pindex != -1) {
+        node* p = get_node(pindex);
+        if (p != NULL) {
+            p->remove_child(nindex);
+            touch_topology();
+        }
+    }
 }
 
 void figure::remove_edge(int eindex)
 {
     edge* e = get_edge(eindex);
     assert(e != NULL);
+    solve_skeleton();
     edges_.erase(edges_.begin() + eindex);  // remove vector entry
-    delete e;
+
+    // update the index in place: later edges shift down by one and the
+    // entry of the removed edge goes, or passes to a later duplicate
+    if (edge_index_valid_) {
+        std::pair<int, int> key(e->get_n1(), e->get_n2());
+        edge_index_map::iterator iter = edge_index_.find(key);
+        bool first = (iter != edge_index_.end()) && (iter->second == eindex);
+        if (first) {
+            edge_index_.erase(iter);
+        }
+        for (iter = edge_index_.begin(); iter != edge_index_.end(); ++iter) {
+            if (iter->second > eindex) {
+                iter->second--;
+            }
+        }
+        for (unsigned d = eindex; first && (d < edges_.size()); d++) {
+            edge* de = edges_[d];
+            if ((de != NULL) && (de->get_n1() == key.first) && (de->get_n2() == key.second)) {
+                edge_index_.insert(std::make_pair(key, static_cast<int>(d)));
+                break;
+            }
+        }
+    }
+    free_edge(e);
+    revision_++;
+}
+
+void figure::remove_edges(const std::vector<unsigned char>& doomed)
+{
+    unsigned count = 0;
+    for (unsigned eindex = 0; eindex < edges_.size(); eindex++) {
+        edge* e = edges_[eindex];
+        if (e != NULL) {
+            int n1 = e->get_n1();
+            int n2 = e->get_n2();
+            if ( (n1 >= 0 && n1 < static_cast<int>(doomed.size()) && doomed[n1]) ||
+                 (n2 >= 0 && n2 < static_cast<int>(doomed.size()) && doomed[n2]) ) {
+                free_edge(e);
+                continue;
+            }
+        }
+        edges_[count++] = e;   // keep edge, preserving order
+    }
+    edges_.resize(count);
+    touch_edges();
 }
 
 int figure::get_edge(int n1, int n2)
 {
-    for(unsigned eindex = 0; eindex < edges_.size(); eindex++) {
+    if (!edge_index_valid_) {
+        build_edge_index();
+    }
+
+    edge_index_map::const_iterator iter = edge_index_.find(std::make_pair(n1, n2));
+    if (iter != edge_index_.end()) {
+        return iter->second;
+    }
+    return -1;
+}
+
+int figure::add_edge(edge* e)
+{
+    edges_.push_back(e);
+    int eindex = static_cast<int>(edges_.size()) - 1;
+
+    // insert() keeps an existing entry, so the first matching edge wins
+    if (edge_index_valid_) {
+        edge_index_.insert(std::make_pair(std::make_pair(e->get_n1(), e->get_n2()), eindex));
+    }
+    return eindex;
+}
+
+void figure::build_edge_index()
+{
+    edge_index_.clear();
+    for (unsigned eindex = 0; eindex < edges_.size(); eindex++) {
         edge* en = get_edge(eindex);
         if (en != NULL) {
-            if ( (en->get_n1() == n1) && (en->get_n2() == n2) ) {
-                return eindex;
-            }
+            edge_index_.insert(std::make_pair(std::make_pair(en->get_n1(), en->get_n2()), static_cast<int>(eindex)));
         }
     }
-    return -1;
+    edge_index_valid_ = true;
 }
 
 int figure::create_node(int parent, double x, double y)
 {
-    node* cn = new node(parent, x, y);
-    nodes_.push_back(cn);
-    int child = static_cast<int>(nodes_.size()) - 1;
+    solve_skeleton();
+    node* cn = alloc_node(parent, x, y);
+    int child = insert_node(cn);
 
     // if child has a parent, look it up and add child
     if (parent != -1) {
@@ -71,37 +164,29 @@ int figure::create_node(int parent, double x, double y)
 int figure::create_line(int parent, double x, double y)
 {
     int child = create_node(parent, x, y);
-    edge* e = new edge(edge::edge_line, parent, child);
-    edges_.push_back(e);
-    int eindex = static_cast<int>(edges_.size()) - 1;
-    return eindex;
+    edge* e = alloc_edge(edge::edge_line, parent, child);
+    return add_edge(e);
 }
 
 int figure::create_circle(int n1, int n2)
 {
-    edge* e = new edge(edge::edge_circle, n1, n2);
-    edges_.push_back(e);
-    int eindex = static_cast<int>(edges_.size()) - 1;
-    return eindex;
+    edge* e = alloc_edge(edge::edge_circle, n1, n2);
+    return add_edge(e);
 }
 
 int figure::create_circle(int parent, double x, double y)
 {
     int child = create_node(parent, x, y);
-    edge* e = new edge(edge::edge_circle, parent, child);
-    edges_.push_back(e);
-    int eindex = static_cast<int>(edges_.size()) - 1;
-    return eindex;
+    edge* e = alloc_edge(edge::edge_circle, parent, child);
+    return add_edge(e);
 }
 
 int figure::create_image(int parent, double x, double y, int image_index)
 {
     int child = create_node(parent, x, y);
-    edge* e = new edge(edge::edge_image, parent, child);
+    edge* e = alloc_edge(edge::edge_image, parent, child);
     e->set_meta_index(image_index);
-    edges_.push_back(e);
-    int eindex = static_cast<int>(edges_.size()) - 1;
-    return eindex;
+    return add_edge(e);
 }
 
 bool figure::get_node_at_pos(int& an, double x, double y, int radius)
@@ -112,29 +197,109 @@ bool figure::get_node_at_pos(int& an, double x, double y, int radius)
     double xr = x + radius;
     double yt = y - radius;
     double yb = y + radius;
-    for (unsigned n = 0; n < nodes_.size(); n++) {
-        node *pn = get_node(n);
-        if (pn != NULL) {
-            if ( (pn->get_x() > xl) && (pn->get_x() < xr) && (pn->get_y() > yt) && (pn->get_y() < yb) ) {
+
+    // scan the packed positions rather than chasing node pointers
+    const node_store& ns = get_node_store();
+    int count = ns.size();
+    for (int n = 0; n < count; n++) {
+        double nx = ns.x_[n];
+        double ny = ns.y_[n];
+        if ( (nx > xl) && (nx < xr) && (ny > yt) && (ny < yb) && ns.is_live(n) ) {
+            found = true;
+            an = n;
+            break;
+        }
+    }
+    return found;
+}
+
+const node_store& figure::get_node_store()
+{
+    solve_skeleton();
+    if (!node_store_.is_topology_current(topology_revision_)) {
+        node_store_.build(nodes_);
+    }
+    else if (!node_store_.is_current(revision_, topology_revision_)) {
+        node_store_.refresh_positions(nodes_);
+    }
+    node_store_.set_revision(revision_, topology_revision_);
+    return node_store_;
+}
+
+bool figure::get_bounds(double& x1, double& y1, double& x2, double& y2)
+{
+    solve_skeleton();
+    if (!bounds_valid_ || (bounds_revision_ != revision_)) {
+        const node_store& ns = get_node_store();
+
+        bool found = false;
+        double bx1 = 0;
+        double by1 = 0;
+        double bx2 = 0;
+        double by2 = 0;
+        for (int n = 0; n < ns.size(); n++) {
+            if (!ns.is_live(n)) {
+                continue;
+            }
+            double x = ns.x_[n];
+            double y = ns.y_[n];
+            if (!found) {
+                bx1 = bx2 = x;
+                by1 = by2 = y;
                 found = true;
-                an = n;
-                break;
             }
+            else {
+                bx1 = std::min(bx1, x);
+                bx2 = std::max(bx2, x);
+                by1 = std::min(by1, y);
+                by2 = std::max(by2, y);
+            }
+        }
+
+        // circles and images reach beyond their end points
+        BOOST_FOREACH(edge* e, edges_) {
+            if ( (e == NULL) || (e->get_type() == edge::edge_line) ) {
+                continue;
+            }
+            double ex1 = ns.x_[e->get_n1()];
+            double ey1 = ns.y_[e->get_n1()];
+            double ex2 = ns.x_[e->get_n2()];
+            double ey2 = ns.y_[e->get_n2()];
+            double cx = ex1 + (ex2 - ex1) / 2;
+            double cy = ey1 + (ey2 - ey1) / 2;
+            double length = sqrt(((ex2 - ex1) * (ex2 - ex1)) + ((ey2 - ey1) * (ey2 - ey1)));
+            double radius = (e->get_type() == edge::edge_circle) ? (length / 2) : length;
+            bx1 = std::min(bx1, cx - radius);
+            bx2 = std::max(bx2, cx + radius);
+            by1 = std::min(by1, cy - radius);
+            by2 = std::max(by2, cy + radius);
+        }
+
+        bounds_x1_ = bx1;
+        bounds_y1_ = by1;
+        bounds_x2_ = bx2;
+        bounds_y2_ = by2;
+        bounds_revision_ = revision_;
+        bounds_valid_ = found;
+        if (!found) {
+            return false;
         }
     }
-    return found;
+
+    x1 = bounds_x1_;
+    y1 = bounds_y1_;
+    x2 = bounds_x2_;
+    y2 = bounds_y2_;
+    return true;
 }
 
 edge* figure::find_edge(int n1, int n2)
 {
     edge* e = NULL;
 
-    for(unsigned eindex = 0; eindex < edges_.size(); eindex++) {
-        edge* en = get_edge(eindex);
-        if ( (en->get_n1() == n1) && (en->get_n2() == n2) ) {
-            e = en;
-            break;
-        }
+    int eindex = get_edge(n1, n2);
+    if (eindex != -1) {
+        e = get_edge(eindex);
     }
     return e;
 }
@@ -153,7 +318,7 @@ bool figure::thinner()
 {
     bool success = false;
     if (weight_ > MIN_WEIGHT) {
-        weight_--;
+        set_weight(weight_ - 1);
         success = true;
     }
     return success;
@@ -163,7 +328,7 @@ bool figure::thicker()
 {
     bool success = false;
     if (weight_ < MAX_WEIGHT ) {
-        weight_++;
+        set_weight(weight_ + 1);
         success = true;
     }
     return success;
@@ -191,6 +356,9 @@ void figure::print(std::ostream& os) const
 
 void figure::clone(figure* fig, const figure& other)
 {
+    // copies carry the solved pose
+    other.solve_skeleton();
+
     // copy meta data
     fig->root_ = other.root_;
     fig->selected_ = other.selected_;
@@ -198,34 +366,49 @@ void figure::clone(figure* fig, const figure& other)
     fig->pivot_ = other.pivot_;
     fig->is_enabled_ = other.is_enabled_;
 
-    // copy nodes
+    // copy nodes (empty slots are kept so that node indices match)
     for (unsigned n = 0; n < other.nodes_.size(); n++) {
         node* en = other.get_node(n);
         if (en != NULL) {
-            node* n = new node(en->parent_, en->get_x(), en->get_y());
+            node* n = fig->alloc_node(en->parent_, en->get_x(), en->get_y());
+            fig->adopt_node(n);
             fig->nodes_.push_back(n);
             BOOST_FOREACH(int c, en->children_) {
                 n->children_.push_back(c);
             }
         }
+        else {
+            fig->nodes_.push_back(NULL);
+        }
     }
+    fig->generations_ = other.generations_;
+    fig->generations_.resize(fig->nodes_.size(), 0);
+    fig->free_nodes_ = other.free_nodes_;
+    fig->stable_handles_ = other.stable_handles_;
 
     // copy edges
     for (unsigned e = 0; e < other.edges_.size(); e++) {
         edge* ee = other.get_edge(e);
         if (ee != NULL) {
             // edge *e = new edge(ee->type_, ee->n1_, ee->n2_, ee->color_);
-            edge* e = new edge(*ee);
+            edge* e = fig->alloc_edge(*ee);
             fig->edges_.push_back(e);
         }
     }
+    fig->edge_index_valid_ = false;
 
-    // copy images
-    meta_store_ = new meta_store(*other.meta_store_);
+    // share images, the store is copied once one of the figures changes it
+    fig->meta_store_ = other.meta_store_;
+
+    fig->touch_topology();
 }
 
 void figure::move(double dx, double dy)
 {
+    solve_skeleton();
+
+    // the nodes hold the positions, the packed copy refreshes on next use
+    // (transforming it as well would only add a write-back per node)
     for (unsigned n = 0; n < nodes_.size(); n++) {
         node* an = get_node(n);
         if (an != NULL) {
@@ -236,50 +419,113 @@ void figure::move(double dx, double dy)
 
 void figure::scale(double scale)
 {
+    solve_skeleton();
+
+    // scale about the root so the figure stays where it is
     node* rn = get_node(root_);
-    double rx = rn->get_x();
-    double ry = rn->get_y();
+    transform(affine::scaling(scale, rn->get_x(), rn->get_y()));
+}
 
+void figure::transform(const affine& m, const std::list<int>& nodes)
+{
+    solve_skeleton();
+    BOOST_FOREACH(int n, nodes) {
+        node* an = get_node(n);
+        if (an != NULL) {
+            double x = an->get_x();
+            double y = an->get_y();
+            m.apply(x, y);
+            an->move_to(x, y);
+        }
+    }
+}
+
+void figure::transform(const affine& m)
+{
+    solve_skeleton();
+
+    // as move(): only the nodes, the packed copy refreshes on next use
     for (unsigned n = 0; n < nodes_.size(); n++) {
         node* an = get_node(n);
         if (an != NULL) {
-            an->set_x(an->get_x() * scale);
-            an->set_y(an->get_y() * scale);
+            double x = an->get_x();
+            double y = an->get_y();
+            m.apply(x, y);
+            an->move_to(x, y);
         }
     }
+}
 
-    // scaling will move all points, reposition to match last root node position
-    double dx = rx - rn->get_x();
-    double dy = ry - rn->get_y();
-    move(dx, dy);
+void figure::rotate(double angle)
+{
+    solve_skeleton();
+    node* rn = get_node(root_);
+    transform(affine::rotation(angle, rn->get_x(), rn->get_y()));
 }
 
-void figure::remove_decendants(int nindex)
+skeleton& figure::get_skeleton()
 {
-    node* n = get_node(nindex);
-    assert (n != NULL);
-    const std::list<int>& children = n->get_children();
-
-    BOOST_FOREACH(int child, children) {
-        if (child != -1) {
-            remove_decendants(child);    // remove all nodes below this one
-            int eindex = get_edge(nindex, child);
-            if (eindex != -1) {
-                remove_edge(eindex);    // no nodes below, cut the edge
-            }
-            remove_node(child);
-        }
+    // world space edits since the last build or solve win over the bones
+    if (!skeleton_.is_current(revision_, topology_revision_)) {
+        skeleton_.build(nodes_, root_);
+        skeleton_.set_revision(revision_, topology_revision_);
     }
+    return skeleton_;
+}
 
-    // now clear the child list
-    n->clear_children();
+void figure::rotate_bone(int n, double angle)
+{
+    get_skeleton().rotate(n, angle);
+}
+
+void figure::set_bone_angle(int n, double angle)
+{
+    get_skeleton().set_angle(n, angle);
+}
+
+void figure::set_bone_length(int n, double length)
+{
+    get_skeleton().set_length(n, length);
+}
+
+double figure::get_bone_angle(int n)
+{
+    return get_skeleton().get_angle(n);
+}
+
+double figure::get_bone_length(int n)
+{
+    return get_skeleton().get_length(n);
+}
+
+int figure::solve_skeleton() const
+{
+    if (!skeleton_.is_dirty()) {
+        return 0;
+    }
+
+    int moved = skeleton_.solve(nodes_);
+
+    // the new positions came from the bones, they stay current
+    skeleton_.set_revision(revision_, topology_revision_);
+    return moved;
+}
 
-    // correct node references starting at child index (erase() moves them down by 1 index)
-    fix_node_refs(nindex);
+void figure::remove_decendants(int nindex)
+{
+    release_subtree(nindex, false);
+
+    // renumber once for the whole subtree rather than once per node
+    if (!stable_handles_) {
+        compact();
+    }
 }
 
 void figure::fix_node_refs(int nindex)
 {
+    touch_topology();
+    edge_index_valid_ = false;
+
     // since nindex was deleted, all refs to nodes in the vector from nindex and up must be
     // decremented (edges)
     for(unsigned e = 0; e < edges_.size(); e++) {
@@ -300,7 +546,6 @@ void figure::fix_node_refs(int nindex)
     // also need to fix node references
     for(unsigned n = 0; n < nodes_.size(); n++) {
         node* pn = get_node(n);
-        assert(pn != NULL);
         if (pn != NULL) {
             // fix parent reference
             int parent = pn->get_parent();
@@ -321,42 +566,191 @@ void figure::fix_node_refs(int nindex)
 
 void figure::remove_child(int child)
 {
+    solve_skeleton();
+
     node* n = get_node(child);
     assert(n != NULL);
 
     int parent = n->get_parent();
-    node* pn = get_node(parent);
-    if (pn != NULL) {
-        pn->remove_child(child);
-        nodes_.erase(nodes_.begin() + child);
-    }
-
     int eindex = get_edge(parent, child);
     if (eindex != -1) {
         remove_edge(eindex);    // no nodes below, cut the edge
     }
 
-    // correct node references starting at child index (erase() moves them down by 1 index)
-    fix_node_refs(child);
+    release_node(child);
+
+    if (!stable_handles_) {
+        compact();
+    }
 }
 
 void figure::remove_children(int nindex)
 {
-    remove_decendants(nindex);
-    remove_child(nindex);
+    release_subtree(nindex, true);
+
+    if (!stable_handles_) {
+        compact();
+    }
+}
+
+void figure::restore_node(int nindex, int parent, double x, double y, int child_pos)
+{
+    solve_skeleton();
+    assert( (nindex >= 0) && (nindex < static_cast<int>(nodes_.size())) && (nodes_[nindex] == NULL) );
+
+    std::vector<int>::iterator slot = std::find(free_nodes_.begin(), free_nodes_.end(), nindex);
+    if (slot != free_nodes_.end()) {
+        free_nodes_.erase(slot);
+    }
+
+    node* n = alloc_node(parent, x, y);
+    adopt_node(n);
+    nodes_[nindex] = n;
+
+    if (parent != -1) {
+        std::list<int>& siblings = get_node(parent)->children_;
+        std::list<int>::iterator pos = siblings.begin();
+        for (int i = 0; (i < child_pos) && (pos != siblings.end()); i++) {
+            pos++;
+        }
+        siblings.insert(pos, nindex);
+    }
+    else {
+        root_ = nindex;
+    }
+    touch_topology();
+}
+
+void figure::insert_edge(int eindex, const edge& e)
+{
+    if ( (eindex < 0) || (eindex > static_cast<int>(edges_.size())) ) {
+        eindex = static_cast<int>(edges_.size());
+    }
+    edges_.insert(edges_.begin() + eindex, alloc_edge(e));
+    touch_edges();
+}
+
+int figure::compact(std::vector<int>* remap)
+{
+    solve_skeleton();
+
+    if (std::find(nodes_.begin(), nodes_.end(), static_cast<node*>(NULL)) == nodes_.end()) {
+        if (remap != NULL) {
+            remap->resize(nodes_.size());
+            for (unsigned n = 0; n < nodes_.size(); n++) {
+                (*remap)[n] = n;
+            }
+        }
+        return 0;
+    }
+
+    std::vector<int> new_index(nodes_.size(), -1);
+
+    // slide live nodes down, preserving their order
+    int count = 0;
+    for (unsigned n = 0; n < nodes_.size(); n++) {
+        if (nodes_[n] != NULL) {
+            new_index[n] = count;
+            nodes_[count++] = nodes_[n];
+        }
+    }
+    int removed = static_cast<int>(nodes_.size()) - count;
+    nodes_.resize(count);
+
+    // rewrite node references
+    for (int n = 0; n < count; n++) {
+        node* pn = nodes_[n];
+        int parent = pn->get_parent();
+        pn->parent_ = (parent >= 0 && parent < static_cast<int>(new_index.size())) ? new_index[parent] : -1;
+
+        std::list<int>::iterator iter = pn->children_.begin();
+        while (iter != pn->children_.end()) {
+            int c = *iter;
+            if (c >= 0 && c < static_cast<int>(new_index.size()) && new_index[c] != -1) {
+                *iter = new_index[c];
+                iter++;
+            }
+            else {
+                iter = pn->children_.erase(iter);
+            }
+        }
+    }
+
+    // rewrite edges, dropping any left dangling by removed nodes
+    unsigned ecount = 0;
+    for (unsigned eindex = 0; eindex < edges_.size(); eindex++) {
+        edge* e = edges_[eindex];
+        if (e != NULL) {
+            int n1 = e->get_n1();
+            int n2 = e->get_n2();
+            bool ok1 = (n1 >= 0 && n1 < static_cast<int>(new_index.size()) && new_index[n1] != -1);
+            bool ok2 = (n2 >= 0 && n2 < static_cast<int>(new_index.size()) && new_index[n2] != -1);
+            if (!ok1 || !ok2) {
+                free_edge(e);
+                continue;
+            }
+            e->set_n1(new_index[n1]);
+            e->set_n2(new_index[n2]);
+        }
+        edges_[ecount++] = e;
+    }
+    edges_.resize(ecount);
+
+    if (root_ >= 0 && root_ < static_cast<int>(new_index.size())) {
+        root_ = new_index[root_];
+    }
+    if (selected_ >= 0 && selected_ < static_cast<int>(new_index.size())) {
+        selected_ = new_index[selected_];
+    }
+    if (pivot_ >= 0 && pivot_ < static_cast<int>(new_index.size())) {
+        pivot_ = new_index[pivot_];
+    }
+
+    // every slot gets a generation newer than any handed out so far,
+    // invalidating all outstanding handles
+    unsigned generation = 0;
+    BOOST_FOREACH(unsigned g, generations_) {
+        if (g > generation) {
+            generation = g;
+        }
+    }
+    generations_.assign(count, generation + 1);
+    free_nodes_.clear();
+
+    edge_index_valid_ = false;
+    touch_topology();
+
+    if (remap != NULL) {
+        remap->swap(new_index);
+    }
+    return removed;
+}
+
+node_handle figure::get_handle(int n) const
+{
+    unsigned generation = (n >= 0 && n < static_cast<int>(generations_.size())) ? generations_[n] : 0;
+    return node_handle(n, generation);
+}
+
+bool figure::is_valid(const node_handle& h) const
+{
+    return (h.index_ >= 0) &&
+           (h.index_ < static_cast<int>(nodes_.size())) &&
+           (nodes_[h.index_] != NULL) &&
+           (generations_[h.index_] == h.generation_);
 }
 
 void figure::clone_subtree(figure* other, int s_index, int d_parent)
 {
     std::cout << "clone_subtree: cloning " << s_index << std::endl;
+    other->solve_skeleton();
 
     node* s_node = other->get_node(s_index);
     assert(s_node != NULL);
     const std::list<int>& s_children = s_node->get_children();
 
-    node* d_node = new node(d_parent, s_node->get_x(), s_node->get_y());
-    nodes_.push_back(d_node);
-    int d_index = static_cast<int>(nodes_.size()) - 1;
+    node* d_node = alloc_node(d_parent, s_node->get_x(), s_node->get_y());
+    int d_index = insert_node(d_node);
     if (d_parent != -1) {
         // if we have a parent, we need to add ourself to the parent's child list
         node* d_node_parent = get_node(d_parent);
@@ -375,8 +769,8 @@ void figure::clone_subtree(figure* other, int s_index, int d_parent)
         if (s_edge_index != -1) {
             edge* s_edge = other->get_edge(s_edge_index);
             assert(s_edge != NULL);
-            edge* d_edge = new edge(s_edge->get_type(), d_parent, d_index);
-            edges_.push_back(d_edge);
+            edge* d_edge = alloc_edge(s_edge->get_type(), d_parent, d_index);
+            add_edge(d_edge);
         }
     }
 
@@ -390,14 +784,68 @@ void figure::clone_subtree(figure* other, int s_index, int d_parent)
  * Private methods
  */
 
-void figure::remove_node(int nindex)
+int figure::insert_node(node* n)
+{
+    int nindex;
+
+    adopt_node(n);
+    generations_.resize(nodes_.size(), 0);
+    if (!free_nodes_.empty()) {
+        nindex = free_nodes_.back();
+        free_nodes_.pop_back();
+        nodes_[nindex] = n;
+    }
+    else {
+        nodes_.push_back(n);
+        generations_.push_back(0);
+        nindex = static_cast<int>(nodes_.size()) - 1;
+    }
+    touch_topology();
+    return nindex;
+}
+
+void figure::release_node(int nindex)
 {
     node* n = get_node(nindex);
     assert(n != NULL);
     disconnect(nindex); // remove it from the parent's child list
-    // nodes_[nindex] = NULL;  // TODO: this should be erased from the vector!!!
-    nodes_.erase(nodes_.begin() + nindex);  // Note: an immediate call to figure::fix_node_refs() is now required!
-    delete n;
+
+    // leave an empty slot, nothing else is renumbered
+    nodes_[nindex] = NULL;
+    free_node(n);
+
+    generations_.resize(nodes_.size(), 0);
+    generations_[nindex]++;
+    free_nodes_.push_back(nindex);
+    touch_topology();
+}
+
+void figure::release_subtree(int nindex, bool include_root)
+{
+    solve_skeleton();
+
+    node* n = get_node(nindex);
+    assert (n != NULL);
+
+    std::list<int> doomed_nodes;
+    get_decendants(doomed_nodes, nindex);
+    if (include_root) {
+        doomed_nodes.push_back(nindex);
+    }
+
+    // cut every edge touching the subtree in one pass over the edge list
+    std::vector<unsigned char> doomed(nodes_.size(), 0);
+    BOOST_FOREACH(int d, doomed_nodes) {
+        doomed[d] = 1;
+    }
+    remove_edges(doomed);
+
+    // now clear the child list
+    n->clear_children();
+
+    BOOST_FOREACH(int d, doomed_nodes) {
+        release_node(d);
+    }
 }
 
 };  // namespace stan
@@ -12,23 +12,57 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <utility>
 
 #include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/list.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/assume_abstract.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "node.h"
+#include "node_store.h"
+#include "affine.h"
+#include "skeleton.h"
 #include "edge.h"
+#include "graph_arena.h"
 #include "metadata.h"
 
 class test_figure;
 
 namespace stan {
 
+/**
+ * A node handle identifies a node by index and generation. Unlike a bare
+ * index it can be checked for validity: it goes stale once the node it
+ * refers to is removed or the figure is compacted.
+ */
+class node_handle
+{
+public:
+    node_handle() :
+        index_(-1),
+        generation_(0)
+    {
+    }
+
+    node_handle(int index, unsigned generation) :
+        index_(index),
+        generation_(generation)
+    {
+    }
+
+    int index_;
+    unsigned generation_;
+};
+
 class figure
 {
 private:
@@ -44,7 +78,57 @@ public:
         selected_(-1),
         pivot_(-1),
         is_enabled_(true),
-        meta_store_(new meta_store())
+        meta_store_(new meta_store()),
+        revision_(0),
+        topology_revision_(0),
+        node_store_(),
+        skeleton_(),
+        edge_index_(),
+        edge_index_valid_(false),
+        generations_(),
+        free_nodes_(),
+        stable_handles_(false),
+        bounds_x1_(0),
+        bounds_y1_(0),
+        bounds_x2_(0),
+        bounds_y2_(0),
+        bounds_revision_(0),
+        bounds_valid_(false),
+        arena_(),
+        arena_release_(false)
+    {
+    }
+
+    /**
+     * Create an empty figure whose nodes and edges are allocated from an
+     * arena (which may be shared with other figures, e.g. of one frame).
+     */
+    figure(boost::shared_ptr<graph_arena> arena) :
+        root_(-1),
+        edges_(),
+        nodes_(),
+        weight_(1),
+        selected_(-1),
+        pivot_(-1),
+        is_enabled_(true),
+        meta_store_(new meta_store()),
+        revision_(0),
+        topology_revision_(0),
+        node_store_(),
+        skeleton_(),
+        edge_index_(),
+        edge_index_valid_(false),
+        generations_(),
+        free_nodes_(),
+        stable_handles_(false),
+        bounds_x1_(0),
+        bounds_y1_(0),
+        bounds_x2_(0),
+        bounds_y2_(0),
+        bounds_revision_(0),
+        bounds_valid_(false),
+        arena_(arena),
+        arena_release_(false)
     {
     }
 
@@ -55,12 +139,29 @@ public:
         selected_(-1),
         pivot_(-1),
         is_enabled_(true),
-        meta_store_(new meta_store())
+        meta_store_(new meta_store()),
+        revision_(0),
+        topology_revision_(0),
+        node_store_(),
+        skeleton_(),
+        edge_index_(),
+        edge_index_valid_(false),
+        generations_(),
+        free_nodes_(),
+        stable_handles_(false),
+        bounds_x1_(0),
+        bounds_y1_(0),
+        bounds_x2_(0),
+        bounds_y2_(0),
+        bounds_revision_(0),
+        bounds_valid_(false),
+        arena_(),
+        arena_release_(false)
     {
         root_ = create_node(-1, x, y);
     }
 
-    virtual ~figure() { delete meta_store_; }
+    virtual ~figure();
 
     /**
      * Clone the subtree from the specified node in the tree.
@@ -79,6 +180,49 @@ public:
      */
     void remove_child(int child);
 
+    /**
+     * In stable handle mode removed nodes leave an empty (NULL) slot in the
+     * node list and no other node is renumbered, so removal only costs the
+     * size of the removed subtree. Empty slots are reused by new nodes and
+     * dropped by compact(). With stable handles off (the default) every
+     * removal is followed by a compaction and node indices stay dense.
+     */
+    void set_stable_handles(bool stable) { stable_handles_ = stable; }
+    bool has_stable_handles() { return stable_handles_; }
+
+    /**
+     * Renumber nodes to remove empty slots left by stable handle removal.
+     * All node references (parents, children, edges, root) are rewritten
+     * in a single pass and all outstanding node handles become stale.
+     * A figure without empty slots is left untouched (its revision does not
+     * change), so saving does not mark every figure as modified.
+     * @param remap If not NULL, receives the new index of each old node
+     *        index (-1 for removed nodes).
+     * @return The number of empty slots removed.
+     */
+    int compact(std::vector<int>* remap = NULL);
+
+    /**
+     * Get a handle for a node which can later be checked for validity.
+     */
+    node_handle get_handle(int n) const;
+
+    /**
+     * Is the node referred to by the handle still in the figure?
+     */
+    bool is_valid(const node_handle& h) const;
+
+    /**
+     * Get the node referred to by a handle.
+     * @return The node or NULL if the handle is stale.
+     */
+    node* get_node(const node_handle& h) const { return is_valid(h) ? nodes_[h.index_] : NULL; }
+
+    /**
+     * Number of empty slots waiting to be reused or compacted.
+     */
+    int get_free_count() const { return static_cast<int>(free_nodes_.size()); }
+
     /**
      * Fix all figure references to nodes with index >= nindex.
      * This is necessary when a node is delected from the vector and all
@@ -92,19 +236,42 @@ public:
      */
     void remove_children(int nindex);
 
+    /**
+     * Put a removed node back into its empty slot (left by stable handle
+     * removal), linked into its parent's child list at child_pos. Used to
+     * undo removals without renumbering any other node.
+     */
+    void restore_node(int nindex, int parent, double x, double y, int child_pos);
+
+    /**
+     * Insert a copy of an edge at eindex, later edges move up by one.
+     */
+    void insert_edge(int eindex, const edge& e);
+
     /**
      * Disconnect a node from it's parent.
      */
     void disconnect(int nindex);
 
+    /**
+     * Remove a single edge. The edge index is updated in place, no rebuild
+     * is needed for the next lookup.
+     */
     void remove_edge(int eindex);
 
+    /**
+     * Remove every edge which has a node in the given set as an endpoint.
+     * This is done in a single pass over the edge list.
+     * @param doomed Flags indexed by node, non-zero for removed nodes.
+     */
+    void remove_edges(const std::vector<unsigned char>& doomed);
+
     // Accessors
-    node* get_node(int n) const { return nodes_[n]; }
+    node* get_node(int n) const { solve_skeleton(); return nodes_[n]; }
     edge* get_edge(int e) const { return edges_[e]; }
     int get_root() const { return root_; }
     std::vector<edge*>& get_edges() { return edges_; }
-    std::vector<node*>& get_nodes() { return nodes_; }
+    std::vector<node*>& get_nodes() { solve_skeleton(); return nodes_; }
     double get_xpos() { node* rn = get_node(root_); return rn->get_x(); }
     double get_ypos() { node* rn = get_node(root_); return rn->get_y(); }
     int get_selected() { return selected_; }
@@ -115,21 +282,80 @@ public:
     /**
      * The weight defines the line thickness when the figure is drawn.
      */
-    void set_weight(int weight) { weight_ = weight; }
+    void set_weight(int weight) { solve_skeleton(); weight_ = weight; revision_++; }
     int get_weight() { return weight_; }
 
     /**
      * Find the edge which has the given nodes as endoints
+     * (constant time lookup through the edge index).
+     * @return The edge index or -1 if there is no such edge.
      */
     int get_edge(int n1, int n2);
 
+    /**
+     * Notify the figure that edges were changed directly (e.g. through
+     * get_edges() or edge::set_n1()) so the edge index must be rebuilt.
+     * Pending bone changes are solved first, the new revision would drop
+     * them otherwise.
+     */
+    void touch_edges()
+    {
+        solve_skeleton();
+        edge_index_valid_ = false;
+        revision_++;
+    }
+
     /**
      * Clone the figure.
      */
     void clone(figure* fig, const figure& other);
 
     // copy constructor
-    figure(const figure& other)
+    figure(const figure& other) :
+        revision_(0),
+        topology_revision_(0),
+        node_store_(),
+        skeleton_(),
+        edge_index_(),
+        edge_index_valid_(false),
+        generations_(),
+        free_nodes_(),
+        stable_handles_(false),
+        bounds_x1_(0),
+        bounds_y1_(0),
+        bounds_x2_(0),
+        bounds_y2_(0),
+        bounds_revision_(0),
+        bounds_valid_(false),
+        arena_(),
+        arena_release_(false)
+    {
+        clone(this, other);
+    }
+
+    /**
+     * Copy a figure into an arena. Cloning every figure of a frame into
+     * one arena makes copying and destroying the frame a few bulk
+     * operations instead of one per node and edge.
+     */
+    figure(const figure& other, boost::shared_ptr<graph_arena> arena) :
+        revision_(0),
+        topology_revision_(0),
+        node_store_(),
+        skeleton_(),
+        edge_index_(),
+        edge_index_valid_(false),
+        generations_(),
+        free_nodes_(),
+        stable_handles_(false),
+        bounds_x1_(0),
+        bounds_y1_(0),
+        bounds_x2_(0),
+        bounds_y2_(0),
+        bounds_revision_(0),
+        bounds_valid_(false),
+        arena_(arena),
+        arena_release_(false)
     {
         clone(this, other);
     }
@@ -173,7 +399,35 @@ public:
      */
     int create_circle(int parent, double x, double y);
 
-    meta_store* get_meta_store() { return meta_store_; }
+    /**
+     * The meta store is shared between copies of a figure, so it must only
+     * be read through this pointer (attaching cached view objects to its
+     * entries is fine). Use edit_meta_store() to add or change entries.
+     */
+    meta_store* get_meta_store() { return meta_store_.get(); }
+
+    /**
+     * The store as shared by the figures, e.g. to follow it without
+     * keeping it alive.
+     */
+    boost::shared_ptr<meta_store> get_shared_meta_store() { return meta_store_; }
+
+    /**
+     * Get the meta store for modification, first making a private copy
+     * if it is shared with other figures (copy on write).
+     */
+    meta_store* edit_meta_store()
+    {
+        if (!meta_store_.unique()) {
+            meta_store_.reset(new meta_store(*meta_store_));
+        }
+        return meta_store_.get();
+    }
+
+    /**
+     * Is the meta store shared with another figure?
+     */
+    bool is_meta_store_shared() { return !meta_store_.unique(); }
 
     /**
      * create an image defined by node and a point
@@ -219,6 +473,54 @@ public:
      */
     void scale(double factor);
 
+    /**
+     * Apply an affine transform to the given nodes in place. Nothing is
+     * allocated, so this is cheap enough for repeated interactive edits.
+     */
+    void transform(const affine& m, const std::list<int>& nodes);
+
+    /**
+     * Apply an affine transform to every node in place.
+     */
+    void transform(const affine& m);
+
+    /**
+     * Rotate the whole figure about its root node.
+     * @param angle The angle in radians
+     */
+    void rotate(double angle);
+
+    /**
+     * Local space editing. Every node is the end of a bone from its parent,
+     * with a length and an angle relative to the parent bone. Changing a
+     * bone is a constant time write; the node and everything below it are
+     * moved by the next solve_skeleton(). The bones are built from the
+     * world positions on first use and again after world space edits.
+     * @note Every access to the nodes (get_node(), get_nodes(),
+     *       get_node_store(), get_bounds()), copies, saves and world space
+     *       edits solve first, so bone changes are never seen stale or lost.
+     *       Only the bone edits themselves are deferred.
+     */
+    void rotate_bone(int n, double angle);
+    void set_bone_angle(int n, double angle);
+    void set_bone_length(int n, double length);
+    double get_bone_angle(int n);
+    double get_bone_length(int n);
+
+    /**
+     * Are there bone changes not yet applied to the nodes?
+     */
+    bool is_skeleton_dirty() const { return skeleton_.is_dirty(); }
+
+    /**
+     * Forward kinematics: move the nodes below the bones changed since the
+     * last solve. Meant to be called once per paint, not per edit.
+     * Solving does not change the pose the figure describes, so it is
+     * allowed on a const figure.
+     * @return The number of nodes moved
+     */
+    int solve_skeleton() const;
+
     /**
      * Decrease line thickness.
      */
@@ -231,29 +533,194 @@ public:
 
     virtual void print(std::ostream& os) const;
 
+    /**
+     * The revision is bumped whenever a node of the figure moves, an edge is
+     * removed or the node topology changes. Callers can compare revisions to tell when
+     * data derived from the figure must be recomputed.
+     */
+    unsigned long get_revision() const { return revision_; }
+    unsigned long get_topology_revision() const { return topology_revision_; }
+
+    /**
+     * Have a listener told about the next revision bump, and about the
+     * figure being destroyed. Indexes over many figures use this to learn
+     * which figures changed instead of comparing every revision. There is
+     * one listener at a time, NULL detaches it.
+     */
+    void set_change_listener(revision_listener* listener) { revision_.set_listener(listener); }
+
+    /**
+     * Get the packed (structure of arrays) copy of the nodes. The store is
+     * rebuilt on demand when the figure has changed since it was last
+     * packed, so the reference is only valid until the next modification.
+     * @note Edits made directly through get_nodes() are not tracked and
+     *       require a call to touch_topology().
+     */
+    const node_store& get_node_store();
+
+    /**
+     * Notify the figure that the node topology (parents, children or the
+     * node list itself) has changed.
+     */
+    void touch_topology()
+    {
+        topology_revision_++;
+        revision_++;
+    }
+
+    /**
+     * Get the axis aligned bounding box of the figure: all live nodes plus
+     * the full extent of circle edges. Image edges are approximated by a
+     * circle with a radius of the edge length around the edge midpoint,
+     * which covers images up to a width/height ratio of about 1.7.
+     * The box is cached and only recomputed after the figure changed.
+     * Line weight is not included.
+     * @return false if the figure has no live nodes
+     */
+    bool get_bounds(double& x1, double& y1, double& x2, double& y2);
+
+    /**
+     * The arena the nodes and edges are allocated from, empty if they are
+     * allocated individually.
+     */
+    boost::shared_ptr<graph_arena> get_arena() const { return arena_; }
+
+    /**
+     * Leave the nodes and edges allocated from the arena to it when the
+     * figure is deleted, instead of freeing them one by one; they go when
+     * the arena does. For figures deleted together with the rest of their
+     * arena's users, see frame::delete_figures().
+     */
+    void set_arena_release() { arena_release_ = true; }
+
 private:
 
     /**
-     * Remove a single node from the node list
-     * NOTE: Accounting for edges which are linked to this
-     * node must be done for prior to calling this.
+     * Allocate and free nodes and edges, from the arena if there is one.
+     */
+    node* alloc_node(int parent, double x, double y)
+    {
+        return arena_ ? arena_->create_node(parent, x, y) : new node(parent, x, y);
+    }
+
+    edge* alloc_edge(edge::edge_type type, int n1, int n2)
+    {
+        return arena_ ? arena_->create_edge(type, n1, n2) : new edge(type, n1, n2);
+    }
+
+    edge* alloc_edge(const edge& other)
+    {
+        return arena_ ? arena_->create_edge(other) : new edge(other);
+    }
+
+    void free_node(node* n)
+    {
+        if (arena_) {
+            arena_->destroy(n);
+        }
+        else {
+            delete n;
+        }
+    }
+
+    void free_edge(edge* e)
+    {
+        if (arena_) {
+            arena_->destroy(e);
+        }
+        else {
+            delete e;
+        }
+    }
+
+    /**
+     * Place a node into the node list, reusing an empty slot if there is one.
+     * @return The new node index
+     */
+    int insert_node(node* n);
+
+    /**
+     * Delete a single node, leaving an empty slot. The node is removed from
+     * its parent's child list but edges are not touched.
+     */
+    void release_node(int nindex);
+
+    /**
+     * Remove the subtree below nindex (and nindex itself if requested)
+     * along with all edges touching it, leaving empty slots.
+     */
+    void release_subtree(int nindex, bool include_root);
+
+    /**
+     * Get the skeleton, rebuilt from the nodes if they changed since it
+     * was last built or solved.
+     */
+    skeleton& get_skeleton();
+
+    /**
+     * Append an edge to the edge list and the edge index.
+     * @return The new edge index
      */
-    void remove_node(int nindex);
+    int add_edge(edge* e);
+
+    /**
+     * Rebuild the (n1, n2) -> edge index lookup table.
+     */
+    void build_edge_index();
+
+    /**
+     * Attach a node to the revision counter of this figure.
+     */
+    void adopt_node(node* n)
+    {
+        if (n != NULL) {
+            n->set_revision(&revision_);
+        }
+    }
 
 protected:
     friend class boost::serialization::access;
     friend std::ostream& operator<<(std::ostream &os, const figure &f);
 
 	template<class Archive>
-    void serialize(Archive & ar, const unsigned int version)
+    void save(Archive & ar, const unsigned int version) const
 	{
-        ar & BOOST_SERIALIZATION_NVP(root_);
-        ar & BOOST_SERIALIZATION_NVP(edges_);
-        ar & BOOST_SERIALIZATION_NVP(nodes_);
-        ar & BOOST_SERIALIZATION_NVP(weight_);
-        ar & BOOST_SERIALIZATION_NVP(meta_store_);
+        solve_skeleton();
+        ar << BOOST_SERIALIZATION_NVP(root_);
+        ar << BOOST_SERIALIZATION_NVP(edges_);
+        ar << BOOST_SERIALIZATION_NVP(nodes_);
+        ar << BOOST_SERIALIZATION_NVP(weight_);
+        ar << BOOST_SERIALIZATION_NVP(meta_store_);     // stores shared by several figures are written once
     }
 
+	template<class Archive>
+    void load(Archive & ar, const unsigned int version)
+	{
+        ar >> BOOST_SERIALIZATION_NVP(root_);
+        ar >> BOOST_SERIALIZATION_NVP(edges_);
+        ar >> BOOST_SERIALIZATION_NVP(nodes_);
+        ar >> BOOST_SERIALIZATION_NVP(weight_);
+        if (version >= 1) {
+            ar >> BOOST_SERIALIZATION_NVP(meta_store_);
+        }
+        else {
+            // before version 1 every figure owned its meta store
+            meta_store* meta = NULL;
+            ar >> boost::serialization::make_nvp("meta_store_", meta);
+            meta_store_.reset(meta);
+        }
+
+        // loaded nodes must report their changes to this figure
+        BOOST_FOREACH(node* n, nodes_) {
+            adopt_node(n);
+        }
+        generations_.assign(nodes_.size(), 0);
+        free_nodes_.clear();
+        touch_topology();
+    }
+
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+
 public:
     int root_;
     std::vector<edge*> edges_;
@@ -264,11 +731,39 @@ public:
     int pivot_;
 
     bool is_enabled_;
-    meta_store* meta_store_;   // metadata lookup for images
+    boost::shared_ptr<meta_store> meta_store_;     // metadata lookup for images, copy on write
+
+private:
+    revision_counter revision_;         // bumped on any node change
+    unsigned long topology_revision_;   // bumped on node list / parent / child changes
+    node_store node_store_;             // packed copy of nodes_, see get_node_store()
+    mutable skeleton skeleton_;         // local space pose, see rotate_bone()
+
+    // (n1, n2) -> index of the first edge with those endpoints
+    typedef boost::unordered_map<std::pair<int, int>, int> edge_index_map;
+    edge_index_map edge_index_;
+    bool edge_index_valid_;
+
+    std::vector<unsigned> generations_; // generation of each node slot, see node_handle
+    std::vector<int> free_nodes_;       // empty node slots available for reuse
+    bool stable_handles_;
+
+    // cached result of get_bounds(), valid while revision_ == bounds_revision_
+    double bounds_x1_;
+    double bounds_y1_;
+    double bounds_x2_;
+    double bounds_y2_;
+    unsigned long bounds_revision_;
+    bool bounds_valid_;
+
+    boost::shared_ptr<graph_arena> arena_;  // node / edge storage, empty = heap
+    bool arena_release_;                    // arena objects are freed with the arena
 };
 
 BOOST_SERIALIZATION_ASSUME_ABSTRACT(figure)
 
 };  // namespace stan
 
+BOOST_CLASS_VERSION(stan::figure, 1)
+
 #endif  // _FIGURE_H
@@ -5,6 +5,7 @@ namespace stan {
 // static constants
 //const int frame::DEFAULT_WIDTH;
 //const int frame::DEFAULT_HEIGHT;
+boost::detail::atomic_count frame::next_serial_(0);
 
 std::ostream& operator<<(std::ostream &os, const frame &f)
 {
@@ -14,32 +15,47 @@ std::ostream& operator<<(std::ostream &os, const frame &f)
 
 bool frame::get_figure_at_pos(int x, int y, int radius, figure*& fig, int& n)
 {
-    bool found = false;
-
-    BOOST_FOREACH(figure* f, figures_) {
-        // node positions relative to frame
-        if (f->get_node_at_pos(n, x - xpos_, y - ypos_, radius)) {
-            fig = f;
-            found = true;
-            break;
-        }
+    if (grid_ == NULL) {
+        grid_ = new spatial_grid();
     }
 
-    return found;
+    // re-index figures which moved since the last hit-test, the list
+    // itself is only walked after it changed
+    grid_->sync(figures_, revision_);
+
+    // node positions relative to frame
+    return grid_->find(x - xpos_, y - ypos_, radius, fig, n);
+}
+
+void frame::delete_figures()
+{
+    delete grid_;
+    grid_ = NULL;
+
+    BOOST_FOREACH(figure* fig, figures_) {
+        if (arena_ && (fig->get_arena() == arena_)) {
+            fig->set_arena_release();
+        }
+        delete fig;
+    }
+    figures_.clear();
+    arena_.reset();
+    touch();
 }
 
-void frame::break_figure(figure* fig, int nindex)
+figure* frame::break_figure(figure* fig, int nindex)
 {
     std::cout << "frame::break_figure." << std::endl;
 
     // construct a new figure out of list and root with given position offset
     figure* nfig = new figure();
     nfig->clone_subtree(fig, nindex, -1);
-    figures_.push_back(nfig);
+    add_figure(nfig);
     nfig->move(20, 20); // offset the new figure so we can see it
 
     // remove decendant nodes from original figure
     // TODO: fig->remove_nodes(nindex);
+    return nfig;
 }
 
 };  // namespace stan
@@ -6,6 +6,7 @@
 #include <list>
 #include <hash_map>
 #include <boost/foreach.hpp>
+#include <boost/detail/atomic_count.hpp>
 
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/utility.hpp>
@@ -21,6 +22,7 @@
 #include <boost/serialization/export.hpp>
 
 #include "figure.h"
+#include "spatial_grid.h"
 
 namespace stan {
 
@@ -38,7 +40,11 @@ public:
         image_index_(-1),
         sound_index_(-1),
         width_(DEFAULT_WIDTH),
-        height_(DEFAULT_HEIGHT)
+        height_(DEFAULT_HEIGHT),
+        grid_(NULL),
+        serial_(++next_serial_),
+        revision_(0),
+        arena_()
     {
     }
 
@@ -49,12 +55,19 @@ public:
         image_index_(-1),
         sound_index_(-1),
         width_(width),
-        height_(height)
+        height_(height),
+        grid_(NULL),
+        serial_(++next_serial_),
+        revision_(0),
+        arena_()
     {
     }
 
-    virtual ~frame() {}
+    virtual ~frame() { delete grid_; }
 
+    /**
+     * Direct changes to the list must be followed by touch().
+     */
     std::list<figure*>& get_figures() { return figures_; };
 
     int get_xpos() { return xpos_; };
@@ -74,15 +87,22 @@ public:
         fr->image_index_ = other.image_index_;
         fr->sound_index_ = other.sound_index_;
 
-        // copy the list of figures
+        // copy the list of figures, all into one arena so duplicating a
+        // frame costs a few chunk allocations instead of one per node
+        boost::shared_ptr<graph_arena> arena(new graph_arena());
         BOOST_FOREACH(figure* fig, other.figures_) {
-            figure* new_fig = new figure(*fig);
+            figure* new_fig = new figure(*fig, arena);
             fr->figures_.push_front(new_fig);
         }
+        fr->arena_ = arena;
     }
 
     // copy constructor
-    frame(const frame& other)
+    frame(const frame& other) :
+        grid_(NULL),
+        serial_(++next_serial_),
+        revision_(0),
+        arena_()
     {
         clone(this, other);
     }
@@ -93,6 +113,7 @@ public:
         if (this != &other)
         {
             clone(this, other);
+            touch();
         }
         return *this;
     }
@@ -104,13 +125,25 @@ public:
     void add_figure(figure* fig)
     {
         figures_.push_back(fig);
+        touch();
     }
 
     void remove_figure(figure* fig)
     {
         figures_.remove(fig);
+        touch();
+        if (grid_ != NULL) {
+            grid_->remove_figure(fig);
+        }
     }
 
+    /**
+     * Delete all figures of the frame. Figures cloned into the frame's
+     * arena leave their nodes and edges to it, so the arena is released
+     * in one go instead of with an ordered free per object.
+     */
+    void delete_figures();
+
     /**
      * Get the first figure in the vector.
      */
@@ -132,11 +165,14 @@ public:
     {
         figures_.remove(fig);
         figures_.push_front(fig);
+        touch();
     }
 
     /**
      * Determine if a figure exists at (x,y) within this frame. If so return a pointer
-     * to it.
+     * to it. Uses the frame's spatial grid, so only figures which reported a
+     * change since the last call are re-indexed and only nodes near (x,y)
+     * are tested.
      * @param x The x position within the frame.
      * @param y The y position within the frame.
      * @param radius Distance from point to consider a hit
@@ -154,14 +190,39 @@ public:
         return false;
     }
 
-    void set_image_index(int index) { image_index_ = index; }
+    void set_image_index(int index) { image_index_ = index; touch(); }
+
+    void set_sound_index(int index) { sound_index_ = index; touch(); }
+
+    /**
+     * The serial number identifies this frame object for the lifetime of
+     * the process (copies get a new one). The revision is bumped when the
+     * figure list or a frame property changes; changes inside the figures
+     * are tracked by the figure revisions.
+     */
+    unsigned long get_serial() const { return serial_; }
+    unsigned long get_revision() const { return revision_; }
+    void touch() { revision_++; }
 
-    void set_sound_index(int index) { sound_index_ = index; }
+    /**
+     * Collect the revision of the frame followed by the revision of each
+     * figure. Two stamps of the same frame (same serial) are equal only if
+     * nothing which is saved changed in between.
+     */
+    void get_stamp(std::vector<unsigned long>& stamp) const
+    {
+        stamp.clear();
+        stamp.push_back(revision_);
+        BOOST_FOREACH(figure* f, figures_) {
+            stamp.push_back(f->get_revision());
+        }
+    }
 
     /**
      * Break the specified figure in two at the given node
+     * @return The new figure, added to the frame
      */
-    void break_figure(figure* fig, int nindex);
+    figure* break_figure(figure* fig, int nindex);
 
     virtual void print(std::ostream& os) const
     {
@@ -197,6 +258,11 @@ private:
     int height_;
     int image_index_;   // index into meta_data stored in animation
     int sound_index_; 
+    spatial_grid* grid_;    // hit-test index, built on first use (not serialized)
+    unsigned long serial_;      // unique per frame object (not serialized)
+    unsigned long revision_;    // bumped on frame changes (not serialized)
+    boost::shared_ptr<graph_arena> arena_;     // storage of the figures cloned by clone()
+    static boost::detail::atomic_count next_serial_;
     static const int DEFAULT_WIDTH = 100;
     static const int DEFAULT_HEIGHT = 100;
 };
@@ -0,0 +1,123 @@
+#ifndef _GRAPH_ARENA_H
+#define _GRAPH_ARENA_H       1
+
+/**
+ * @file graph_arena.h
+ * @brief Pooled storage for the nodes and edges of one or more figures.
+ * @date 10-18-26
+ */
+
+#include <new>
+
+#include <boost/pool/object_pool.hpp>
+
+#include "node.h"
+#include "edge.h"
+
+namespace stan {
+
+/**
+ * Nodes and edges are carved out of large chunks instead of being
+ * allocated one by one, so cloning a figure (or every figure of a frame
+ * sharing the arena) touches the heap only a few times. Objects removed
+ * while the arena is in use are destroyed and their slots reused; when
+ * the last figure using the arena goes away all chunks are released at
+ * once.
+ *
+ * Objects not created by the arena (e.g. deserialized nodes) are accepted
+ * by destroy() and deleted normally. Not thread safe: figures sharing an
+ * arena must be edited by one thread at a time.
+ */
+class graph_arena
+{
+public:
+    graph_arena() :
+        nodes_(),
+        edges_(),
+        node_count_(0),
+        edge_count_(0)
+    {
+    }
+
+    virtual ~graph_arena() {}
+
+    node* create_node(int parent, double x, double y)
+    {
+        node* n = new (allocate(nodes_)) node(parent, x, y);
+        node_count_++;
+        return n;
+    }
+
+    edge* create_edge(edge::edge_type type, int n1, int n2)
+    {
+        edge* e = new (allocate(edges_)) edge(type, n1, n2);
+        edge_count_++;
+        return e;
+    }
+
+    edge* create_edge(const edge& other)
+    {
+        edge* e = new (allocate(edges_)) edge(other);
+        edge_count_++;
+        return e;
+    }
+
+    void destroy(node* n)
+    {
+        if (nodes_.is_from(n)) {
+            nodes_.destroy(n);
+            node_count_--;
+        }
+        else {
+            delete n;
+        }
+    }
+
+    void destroy(edge* e)
+    {
+        if (edges_.is_from(e)) {
+            edges_.destroy(e);
+            edge_count_--;
+        }
+        else {
+            delete e;
+        }
+    }
+
+    /**
+     * Was the object created by this arena?
+     */
+    bool owns(node* n) const { return nodes_.is_from(n); }
+    bool owns(edge* e) const { return edges_.is_from(e); }
+
+    /**
+     * Number of live nodes / edges created by the arena.
+     */
+    int get_node_count() const { return node_count_; }
+    int get_edge_count() const { return edge_count_; }
+
+private:
+    template <class T>
+    static void* allocate(boost::object_pool<T>& pool)
+    {
+        // parenthesized, malloc may be a macro (e.g. debug CRT)
+        void* p = (pool.malloc)();
+        if (p == NULL) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    // not copyable, objects belong to exactly one arena
+    graph_arena(const graph_arena&);
+    graph_arena& operator=(const graph_arena&);
+
+    boost::object_pool<node> nodes_;
+    boost::object_pool<edge> edges_;
+    int node_count_;
+    int edge_count_;
+};
+
+};  // namespace stan
+
+#endif  // _GRAPH_ARENA_H
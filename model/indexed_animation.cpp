@@ -0,0 +1,435 @@
+/**
+ * @file indexed_animation.cpp
+ * @brief Implementation of the random access animation container.
+ * @date 10-18-26
+ */
+
+#include <fstream>
+#include <streambuf>
+#include <cstring>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include "indexed_animation.h"
+
+namespace stan {
+
+namespace {
+
+const char INDEX_MAGIC[] = "STANIDX1";
+const std::size_t INDEX_MAGIC_SIZE = 8;
+const boost::uint32_t INDEX_VERSION = 2;
+
+// magic, version, reserved, table offset
+const std::size_t HEADER_SIZE = INDEX_MAGIC_SIZE + 4 + 4 + 8;
+// frame count, reserved, meta offset and size
+const std::size_t TABLE_HEADER_SIZE = 4 + 4 + 8 + 8;
+const std::size_t TABLE_ENTRY_SIZE = 8 + 8;
+
+// dead bytes tolerated before an incremental save rewrites the file
+const boost::uint64_t MIN_GARBAGE = 64 * 1024;
+
+void put_u32(std::string& buf, boost::uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        buf += static_cast<char>((v >> (i * 8)) & 0xFF);
+    }
+}
+
+void put_u64(std::string& buf, boost::uint64_t v)
+{
+    for (int i = 0; i < 8; i++) {
+        buf += static_cast<char>((v >> (i * 8)) & 0xFF);
+    }
+}
+
+boost::uint32_t get_u32(const char* p)
+{
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    boost::uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) {
+        v = (v << 8) | u[i];
+    }
+    return v;
+}
+
+boost::uint64_t get_u64(const char* p)
+{
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    boost::uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | u[i];
+    }
+    return v;
+}
+
+/**
+ * Read-only stream buffer over a block of memory, so archives can be
+ * loaded from the mapping without copying.
+ */
+class memory_buf : public std::streambuf
+{
+public:
+    memory_buf(const char* data, std::size_t size)
+    {
+        char* p = const_cast<char*>(data);
+        setg(p, p, p + size);
+    }
+};
+
+/**
+ * Append one object as a binary archive and return where it was put.
+ */
+template <class T>
+bool write_payload(std::ostream& ofs, T* obj, const char* name, boost::uint64_t& offset, boost::uint64_t& size)
+{
+    std::streampos start = ofs.tellp();
+    {
+        boost::archive::binary_oarchive oa(ofs);
+        oa << boost::serialization::make_nvp(name, obj);
+    }
+    std::streampos end = ofs.tellp();
+
+    offset = static_cast<boost::uint64_t>(start);
+    size = static_cast<boost::uint64_t>(end - start);
+    return ofs.good();
+}
+
+template <class T>
+T* read_payload(const char* data, std::size_t size, const char* name)
+{
+    T* obj = NULL;
+    try {
+        memory_buf buf(data, size);
+        std::istream is(&buf);
+        boost::archive::binary_iarchive ia(is);
+        ia >> boost::serialization::make_nvp(name, obj);
+    }
+    catch (boost::archive::archive_exception& e) {
+        std::cerr << "Error loading indexed payload: " << e.what() << std::endl;
+        obj = NULL;
+    }
+    return obj;
+}
+
+std::string encode_header(boost::uint64_t table_offset)
+{
+    std::string header(INDEX_MAGIC, INDEX_MAGIC_SIZE);
+    put_u32(header, INDEX_VERSION);
+    put_u32(header, 0);
+    put_u64(header, table_offset);
+    return header;
+}
+
+std::string encode_table(const payload_entry& meta, const std::vector<payload_entry>& entries)
+{
+    std::string table;
+    put_u32(table, static_cast<boost::uint32_t>(entries.size()));
+    put_u32(table, 0);
+    put_u64(table, meta.offset_);
+    put_u64(table, meta.size_);
+    BOOST_FOREACH(const payload_entry& entry, entries) {
+        put_u64(table, entry.offset_);
+        put_u64(table, entry.size_);
+    }
+    return table;
+}
+
+bool is_inside(const payload_entry& entry, boost::uint64_t file_size)
+{
+    return (entry.offset_ <= file_size) && (entry.size_ <= file_size - entry.offset_);
+}
+
+/**
+ * Frames do not own their figures, so evicted frames are freed here.
+ */
+void delete_frame(frame* fr)
+{
+    fr->delete_figures();
+    delete fr;
+}
+
+};  // anonymous namespace
+
+indexed_animation::indexed_animation(unsigned resident_limit) :
+    mapping_(NULL),
+    region_(NULL),
+    entries_(),
+    meta_store_(NULL),
+    resident_(resident_limit)
+{
+}
+
+indexed_animation::~indexed_animation()
+{
+    close();
+}
+
+bool indexed_animation::write(animation* anim, const std::string& path)
+{
+    indexed_writer writer;
+    return writer.save(anim, path);
+}
+
+bool indexed_animation::has_signature(const char* data, std::size_t size)
+{
+    return (size >= INDEX_MAGIC_SIZE) && (memcmp(data, INDEX_MAGIC, INDEX_MAGIC_SIZE) == 0);
+}
+
+bool indexed_animation::open(const std::string& path)
+{
+    close();
+
+    try {
+        mapping_ = new boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+        region_ = new boost::interprocess::mapped_region(*mapping_, boost::interprocess::read_only);
+    }
+    catch (boost::interprocess::interprocess_exception& e) {
+        std::cerr << "Unable to map file: " << path << ": " << e.what() << std::endl;
+        close();
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(region_->get_address());
+    boost::uint64_t file_size = region_->get_size();
+
+    if ( (file_size < HEADER_SIZE) || !has_signature(data, file_size) ||
+         (get_u32(data + INDEX_MAGIC_SIZE) != INDEX_VERSION) ) {
+        std::cerr << "Not an indexed animation: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    boost::uint64_t table_offset = get_u64(data + INDEX_MAGIC_SIZE + 8);
+    if ( (table_offset < HEADER_SIZE) || (table_offset > file_size - TABLE_HEADER_SIZE) ) {
+        std::cerr << "Missing frame table: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    const char* table = data + table_offset;
+    boost::uint32_t count = get_u32(table);
+    if ( (file_size - table_offset - TABLE_HEADER_SIZE) / TABLE_ENTRY_SIZE < count ) {
+        std::cerr << "Truncated frame table: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    // reject payloads outside of the file so get_frame() never reads past
+    // the mapping
+    payload_entry meta(get_u64(table + 8), get_u64(table + 16));
+    bool valid = is_inside(meta, file_size);
+
+    table += TABLE_HEADER_SIZE;
+    for (boost::uint32_t i = 0; valid && (i < count); i++) {
+        payload_entry entry(get_u64(table), get_u64(table + 8));
+        valid = is_inside(entry, file_size);
+        entries_.push_back(entry);
+        table += TABLE_ENTRY_SIZE;
+    }
+
+    if (valid) {
+        meta_store_ = read_payload<meta_store>(data + meta.offset_, static_cast<std::size_t>(meta.size_), "meta_store");
+    }
+    if (meta_store_ == NULL) {
+        std::cerr << "Corrupt indexed animation: " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void indexed_animation::close()
+{
+    resident_.clear();
+    entries_.clear();
+
+    delete meta_store_;
+    meta_store_ = NULL;
+    delete region_;
+    region_ = NULL;
+    delete mapping_;
+    mapping_ = NULL;
+}
+
+boost::shared_ptr<frame> indexed_animation::get_frame(int n)
+{
+    if ( (n < 0) || (n >= get_frame_count()) ) {
+        return frame_ptr();
+    }
+
+    frame_ptr* cached = resident_.get(n);
+    if (cached != NULL) {
+        return *cached;
+    }
+
+    frame* fr = read_frame(entries_[n]);
+    if (fr == NULL) {
+        return frame_ptr();
+    }
+
+    frame_ptr ptr(fr, delete_frame);
+    resident_.put(n, ptr, 1);
+    return ptr;
+}
+
+animation* indexed_animation::load_all()
+{
+    if (!is_open()) {
+        return NULL;
+    }
+
+    animation* anim = new animation();
+    *anim->get_meta_store() = *meta_store_;
+
+    // bypass the resident cache, the animation owns these frames
+    BOOST_FOREACH(const payload_entry& entry, entries_) {
+        frame* fr = read_frame(entry);
+        if (fr == NULL) {
+            delete anim;
+            return NULL;
+        }
+        anim->add_frame(fr);
+    }
+    return anim;
+}
+
+frame* indexed_animation::read_frame(const payload_entry& entry)
+{
+    const char* data = static_cast<const char*>(region_->get_address());
+    return read_payload<frame>(data + entry.offset_, static_cast<std::size_t>(entry.size_), "frame");
+}
+
+indexed_writer::indexed_writer() :
+    path_(),
+    records_(),
+    meta_entry_(0, 0),
+    meta_count_(0),
+    file_size_(0),
+    live_size_(0),
+    save_count_(0),
+    written_frames_(0)
+{
+}
+
+void indexed_writer::reset()
+{
+    path_.clear();
+    records_.clear();
+    file_size_ = 0;
+    live_size_ = 0;
+}
+
+bool indexed_writer::save(animation* anim, const std::string& path, const edit_journal* history)
+{
+    assert(anim != NULL);
+
+    // drop empty node slots left by cuts (a no-op for dense figures, so
+    // unchanged frames keep their stamps)
+    compact_animation(anim, history);
+
+    // append only to the file written last time, and only if nobody else
+    // touched it since
+    bool full = (path != path_);
+    if (!full) {
+        std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+        full = !ifs.good() || (static_cast<boost::uint64_t>(ifs.tellg()) != file_size_);
+    }
+    if (!full && (file_size_ - live_size_ > MIN_GARBAGE) && (file_size_ - live_size_ > live_size_)) {
+        full = true;
+    }
+
+    if (!write_file(anim, path, full)) {
+        reset();
+        return false;
+    }
+    path_ = path;
+    return true;
+}
+
+bool indexed_writer::write_file(animation* anim, const std::string& path, bool full)
+{
+    std::fstream fs;
+    if (full) {
+        fs.open(path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    }
+    else {
+        fs.open(path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    }
+    if (!fs.good()) {
+        std::cerr << "Unable to write file: " << path << std::endl;
+        return false;
+    }
+
+    if (full) {
+        // the header is written last, once the table position is known
+        std::string placeholder(HEADER_SIZE, '\0');
+        fs.write(placeholder.data(), placeholder.size());
+    }
+    else {
+        fs.seekp(0, std::ios::end);
+    }
+
+    save_count_++;
+    written_frames_ = 0;
+
+    // the meta store only grows, its size tells whether it changed
+    meta_store* meta = anim->get_meta_store();
+    if (full || (meta->get_meta_table().size() != meta_count_)) {
+        if (!write_payload(fs, meta, "meta_store", meta_entry_.offset_, meta_entry_.size_)) {
+            return false;
+        }
+        meta_count_ = meta->get_meta_table().size();
+    }
+    live_size_ = HEADER_SIZE + meta_entry_.size_;
+
+    std::vector<payload_entry> entries;
+    std::vector<unsigned long> stamp;
+    BOOST_FOREACH(frame* fr, anim->get_frames()) {
+        fr->get_stamp(stamp);
+
+        frame_record& record = records_[fr->get_serial()];
+        if (full || (record.seen_ == 0) || (record.stamp_ != stamp)) {
+            if (!write_payload(fs, fr, "frame", record.entry_.offset_, record.entry_.size_)) {
+                return false;
+            }
+            record.stamp_ = stamp;
+            written_frames_++;
+        }
+        record.seen_ = save_count_;
+
+        entries.push_back(record.entry_);
+        live_size_ += record.entry_.size_;
+    }
+
+    // forget frames which are no longer part of the animation
+    record_map::iterator iter = records_.begin();
+    while (iter != records_.end()) {
+        if (iter->second.seen_ != save_count_) {
+            iter = records_.erase(iter);
+        }
+        else {
+            iter++;
+        }
+    }
+
+    boost::uint64_t table_offset = static_cast<boost::uint64_t>(fs.tellp());
+    std::string table = encode_table(meta_entry_, entries);
+    fs.write(table.data(), table.size());
+    live_size_ += table.size();
+    file_size_ = table_offset + table.size();
+
+    // everything the new table refers to has to be on disk before the
+    // header points to it
+    fs.flush();
+    std::string header = encode_header(table_offset);
+    fs.seekp(0);
+    fs.write(header.data(), header.size());
+    fs.flush();
+    return fs.good();
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,199 @@
+#ifndef _INDEXED_ANIMATION_H
+#define _INDEXED_ANIMATION_H       1
+
+/**
+ * @file indexed_animation.h
+ * @brief Random access animation container. Frames are stored as
+ *        separate payloads behind an offset table and are only
+ *        deserialized when requested.
+ * @date 10-18-26
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "animation.h"
+#include "archive_io.h"
+#include "lru_cache.h"
+
+namespace stan {
+
+/**
+ * Position and size of a payload within an indexed file.
+ */
+class payload_entry
+{
+public:
+    payload_entry(boost::uint64_t offset, boost::uint64_t size) :
+        offset_(offset),
+        size_(size)
+    {
+    }
+
+    boost::uint64_t offset_;
+    boost::uint64_t size_;
+};
+
+/**
+ * File layout (all integers little endian):
+ *
+ *   header: magic "STANIDX1", u32 version, u32 reserved, u64 table offset
+ *   payloads: meta store and frames, in any order
+ *   table: u32 frame count, u32 reserved, u64 meta offset, u64 meta size,
+ *          frame count x (u64 offset, u64 size)
+ *
+ * Every payload is a self contained boost binary archive, so a frame can
+ * be read straight out of the memory mapped file without touching the
+ * others. Materialized frames are kept in an LRU cache; the OS pages the
+ * mapping in and out as needed. Only the table the header points to is
+ * live, older tables and payloads are left behind by incremental saves
+ * (see indexed_writer).
+ *
+ * @note Frames returned by get_frame() are read-only snapshots: changes
+ *       are lost once the frame is evicted. Use load_all() to edit.
+ */
+class indexed_animation
+{
+public:
+    static const unsigned DEFAULT_RESIDENT_FRAMES = 64;
+
+    indexed_animation(unsigned resident_limit = DEFAULT_RESIDENT_FRAMES);
+    virtual ~indexed_animation();
+
+    /**
+     * Write an animation in the indexed format, compacting its figures.
+     * @return false if the file could not be written
+     */
+    static bool write(animation* anim, const std::string& path);
+
+    /**
+     * Does a file header start with the indexed format magic?
+     */
+    static bool has_signature(const char* data, std::size_t size);
+
+    /**
+     * Map a file and read its offset table and meta store.
+     * @return false if the file can not be mapped or is not valid
+     */
+    bool open(const std::string& path);
+    void close();
+    bool is_open() { return region_ != NULL; }
+
+    int get_frame_count() { return static_cast<int>(entries_.size()); }
+
+    /**
+     * Get a frame, deserializing it if it is not resident. The frame stays
+     * valid as long as the returned pointer is held, even if it is evicted.
+     * @return The frame or an empty pointer if out of range or corrupt
+     */
+    boost::shared_ptr<frame> get_frame(int n);
+
+    /**
+     * The animation meta store (paths only, the view still has to load
+     * the meta data itself).
+     */
+    meta_store* get_meta_store() { return meta_store_; }
+
+    /**
+     * Materialize the complete animation.
+     * @return A new animation owned by the caller or NULL on failure
+     */
+    animation* load_all();
+
+    void set_resident_limit(unsigned limit) { resident_.set_budget(limit); }
+    unsigned get_resident_limit() { return static_cast<unsigned>(resident_.get_budget()); }
+    unsigned get_resident_count() { return static_cast<unsigned>(resident_.size()); }
+
+private:
+    typedef boost::shared_ptr<frame> frame_ptr;
+
+    // not copyable
+    indexed_animation(const indexed_animation&);
+    indexed_animation& operator=(const indexed_animation&);
+
+    /**
+     * Deserialize a frame payload, NULL on failure.
+     */
+    frame* read_frame(const payload_entry& entry);
+
+    boost::interprocess::file_mapping* mapping_;
+    boost::interprocess::mapped_region* region_;
+    std::vector<payload_entry> entries_;
+    meta_store* meta_store_;
+    lru_cache<int, frame_ptr> resident_;     // cost of one per frame
+};
+
+/**
+ * Saves animations in the indexed format, reusing the payloads of frames
+ * which did not change since the previous save to the same file. Changed
+ * frames are appended together with a new table, then the header is
+ * switched over to it, so an interrupted save leaves the previous version
+ * intact. Once more than half of the file is dead the next save rewrites
+ * it from scratch.
+ *
+ * Frames are identified by frame::get_serial() and a frame is rewritten
+ * when its frame::get_stamp() differs from the one recorded at the
+ * previous save.
+ */
+class indexed_writer
+{
+public:
+    indexed_writer();
+    virtual ~indexed_writer() {}
+
+    /**
+     * Save an animation, compacting figures with empty node slots unless
+     * the edit history refers to them (see compact_animation()).
+     * @return false if the file could not be written
+     */
+    bool save(animation* anim, const std::string& path, const edit_journal* history = NULL);
+
+    /**
+     * Forget the previous save, the next one rewrites the whole file.
+     */
+    void reset();
+
+    /**
+     * Number of frame payloads serialized by the last save.
+     */
+    int get_written_frames() { return written_frames_; }
+
+private:
+    class frame_record
+    {
+    public:
+        frame_record() :
+            stamp_(),
+            entry_(0, 0),
+            seen_(0)
+        {
+        }
+
+        std::vector<unsigned long> stamp_;
+        payload_entry entry_;
+        unsigned seen_;         // save count when last written or reused
+    };
+
+    typedef boost::unordered_map<unsigned long, frame_record> record_map;
+
+    bool write_file(animation* anim, const std::string& path, bool full);
+
+    std::string path_;                  // file of the previous save
+    record_map records_;                // by frame serial
+    payload_entry meta_entry_;
+    std::size_t meta_count_;            // meta store size when written
+    boost::uint64_t file_size_;
+    boost::uint64_t live_size_;         // bytes referenced by the live table
+    unsigned save_count_;
+    int written_frames_;
+};
+
+};  // namespace stan
+
+#endif  // _INDEXED_ANIMATION_H
@@ -0,0 +1,183 @@
+#ifndef _LRU_CACHE_H
+#define _LRU_CACHE_H       1
+
+/**
+ * @file lru_cache.h
+ * @brief Least recently used cache with a cost budget.
+ * @date 10-18-26
+ */
+
+#include <list>
+#include <cstddef>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace stan {
+
+/**
+ * Maps keys to values, each with a cost (typically its size in bytes).
+ * When the total cost exceeds the budget the least recently used entries
+ * are dropped. Values are copied in and destroyed on eviction, so owning
+ * pointers should be wrapped (e.g. boost::shared_ptr).
+ */
+template <class Key, class Value, class Hash = boost::hash<Key> >
+class lru_cache
+{
+public:
+    lru_cache(std::size_t budget) :
+        entries_(),
+        index_(),
+        budget_(budget),
+        cost_(0),
+        hits_(0),
+        misses_(0)
+    {
+    }
+
+    virtual ~lru_cache() {}
+
+    /**
+     * Look up a value and mark it as most recently used.
+     * @return Pointer to the cached value or NULL if not found. The pointer
+     *         is valid until the entry is evicted.
+     */
+    Value* get(const Key& key)
+    {
+        typename index_map::iterator iter = index_.find(key);
+        if (iter == index_.end()) {
+            misses_++;
+            return NULL;
+        }
+        hits_++;
+
+        // move to the front of the use list
+        entries_.splice(entries_.begin(), entries_, iter->second);
+        return &iter->second->value_;
+    }
+
+    /**
+     * Add or replace a value, evicting older entries to stay within the
+     * budget. The newest entry is always kept, even if it alone exceeds
+     * the budget.
+     * @return Pointer to the cached value
+     */
+    Value* put(const Key& key, const Value& value, std::size_t cost)
+    {
+        erase(key);
+
+        entries_.push_front(entry(key, value, cost));
+        index_[key] = entries_.begin();
+        cost_ += cost;
+
+        trim();
+        return &entries_.front().value_;
+    }
+
+    /**
+     * Remove an entry.
+     * @return true if the key was cached
+     */
+    bool erase(const Key& key)
+    {
+        typename index_map::iterator iter = index_.find(key);
+        if (iter == index_.end()) {
+            return false;
+        }
+
+        cost_ -= iter->second->cost_;
+        entries_.erase(iter->second);
+        index_.erase(iter);
+        return true;
+    }
+
+    /**
+     * Remove every entry whose key matches a predicate.
+     * @return The number of entries removed
+     */
+    template <class Pred>
+    std::size_t erase_if(Pred pred)
+    {
+        std::size_t count = 0;
+        typename entry_list::iterator iter = entries_.begin();
+        while (iter != entries_.end()) {
+            if (pred(iter->key_)) {
+                cost_ -= iter->cost_;
+                index_.erase(iter->key_);
+                iter = entries_.erase(iter);
+                count++;
+            }
+            else {
+                iter++;
+            }
+        }
+        return count;
+    }
+
+    void clear()
+    {
+        entries_.clear();
+        index_.clear();
+        cost_ = 0;
+    }
+
+    void set_budget(std::size_t budget)
+    {
+        budget_ = budget;
+        trim();
+    }
+
+    std::size_t get_budget() const { return budget_; }
+    std::size_t get_cost() const { return cost_; }
+    std::size_t size() const { return index_.size(); }
+
+    /**
+     * Number of get() calls which found / did not find their key.
+     */
+    unsigned long get_hits() const { return hits_; }
+    unsigned long get_misses() const { return misses_; }
+    void reset_stats() { hits_ = 0; misses_ = 0; }
+
+private:
+    class entry
+    {
+    public:
+        entry(const Key& key, const Value& value, std::size_t cost) :
+            key_(key),
+            value_(value),
+            cost_(cost)
+        {
+        }
+
+        Key key_;
+        Value value_;
+        std::size_t cost_;
+    };
+
+    typedef std::list<entry> entry_list;
+    typedef boost::unordered_map<Key, typename entry_list::iterator, Hash> index_map;
+
+    /**
+     * Drop least recently used entries until the cost is within budget.
+     */
+    void trim()
+    {
+        while ( (cost_ > budget_) && (entries_.size() > 1) ) {
+            entry& oldest = entries_.back();
+            cost_ -= oldest.cost_;
+            index_.erase(oldest.key_);
+            entries_.pop_back();
+        }
+    }
+
+    entry_list entries_;    // most recently used first
+    index_map index_;
+    std::size_t budget_;
+    std::size_t cost_;
+    unsigned long hits_;
+    unsigned long misses_;
+};
+
+};  // namespace stan
+
+#endif  // _LRU_CACHE_H
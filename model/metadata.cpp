@@ -5,10 +5,27 @@
  * @author G. Fordyce
  */
 
+#include <boost/unordered_set.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "metadata.h"
 
 namespace stan {
 
+namespace {
+
+// node based, so pooled strings never move
+boost::unordered_set<std::string> path_pool;
+boost::mutex path_pool_mutex;
+
+};  // anonymous namespace
+
+const std::string* intern_path(const std::string& path)
+{
+    boost::mutex::scoped_lock lock(path_pool_mutex);
+    return &*path_pool.insert(path).first;
+}
+
 std::ostream& operator<<(std::ostream &os, const meta_data &md)
 {
     md.print(os);
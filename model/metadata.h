@@ -13,15 +13,24 @@
 #include <vector>
 
 #include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/list.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/assume_abstract.hpp>
+#include <boost/serialization/split_member.hpp>
 
 namespace stan {
 
+/**
+ * Return the pooled copy of a path. Equal paths share one string for the
+ * lifetime of the process, so meta data copies only copy a pointer.
+ * Safe to call from any thread.
+ */
+const std::string* intern_path(const std::string& path);
+
 /**
  * Metadata types
  */
@@ -39,15 +48,17 @@ class meta_data
 public:
 
     meta_data() :
-        path_(),
+        path_(intern_path(std::string())),
         meta_ptr_(NULL),
+        meta_handle_(),
         type_(META_NONE)
     {
     }
 
     meta_data(std::string path, void* ptr, meta_type type) :
-        path_(path),
+        path_(intern_path(path)),
         meta_ptr_(ptr),
+        meta_handle_(),
         type_(type)
     {
     }
@@ -72,23 +83,30 @@ public:
     {
         md->path_ = other.path_;
         md->meta_ptr_ = other.meta_ptr_;
+        md->meta_handle_ = other.meta_handle_;
         md->type_ = other.type_;
     }
 
     virtual ~meta_data() {}
 
     // accessors
-    void set_path(std::string& path) { path_ = path; }
-    std::string get_path() { return path_; }
-    void set_meta_ptr(void *ptr) { meta_ptr_ = ptr; }
+    void set_path(std::string& path) { path_ = intern_path(path); }
+    std::string get_path() { return *path_; }
+    void set_meta_ptr(void *ptr) { meta_ptr_ = ptr; meta_handle_.reset(); }
     void* get_meta_ptr() { return meta_ptr_; }
+
+    /**
+     * Set the meta pointer to an object owned through a shared handle
+     * (e.g. from an asset cache). Copies of the meta data share it.
+     */
+    void set_meta_handle(boost::shared_ptr<void> handle) { meta_handle_ = handle; meta_ptr_ = handle.get(); }
     void set_type(meta_type type) { type_ = type; }
     meta_type get_type() { return type_; }
 
     virtual void print(std::ostream& os) const
     {
         os << "Meta data:" << std::endl;
-        os << "   path_ = " << path_ << std::endl;
+        os << "   path_ = " << *path_ << std::endl;
         os << "   meta_ptr_ = " << meta_ptr_ << std::endl;
         os << "   type_ = " << type_ << std::endl;
     }
@@ -98,15 +116,28 @@ protected:
     friend std::ostream& operator<<(std::ostream &os, const meta_data &imd);
 
 	template<class Archive>
-    void serialize(Archive & ar, const unsigned int version)
+    void save(Archive & ar, const unsigned int version) const
+	{
+        std::string path = *path_;
+        ar << boost::serialization::make_nvp("path_", path);
+        ar << BOOST_SERIALIZATION_NVP(type_);
+    }
+
+	template<class Archive>
+    void load(Archive & ar, const unsigned int version)
 	{
-        ar & BOOST_SERIALIZATION_NVP(path_);
-        ar & BOOST_SERIALIZATION_NVP(type_);
+        std::string path;
+        ar >> boost::serialization::make_nvp("path_", path);
+        path_ = intern_path(path);
+        ar >> BOOST_SERIALIZATION_NVP(type_);
     }
 
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+
 private:
-    std::string path_;
+    const std::string* path_;   // interned, see intern_path()
     void *meta_ptr_;
+    boost::shared_ptr<void> meta_handle_;   // keeps meta_ptr_ alive if set
     meta_type type_;    // image, sound, etc...
 };
 
@@ -21,6 +21,91 @@
 
 namespace stan {
 
+/**
+ * Interface for hearing about changes of a revision_counter.
+ */
+class revision_listener
+{
+public:
+    virtual ~revision_listener() {}
+
+    /**
+     * The counter was bumped for the first time since the listener was
+     * (re)attached.
+     */
+    virtual void revised() = 0;
+
+    /**
+     * The counter, and so the object owning it, is being destroyed.
+     */
+    virtual void released() = 0;
+};
+
+/**
+ * Revision counter of a figure, bumped by its nodes when they move. It reads
+ * and increments like a plain counter; a listener can be attached to be told
+ * about the next bump instead of polling the value. Copies only take the
+ * value, never the listener.
+ */
+class revision_counter
+{
+public:
+    revision_counter(unsigned long value = 0) :
+        value_(value),
+        listener_(NULL),
+        armed_(false)
+    {
+    }
+
+    revision_counter(const revision_counter& other) :
+        value_(other.value_),
+        listener_(NULL),
+        armed_(false)
+    {
+    }
+
+    ~revision_counter()
+    {
+        if (listener_ != NULL) {
+            revision_listener* listener = listener_;
+            listener_ = NULL;
+            listener->released();
+        }
+    }
+
+    revision_counter& operator=(const revision_counter& other)
+    {
+        value_ = other.value_;
+        return *this;
+    }
+
+    operator unsigned long() const { return value_; }
+
+    void operator++(int)
+    {
+        value_++;
+        if (armed_) {
+            armed_ = false;
+            listener_->revised();
+        }
+    }
+
+    /**
+     * Attach a listener (or detach with NULL). The listener hears about the
+     * first bump only; attach it again to hear about the next one.
+     */
+    void set_listener(revision_listener* listener)
+    {
+        listener_ = listener;
+        armed_ = (listener != NULL);
+    }
+
+private:
+    unsigned long value_;
+    revision_listener* listener_;
+    bool armed_;
+};
+
 /**
  * A node is a control point in a figure. An edge requires two nodes for construction.
  * Nodes are organized into DAGs through parent / child associations.
@@ -34,7 +119,8 @@ public:
         parent_(-1),
         children_(),
         x_(0),
-        y_(0)
+        y_(0),
+        revision_(NULL)
     {
     }
 
@@ -42,7 +128,8 @@ public:
         parent_(-1),
         children_(),
         x_(x),
-        y_(y)
+        y_(y),
+        revision_(NULL)
     {
     }
 
@@ -50,7 +137,8 @@ public:
         parent_(parent),
         children_(),
         x_(x),
-        y_(y)
+        y_(y),
+        revision_(NULL)
     {
     }
 
@@ -65,8 +153,8 @@ public:
     void clear_children() { children_.clear(); }
     double get_x() const { return x_; }
     double get_y() const { return y_; }
-    void set_x(double x) { x_ = x; }
-    void set_y(double y) { y_ = y; }
+    void set_x(double x) { x_ = x; touch(); }
+    void set_y(double y) { y_ = y; touch(); }
 
     /**
      * Move a node by a delta
@@ -75,6 +163,7 @@ public:
     {
         x_ += dx;
         y_ += dy;
+        touch();
     }
 
     /**
@@ -84,8 +173,16 @@ public:
     {
         x_ = x;
         y_ = y;
+        touch();
     }
 
+    /**
+     * Attach the node to the revision counter of the figure which owns it.
+     * Position changes bump the counter so the figure can tell when its
+     * cached data (e.g. the packed node store) is stale.
+     */
+    void set_revision(revision_counter* revision) { revision_ = revision; }
+
     void connect_child(int n)
     {
         children_.push_back(n);
@@ -101,10 +198,11 @@ public:
     // copy constructor
     node(const node& other)
     {
-        // new node does not inherit parent or children, just position
+        // new node does not inherit parent, children or owner, just position
         parent_ = -1;
         x_ = other.x_;
         y_ = other.y_;
+        revision_ = NULL;
     }
 
     // assignment operator
@@ -115,6 +213,7 @@ public:
             parent_ = -1;
             x_ = other.x_;
             y_ = other.y_;
+            touch();
         }
         return *this;
     }
@@ -133,11 +232,21 @@ protected:
         ar & BOOST_SERIALIZATION_NVP(y_);
     }
 
+    void touch()
+    {
+        if (revision_ != NULL) {
+            (*revision_)++;
+        }
+    }
+
 public:
     int parent_;
     std::list<int> children_;
     double x_;
     double y_;
+
+private:
+    revision_counter* revision_;    // owning figure's revision counter (not serialized)
 };
 
 BOOST_SERIALIZATION_ASSUME_ABSTRACT(node)
@@ -0,0 +1,85 @@
+/**
+ * @file node_store.cpp
+ * @brief Implementation of the packed node store
+ * @date 10-18-26
+ */
+
+#include "node_store.h"
+#include "affine.h"
+
+namespace stan {
+
+void node_store::build(const std::vector<node*>& nodes)
+{
+    unsigned count = nodes.size();
+
+    x_.resize(count);
+    y_.resize(count);
+    parent_.resize(count);
+    live_.resize(count);
+    child_start_.resize(count + 1);
+    child_index_.clear();
+
+    for (unsigned n = 0; n < count; n++) {
+        node* pn = nodes[n];
+        child_start_[n] = static_cast<int>(child_index_.size());
+        if (pn != NULL) {
+            x_[n] = pn->get_x();
+            y_[n] = pn->get_y();
+            parent_[n] = pn->get_parent();
+            live_[n] = 1;
+            BOOST_FOREACH(int c, pn->get_children()) {
+                child_index_.push_back(c);
+            }
+        }
+        else {
+            x_[n] = 0;
+            y_[n] = 0;
+            parent_[n] = -1;
+            live_[n] = 0;
+        }
+    }
+    child_start_[count] = static_cast<int>(child_index_.size());
+}
+
+void node_store::refresh_positions(const std::vector<node*>& nodes)
+{
+    assert(nodes.size() == x_.size());
+
+    for (unsigned n = 0; n < nodes.size(); n++) {
+        node* pn = nodes[n];
+        if (pn != NULL) {
+            x_[n] = pn->get_x();
+            y_[n] = pn->get_y();
+        }
+    }
+}
+
+void node_store::clear()
+{
+    x_.clear();
+    y_.clear();
+    parent_.clear();
+    live_.clear();
+    child_start_.clear();
+    child_index_.clear();
+    valid_ = false;
+}
+
+void node_store::move(double dx, double dy)
+{
+    if (!x_.empty()) {
+        translate_points(&x_[0], &y_[0], static_cast<unsigned>(x_.size()), dx, dy);
+    }
+}
+
+void node_store::transform(const affine& m)
+{
+    if (!x_.empty()) {
+        transform_points(&x_[0], &y_[0], static_cast<unsigned>(x_.size()), m);
+    }
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,121 @@
+#ifndef _NODE_STORE_H
+#define _NODE_STORE_H       1
+
+/**
+ * @file node_store.h
+ * @brief Packed (structure of arrays) copy of the nodes of a figure.
+ *
+ * The figure keeps its nodes as individually allocated objects, which is
+ * convenient for editing but slow to traverse. The node store packs the
+ * positions, parents and children of every node into contiguous arrays so
+ * that transform, hit-test and render loops walk memory linearly.
+ *
+ * @date 10-18-26
+ */
+
+#include <vector>
+
+#include "node.h"
+#include "affine.h"
+
+namespace stan {
+
+class node_store
+{
+public:
+    node_store() :
+        x_(),
+        y_(),
+        parent_(),
+        live_(),
+        child_start_(),
+        child_index_(),
+        valid_(false),
+        revision_(0),
+        topology_revision_(0)
+    {
+    }
+
+    virtual ~node_store() {}
+
+    /**
+     * Rebuild all arrays (positions and topology) from the node list.
+     * NULL entries in the node list are kept as dead slots so that node
+     * indices match those of the figure.
+     */
+    void build(const std::vector<node*>& nodes);
+
+    /**
+     * Refresh only the positions. The topology must not have changed
+     * since the last call to build().
+     */
+    void refresh_positions(const std::vector<node*>& nodes);
+
+    /**
+     * Drop all packed data.
+     */
+    void clear();
+
+    /**
+     * Is the store up to date with the given figure revisions?
+     */
+    bool is_current(unsigned long revision, unsigned long topology_revision) const
+    {
+        return valid_ && (revision_ == revision) && (topology_revision_ == topology_revision);
+    }
+
+    bool is_topology_current(unsigned long topology_revision) const
+    {
+        return valid_ && (topology_revision_ == topology_revision);
+    }
+
+    void set_revision(unsigned long revision, unsigned long topology_revision)
+    {
+        revision_ = revision;
+        topology_revision_ = topology_revision;
+        valid_ = true;
+    }
+
+    // Accessors
+    int size() const { return static_cast<int>(x_.size()); }
+    bool is_live(int n) const { return live_[n] != 0; }
+    double get_x(int n) const { return x_[n]; }
+    double get_y(int n) const { return y_[n]; }
+    int get_parent(int n) const { return parent_[n]; }
+
+    /**
+     * Children of node n are child_index_[child_start_[n]] up to (but not
+     * including) child_index_[child_start_[n + 1]], in the same order as the
+     * child list of the node.
+     */
+    const int* children_begin(int n) const { return child_index_.empty() ? NULL : &child_index_[0] + child_start_[n]; }
+    const int* children_end(int n) const { return child_index_.empty() ? NULL : &child_index_[0] + child_start_[n + 1]; }
+    int get_child_count(int n) const { return child_start_[n + 1] - child_start_[n]; }
+
+    /**
+     * Move all packed positions by a delta.
+     */
+    void move(double dx, double dy);
+
+    /**
+     * Apply an affine transform to all packed positions.
+     */
+    void transform(const affine& m);
+
+public:
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<int> parent_;
+    std::vector<unsigned char> live_;
+    std::vector<int> child_start_;  // size() + 1 offsets into child_index_
+    std::vector<int> child_index_;
+
+private:
+    bool valid_;
+    unsigned long revision_;            // figure revision the positions match
+    unsigned long topology_revision_;   // figure topology revision the arrays match
+};
+
+};  // namespace stan
+
+#endif  // _NODE_STORE_H
@@ -0,0 +1,275 @@
+/**
+ * @file packed_animation.cpp
+ * @brief Implementation of the packed animation storage.
+ * @date 10-18-26
+ */
+
+#include <set>
+#include <fstream>
+#include <cstring>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include "packed_animation.h"
+
+namespace stan {
+
+namespace {
+
+const char PACKED_MAGIC[] = "STANPAK1";
+const std::size_t PACKED_MAGIC_SIZE = 8;
+
+bool same_edge(edge* a, edge* b)
+{
+    if ( (a == NULL) || (b == NULL) ) {
+        return a == b;
+    }
+    return (a->get_n1() == b->get_n1()) && (a->get_n2() == b->get_n2()) &&
+           (a->get_type() == b->get_type()) && (a->get_color() == b->get_color()) &&
+           (a->get_meta_index() == b->get_meta_index()) && (a->get_name() == b->get_name());
+}
+
+bool same_meta(meta_store* a, meta_store* b)
+{
+    if (a == b) {
+        return true;
+    }
+
+    std::vector<meta_data*>& ta = a->get_meta_table();
+    std::vector<meta_data*>& tb = b->get_meta_table();
+    if (ta.size() != tb.size()) {
+        return false;
+    }
+    for (unsigned i = 0; i < ta.size(); i++) {
+        if ( (ta[i]->get_type() != tb[i]->get_type()) || (ta[i]->get_path() != tb[i]->get_path()) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+};  // anonymous namespace
+
+bool packed_figure::same_structure(figure* topology, figure* fig)
+{
+    std::vector<node*>& ta = topology->get_nodes();
+    std::vector<node*>& fa = fig->get_nodes();
+    if ( (ta.size() != fa.size()) || (topology->get_root() != fig->get_root()) ||
+         (topology->get_weight() != fig->get_weight()) ) {
+        return false;
+    }
+
+    for (unsigned n = 0; n < ta.size(); n++) {
+        if ( (ta[n] == NULL) || (fa[n] == NULL) ) {
+            if (ta[n] != fa[n]) {
+                return false;
+            }
+            continue;
+        }
+        if ( (ta[n]->get_parent() != fa[n]->get_parent()) ||
+             (ta[n]->get_children() != fa[n]->get_children()) ) {
+            return false;
+        }
+    }
+
+    std::vector<edge*>& te = topology->get_edges();
+    std::vector<edge*>& fe = fig->get_edges();
+    if (te.size() != fe.size()) {
+        return false;
+    }
+    for (unsigned e = 0; e < te.size(); e++) {
+        if (!same_edge(te[e], fe[e])) {
+            return false;
+        }
+    }
+
+    return same_meta(topology->get_meta_store(), fig->get_meta_store());
+}
+
+void packed_figure::pack(figure* fig, boost::shared_ptr<figure> topology)
+{
+    deltas_.clear();
+
+    if (!topology || !same_structure(topology.get(), fig)) {
+        // copy on write: the structure changed, so the figure gets a
+        // topology of its own with its current pose as the base
+        topology_.reset(new figure(*fig));
+        return;
+    }
+
+    topology_ = topology;
+    std::vector<node*>& base = topology_->get_nodes();
+    std::vector<node*>& nodes = fig->get_nodes();
+    for (unsigned n = 0; n < nodes.size(); n++) {
+        if (nodes[n] == NULL) {
+            continue;
+        }
+        double dx = nodes[n]->get_x() - base[n]->get_x();
+        double dy = nodes[n]->get_y() - base[n]->get_y();
+        if ( (dx != 0) || (dy != 0) ) {
+            deltas_.push_back(node_delta(n, dx, dy));
+        }
+    }
+}
+
+figure* packed_figure::unpack() const
+{
+    figure* fig = new figure(*topology_);
+    std::vector<node*>& nodes = fig->get_nodes();
+    BOOST_FOREACH(const node_delta& d, deltas_) {
+        node* n = nodes[d.node_];
+        n->move_to(n->get_x() + d.dx_, n->get_y() + d.dy_);
+    }
+    return fig;
+}
+
+void packed_frame::pack(frame* fr, const packed_frame* prev)
+{
+    width_ = fr->get_width();
+    height_ = fr->get_height();
+    image_index_ = fr->get_image_index();
+    sound_index_ = fr->get_sound_index();
+
+    std::list<figure*>& figures = fr->get_figures();
+    figures_.clear();
+    figures_.resize(figures.size());
+
+    unsigned i = 0;
+    BOOST_FOREACH(figure* f, figures) {
+        // the figure at the same position of the previous frame is almost
+        // always the same one (duplicated frames)
+        boost::shared_ptr<figure> topology;
+        if ( (prev != NULL) && (i < prev->figures_.size()) ) {
+            topology = prev->figures_[i].get_topology();
+            if (!packed_figure::same_structure(topology.get(), f)) {
+                topology.reset();
+                BOOST_FOREACH(const packed_figure& pf, prev->figures_) {
+                    if (packed_figure::same_structure(pf.get_topology().get(), f)) {
+                        topology = pf.get_topology();
+                        break;
+                    }
+                }
+            }
+        }
+        figures_[i++].pack(f, topology);
+    }
+}
+
+frame* packed_frame::unpack() const
+{
+    frame* fr = new frame(0, 0, width_, height_);
+    fr->set_image_index(image_index_);
+    fr->set_sound_index(sound_index_);
+    BOOST_FOREACH(const packed_figure& pf, figures_) {
+        fr->add_figure(pf.unpack());
+    }
+    return fr;
+}
+
+void packed_animation::pack(animation* anim)
+{
+    meta_store_.reset(new meta_store(*anim->get_meta_store()));
+
+    std::list<frame*>& frames = anim->get_frames();
+    frames_.clear();
+    frames_.resize(frames.size());
+
+    int n = 0;
+    BOOST_FOREACH(frame* fr, frames) {
+        frames_[n].pack(fr, (n > 0) ? &frames_[n - 1] : NULL);
+        n++;
+    }
+}
+
+animation* packed_animation::unpack() const
+{
+    animation* anim = new animation();
+    *anim->get_meta_store() = *meta_store_;
+    BOOST_FOREACH(const packed_frame& pf, frames_) {
+        anim->add_frame(pf.unpack());
+    }
+    return anim;
+}
+
+frame* packed_animation::unpack_frame(int n) const
+{
+    if ( (n < 0) || (n >= get_frame_count()) ) {
+        return NULL;
+    }
+    return frames_[n].unpack();
+}
+
+bool packed_animation::set_frame(int n, frame* fr)
+{
+    if ( (n < 0) || (n >= get_frame_count()) ) {
+        return false;
+    }
+
+    // the replaced frame holds the topologies most likely to match; pack
+    // into a new entry so they stay alive while being compared
+    packed_frame packed;
+    packed.pack(fr, &frames_[n]);
+    frames_[n] = packed;
+    return true;
+}
+
+int packed_animation::get_topology_count() const
+{
+    std::set<figure*> topologies;
+    BOOST_FOREACH(const packed_frame& pf, frames_) {
+        BOOST_FOREACH(const packed_figure& f, pf.get_figures()) {
+            topologies.insert(f.get_topology().get());
+        }
+    }
+    return static_cast<int>(topologies.size());
+}
+
+bool packed_animation::has_signature(const char* data, std::size_t size)
+{
+    return (size >= PACKED_MAGIC_SIZE) && (memcmp(data, PACKED_MAGIC, PACKED_MAGIC_SIZE) == 0);
+}
+
+bool packed_animation::write(animation* anim, const std::string& path)
+{
+    packed_animation packed;
+    packed.pack(anim);
+
+    std::ofstream ofs(path.c_str(), std::ios::out | std::ios::binary);
+    if (!ofs.good()) {
+        std::cerr << "Unable to write file: " << path << std::endl;
+        return false;
+    }
+    ofs.write(PACKED_MAGIC, PACKED_MAGIC_SIZE);
+    {
+        boost::archive::binary_oarchive oa(ofs);
+        oa << boost::serialization::make_nvp("packed", packed);
+    }
+    return ofs.good();
+}
+
+animation* packed_animation::read(const std::string& path)
+{
+    std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary);
+    char magic[PACKED_MAGIC_SIZE];
+    ifs.read(magic, PACKED_MAGIC_SIZE);
+    if (!ifs.good() || !has_signature(magic, PACKED_MAGIC_SIZE)) {
+        std::cerr << "Unable to open file: " << path << std::endl;
+        return NULL;
+    }
+
+    packed_animation packed;
+    try {
+        boost::archive::binary_iarchive ia(ifs);
+        ia >> boost::serialization::make_nvp("packed", packed);
+    }
+    catch (boost::archive::archive_exception& e) {
+        std::cerr << "Error loading " << path << ": " << e.what() << std::endl;
+        return NULL;
+    }
+    return packed.unpack();
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,242 @@
+#ifndef _PACKED_ANIMATION_H
+#define _PACKED_ANIMATION_H       1
+
+/**
+ * @file packed_animation.h
+ * @brief Compact animation storage: figures with the same structure share
+ *        one immutable topology and frames only keep the nodes which moved.
+ * @date 10-18-26
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "animation.h"
+
+namespace stan {
+
+/**
+ * Offset of one node from the base pose of its topology.
+ */
+class node_delta
+{
+public:
+    node_delta() :
+        node_(-1),
+        dx_(0),
+        dy_(0)
+    {
+    }
+
+    node_delta(int n, double dx, double dy) :
+        node_(n),
+        dx_(dx),
+        dy_(dy)
+    {
+    }
+
+    int node_;
+    double dx_;
+    double dy_;
+
+private:
+    friend class boost::serialization::access;
+
+	template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+	{
+        ar & BOOST_SERIALIZATION_NVP(node_);
+        ar & BOOST_SERIALIZATION_NVP(dx_);
+        ar & BOOST_SERIALIZATION_NVP(dy_);
+    }
+};
+
+/**
+ * A figure stored as a shared topology plus the nodes which differ from
+ * the topology's base pose. The topology is a complete figure (nodes,
+ * edges, weight, meta data) which is never modified once shared; a figure
+ * whose structure changes gets a topology of its own.
+ */
+class packed_figure
+{
+public:
+    packed_figure() :
+        topology_(),
+        deltas_()
+    {
+    }
+
+    /**
+     * Does a figure have the structure of a topology: same node slots,
+     * parents, child order, edges, weight and meta data?
+     */
+    static bool same_structure(figure* topology, figure* fig);
+
+    /**
+     * Pack a figure, sharing the given topology if the structure matches
+     * (pass an empty pointer to always create a new one).
+     */
+    void pack(figure* fig, boost::shared_ptr<figure> topology);
+
+    /**
+     * Create a new figure (owned by the caller) in this pose.
+     */
+    figure* unpack() const;
+
+    boost::shared_ptr<figure> get_topology() const { return topology_; }
+    int get_delta_count() const { return static_cast<int>(deltas_.size()); }
+
+private:
+    friend class boost::serialization::access;
+
+	template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+	{
+        ar & BOOST_SERIALIZATION_NVP(topology_);
+        ar & BOOST_SERIALIZATION_NVP(deltas_);
+    }
+
+    boost::shared_ptr<figure> topology_;   // shared, treated as immutable
+    std::vector<node_delta> deltas_;        // nodes away from the base pose
+};
+
+/**
+ * A frame with packed figures.
+ */
+class packed_frame
+{
+public:
+    packed_frame() :
+        figures_(),
+        width_(0),
+        height_(0),
+        image_index_(-1),
+        sound_index_(-1)
+    {
+    }
+
+    /**
+     * Pack a frame, sharing topologies with a previous frame where the
+     * figure structure did not change.
+     * @param prev The frame to share with, NULL for none
+     */
+    void pack(frame* fr, const packed_frame* prev);
+
+    /**
+     * Create a new frame and figures (owned by the caller).
+     */
+    frame* unpack() const;
+
+    const std::vector<packed_figure>& get_figures() const { return figures_; }
+
+private:
+    friend class boost::serialization::access;
+
+	template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+	{
+        ar & BOOST_SERIALIZATION_NVP(figures_);
+        ar & BOOST_SERIALIZATION_NVP(width_);
+        ar & BOOST_SERIALIZATION_NVP(height_);
+        ar & BOOST_SERIALIZATION_NVP(image_index_);
+        ar & BOOST_SERIALIZATION_NVP(sound_index_);
+    }
+
+    std::vector<packed_figure> figures_;
+    int width_;
+    int height_;
+    int image_index_;
+    int sound_index_;
+};
+
+/**
+ * An animation held as packed frames. Duplicated frames cost only the
+ * nodes which were moved since the frame their topology came from, both
+ * in memory and when serialized (boost writes every shared topology once).
+ * Frames are edited by unpacking them and storing them back with
+ * set_frame().
+ *
+ * Packed archive layout: magic "STANPAK1" followed by a boost binary
+ * archive of the packed animation.
+ */
+class packed_animation
+{
+public:
+    packed_animation() :
+        frames_(),
+        meta_store_(new meta_store())
+    {
+    }
+
+    virtual ~packed_animation() {}
+
+    /**
+     * Replace the contents with a packed copy of an animation.
+     */
+    void pack(animation* anim);
+
+    /**
+     * Create a new animation (owned by the caller) with unpacked frames.
+     */
+    animation* unpack() const;
+
+    int get_frame_count() const { return static_cast<int>(frames_.size()); }
+
+    /**
+     * Create frame n (owned by the caller), NULL if out of range.
+     */
+    frame* unpack_frame(int n) const;
+
+    /**
+     * Store an edited frame at n. Its figures keep sharing the topologies
+     * of the frame it replaces as long as their structure is unchanged,
+     * otherwise they get new topologies; other frames are never affected.
+     * @return false if n is out of range
+     */
+    bool set_frame(int n, frame* fr);
+
+    /**
+     * Number of distinct topologies referenced by all frames.
+     */
+    int get_topology_count() const;
+
+    meta_store* get_meta_store() { return meta_store_.get(); }
+
+    /**
+     * Does a file header start with the packed format magic?
+     */
+    static bool has_signature(const char* data, std::size_t size);
+
+    /**
+     * Write an animation as a packed archive.
+     * @return false if the file could not be written
+     */
+    static bool write(animation* anim, const std::string& path);
+
+    /**
+     * Read a packed archive.
+     * @return The unpacked animation (owned by the caller) or NULL on failure
+     */
+    static animation* read(const std::string& path);
+
+private:
+    friend class boost::serialization::access;
+
+	template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+	{
+        ar & BOOST_SERIALIZATION_NVP(frames_);
+        ar & BOOST_SERIALIZATION_NVP(meta_store_);
+    }
+
+    std::vector<packed_frame> frames_;
+    boost::shared_ptr<meta_store> meta_store_;
+};
+
+};  // namespace stan
+
+#endif  // _PACKED_ANIMATION_H
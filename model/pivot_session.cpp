@@ -0,0 +1,93 @@
+/**
+ * @file pivot_session.cpp
+ * @brief Implementation of the pivot drag session.
+ * @date 10-18-26
+ */
+
+#include <list>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "pivot_session.h"
+
+namespace stan {
+
+pivot_session::pivot_session(figure* fig, int selected) :
+    fig_(fig),
+    pivot_(-1),
+    pivot_x_(0),
+    pivot_y_(0),
+    nodes_(),
+    base_x_(),
+    base_y_(),
+    x_(),
+    y_(),
+    radius_(0),
+    angle_(0),
+    applied_angle_(0),
+    pending_(false)
+{
+    pivot_ = fig_->get_node(selected)->get_parent();
+    assert(pivot_ != -1);
+
+    node* pn = fig_->get_node(pivot_);
+    pivot_x_ = pn->get_x();
+    pivot_y_ = pn->get_y();
+
+    std::list<int> subtree;
+    subtree.push_back(selected);
+    fig_->get_decendants(subtree, selected);
+    nodes_.assign(subtree.begin(), subtree.end());
+
+    unsigned count = static_cast<unsigned>(nodes_.size());
+    base_x_.resize(count);
+    base_y_.resize(count);
+    for (unsigned i = 0; i < count; i++) {
+        node* n = fig_->get_node(nodes_[i]);
+        base_x_[i] = n->get_x();
+        base_y_[i] = n->get_y();
+
+        double dx = base_x_[i] - pivot_x_;
+        double dy = base_y_[i] - pivot_y_;
+        radius_ = std::max(radius_, sqrt((dx * dx) + (dy * dy)));
+    }
+    x_ = base_x_;
+    y_ = base_y_;
+}
+
+void pivot_session::set_angle(double angle)
+{
+    angle_ = angle;
+    pending_ = (angle_ != applied_angle_);
+}
+
+bool pivot_session::apply()
+{
+    if (!pending_) {
+        return false;
+    }
+    pending_ = false;
+    applied_angle_ = angle_;
+
+    // always from the base pose, so errors do not add up over a drag
+    unsigned count = static_cast<unsigned>(nodes_.size());
+    std::copy(base_x_.begin(), base_x_.end(), x_.begin());
+    std::copy(base_y_.begin(), base_y_.end(), y_.begin());
+    rotate_points(&x_[0], &y_[0], count, angle_, pivot_x_, pivot_y_);
+
+    for (unsigned i = 0; i < count; i++) {
+        fig_->get_node(nodes_[i])->move_to(x_[i], y_[i]);
+    }
+    return true;
+}
+
+void pivot_session::reset()
+{
+    set_angle(0);
+    apply();
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
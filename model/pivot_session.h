@@ -0,0 +1,100 @@
+#ifndef _PIVOT_SESSION_H
+#define _PIVOT_SESSION_H       1
+
+/**
+ * @file pivot_session.h
+ * @brief Interactive rotation of a subtree about its parent node.
+ * @date 10-18-26
+ */
+
+#include <vector>
+
+#include "figure.h"
+
+namespace stan {
+
+/**
+ * A pivot drag. The subtree below (and including) the grabbed node and its
+ * base pose are captured once, as packed arrays, when the drag starts.
+ * Every update then only rotates the base pose by the current angle and
+ * writes the result into the figure; no tree walk and no allocation.
+ *
+ * Angles are coalesced: set_angle() just remembers the latest angle, so a
+ * burst of mouse events costs one apply().
+ */
+class pivot_session
+{
+public:
+    /**
+     * Start a pivot of a figure's node about its parent.
+     * @param fig The figure whose nodes are moved
+     * @param selected The grabbed node, must not be the root
+     */
+    pivot_session(figure* fig, int selected);
+
+    virtual ~pivot_session() {}
+
+    figure* get_figure() const { return fig_; }
+    int get_pivot() const { return pivot_; }
+    int get_selected() const { return nodes_[0]; }
+
+    /**
+     * The rotated nodes, the grabbed node first.
+     */
+    const std::vector<int>& get_nodes() const { return nodes_; }
+
+    /**
+     * Position of the grabbed node in the base pose.
+     */
+    double get_base_x() const { return base_x_[0]; }
+    double get_base_y() const { return base_y_[0]; }
+
+    /**
+     * Distance of the farthest rotated node from the pivot. The subtree
+     * stays inside this circle whatever the angle.
+     */
+    double get_radius() const { return radius_; }
+
+    /**
+     * Set the rotation (radians) from the base pose, applied on the next
+     * call to apply().
+     */
+    void set_angle(double angle);
+
+    double get_angle() const { return angle_; }
+
+    /**
+     * Is there an angle which has not been applied yet?
+     */
+    bool is_pending() const { return pending_; }
+
+    /**
+     * Rotate the subtree to the latest angle.
+     * @return false if the figure already had that pose
+     */
+    bool apply();
+
+    /**
+     * Put the subtree back into the base pose.
+     */
+    void reset();
+
+private:
+    figure* fig_;
+    int pivot_;
+    double pivot_x_;
+    double pivot_y_;
+    std::vector<int> nodes_;
+    std::vector<double> base_x_;    // base pose
+    std::vector<double> base_y_;
+    std::vector<double> x_;         // rotated pose, reused by every apply()
+    std::vector<double> y_;
+    double radius_;
+    double angle_;
+    double applied_angle_;
+    bool pending_;
+};
+
+};  // namespace stan
+
+#endif  // _PIVOT_SESSION_H
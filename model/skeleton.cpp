@@ -0,0 +1,124 @@
+/**
+ * @file skeleton.cpp
+ * @brief Implementation of the local space skeleton.
+ * @date 10-18-26
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "skeleton.h"
+
+namespace stan {
+
+void skeleton::build(const std::vector<node*>& nodes, int root)
+{
+    unsigned count = nodes.size();
+
+    order_.clear();
+    order_.reserve(count);
+    parent_.assign(count, -1);
+    length_.assign(count, 0);
+    angle_.assign(count, 0);
+    world_angle_.assign(count, 0);
+    dirty_.assign(count, 0);
+    marked_.clear();
+    any_dirty_ = false;
+
+    if ( (root < 0) || (root >= static_cast<int>(count)) || (nodes[root] == NULL) ) {
+        return;
+    }
+
+    // breadth first from the root, so every parent comes before its children
+    order_.push_back(root);
+    for (unsigned i = 0; i < order_.size(); i++) {
+        int p = order_[i];
+        node* pn = nodes[p];
+        BOOST_FOREACH(int c, pn->get_children()) {
+            node* cn = nodes[c];
+            double dx = cn->get_x() - pn->get_x();
+            double dy = cn->get_y() - pn->get_y();
+
+            parent_[c] = p;
+            length_[c] = sqrt((dx * dx) + (dy * dy));
+            world_angle_[c] = atan2(dy, dx);
+            angle_[c] = world_angle_[c] - world_angle_[p];
+            order_.push_back(c);
+        }
+    }
+}
+
+void skeleton::place(const std::vector<node*>& nodes, int n)
+{
+    int p = parent_[n];
+    double a = world_angle_[p] + angle_[n];
+    world_angle_[n] = a;
+
+    node* pn = nodes[p];
+    nodes[n]->move_to(pn->get_x() + length_[n] * cos(a), pn->get_y() + length_[n] * sin(a));
+}
+
+void skeleton::clear()
+{
+    order_.clear();
+    parent_.clear();
+    length_.clear();
+    angle_.clear();
+    world_angle_.clear();
+    dirty_.clear();
+    marked_.clear();
+    any_dirty_ = false;
+    valid_ = false;
+}
+
+int skeleton::solve(const std::vector<node*>& nodes)
+{
+    if (!any_dirty_ || order_.empty()) {
+        return 0;
+    }
+
+    int moved = 0;
+    std::vector<int> pending;
+    BOOST_FOREACH(int m, marked_) {
+        // a changed bone above this one moves it along anyway
+        bool covered = false;
+        for (int p = parent_[m]; (p != -1) && !covered; p = parent_[p]) {
+            covered = (dirty_[p] != 0);
+        }
+        if (covered) {
+            continue;
+        }
+
+        // the root bone turns the whole figure but the root itself stays
+        if (parent_[m] == -1) {
+            world_angle_[m] = angle_[m];
+        }
+        else {
+            place(nodes, m);
+            moved++;
+        }
+
+        // depth first through the subtree, every node after its parent
+        pending.assign(nodes[m]->get_children().begin(), nodes[m]->get_children().end());
+        while (!pending.empty()) {
+            int n = pending.back();
+            pending.pop_back();
+            place(nodes, n);
+            moved++;
+            BOOST_FOREACH(int c, nodes[n]->get_children()) {
+                pending.push_back(c);
+            }
+        }
+    }
+
+    BOOST_FOREACH(int m, marked_) {
+        dirty_[m] = 0;
+    }
+    marked_.clear();
+    any_dirty_ = false;
+    return moved;
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
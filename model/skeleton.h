@@ -0,0 +1,126 @@
+#ifndef _SKELETON_H
+#define _SKELETON_H       1
+
+/**
+ * @file skeleton.h
+ * @brief Local space (parent relative) copy of a figure's pose.
+ * @date 10-18-26
+ */
+
+#include <vector>
+
+#include "node.h"
+
+namespace stan {
+
+/**
+ * Every node is described by the bone from its parent: a length and an
+ * angle relative to the parent's bone (the root's bone points along +x).
+ * Rotating a bone is then a single write which implicitly moves the whole
+ * subtree; solve() does the forward kinematics and writes world positions
+ * into the nodes, only for subtrees below changed bones.
+ *
+ * Like node_store this is a cache of the figure's nodes, stamped with the
+ * figure revisions it was built from.
+ */
+class skeleton
+{
+public:
+    skeleton() :
+        order_(),
+        parent_(),
+        length_(),
+        angle_(),
+        world_angle_(),
+        dirty_(),
+        marked_(),
+        any_dirty_(false),
+        valid_(false),
+        revision_(0),
+        topology_revision_(0)
+    {
+    }
+
+    virtual ~skeleton() {}
+
+    /**
+     * Build the bones from the nodes' world positions. NULL entries are
+     * skipped, indices match those of the figure.
+     */
+    void build(const std::vector<node*>& nodes, int root);
+
+    /**
+     * Is the skeleton up to date with the given figure revisions?
+     */
+    bool is_current(unsigned long revision, unsigned long topology_revision) const
+    {
+        return valid_ && (revision_ == revision) && (topology_revision_ == topology_revision);
+    }
+
+    void set_revision(unsigned long revision, unsigned long topology_revision)
+    {
+        revision_ = revision;
+        topology_revision_ = topology_revision;
+        valid_ = true;
+    }
+
+    void clear();
+
+    double get_length(int n) const { return length_[n]; }
+    double get_angle(int n) const { return angle_[n]; }
+
+    /**
+     * Change the bone ending at node n. The node and its decendants move
+     * on the next solve(). The root has no length, its angle turns the
+     * whole figure about the root.
+     */
+    void set_length(int n, double length) { length_[n] = length; mark(n); }
+    void set_angle(int n, double angle) { angle_[n] = angle; mark(n); }
+    void rotate(int n, double angle) { angle_[n] += angle; mark(n); }
+
+    /**
+     * Are there bone changes not yet written to the nodes?
+     */
+    bool is_dirty() const { return any_dirty_; }
+
+    /**
+     * Forward kinematics: compute the world positions below every changed
+     * bone and store them into the nodes. Only the subtrees of the changed
+     * bones are visited.
+     * @return The number of nodes moved
+     */
+    int solve(const std::vector<node*>& nodes);
+
+private:
+    /**
+     * Put node n at the end of its bone and update the bone's world angle.
+     * The parent must be placed already.
+     */
+    void place(const std::vector<node*>& nodes, int n);
+
+    void mark(int n)
+    {
+        if (!dirty_[n]) {
+            dirty_[n] = 1;
+            marked_.push_back(n);
+        }
+        any_dirty_ = true;
+    }
+
+    std::vector<int> order_;            // live nodes, parents before children
+    std::vector<int> parent_;
+    std::vector<double> length_;        // bone length
+    std::vector<double> angle_;         // bone angle relative to the parent bone
+    std::vector<double> world_angle_;   // absolute bone angle as of the last solve
+    std::vector<unsigned char> dirty_;  // bone changed since the last solve
+    std::vector<int> marked_;           // the changed bones, in edit order
+    bool any_dirty_;
+
+    bool valid_;
+    unsigned long revision_;            // figure revision the bones match
+    unsigned long topology_revision_;   // figure topology revision the arrays match
+};
+
+};  // namespace stan
+
+#endif  // _SKELETON_H
@@ -0,0 +1,181 @@
+/**
+ * @file spatial_grid.cpp
+ * @brief Implementation of the node hit-test grid
+ * @date 10-18-26
+ */
+
+#include <algorithm>
+
+#include "spatial_grid.h"
+
+namespace stan {
+
+void spatial_grid::sync(std::list<figure*>& figures, unsigned long revision)
+{
+    if (!list_synced_ || (revision != list_revision_)) {
+        sync_count_++;
+
+        int order = 0;
+        BOOST_FOREACH(figure* f, figures) {
+            figure_map::iterator iter = figures_.find(f);
+            if (iter == figures_.end()) {
+                figure_entry& entry = figures_[f];
+                entry.grid_ = this;
+                entry.fig_ = f;
+                bucket(f, entry);
+                iter = figures_.find(f);
+            }
+            iter->second.order_ = order++;
+            iter->second.seen_ = sync_count_;
+        }
+
+        // drop figures which are no longer part of the list
+        figure_map::iterator iter = figures_.begin();
+        while (iter != figures_.end()) {
+            if (iter->second.seen_ != sync_count_) {
+                iter->first->set_change_listener(NULL);
+                unbucket(iter->first, iter->second);
+                iter = figures_.erase(iter);
+            }
+            else {
+                iter++;
+            }
+        }
+
+        list_revision_ = revision;
+        list_synced_ = true;
+    }
+
+    // only figures which reported a change since the last query are
+    // re-bucketed, the others are not even looked at
+    std::vector<figure*> dirty;
+    dirty.swap(dirty_);
+    BOOST_FOREACH(figure* f, dirty) {
+        figure_map::iterator iter = figures_.find(f);
+        if (iter != figures_.end()) {
+            unbucket(f, iter->second);
+            bucket(f, iter->second);
+        }
+    }
+}
+
+void spatial_grid::remove_figure(figure* fig)
+{
+    if (figures_.find(fig) != figures_.end()) {
+        fig->set_change_listener(NULL);
+        drop(fig);
+    }
+}
+
+void spatial_grid::clear()
+{
+    BOOST_FOREACH(figure_map::value_type& fe, figures_) {
+        fe.first->set_change_listener(NULL);
+    }
+    cells_.clear();
+    figures_.clear();
+    dirty_.clear();
+    list_synced_ = false;
+}
+
+void spatial_grid::drop(figure* fig)
+{
+    figure_map::iterator iter = figures_.find(fig);
+    if (iter != figures_.end()) {
+        unbucket(fig, iter->second);
+        figures_.erase(iter);
+    }
+    dirty_.erase(std::remove(dirty_.begin(), dirty_.end(), fig), dirty_.end());
+}
+
+bool spatial_grid::find(double x, double y, int radius, figure*& fig, int& n)
+{
+    bool found = false;
+    int best_order = 0;
+    int best_node = 0;
+
+    // simple method: model node as a square of (radius x radius)
+    double xl = x - radius;
+    double xr = x + radius;
+    double yt = y - radius;
+    double yb = y + radius;
+
+    for (int cx = to_cell(xl); cx <= to_cell(xr); cx++) {
+        for (int cy = to_cell(yt); cy <= to_cell(yb); cy++) {
+            cell_map::iterator citer = cells_.find(cell_key(cx, cy));
+            if (citer == cells_.end()) {
+                continue;
+            }
+
+            BOOST_FOREACH(grid_entry& ge, citer->second) {
+                const node_store& ns = ge.fig_->get_node_store();
+                double nx = ns.x_[ge.node_];
+                double ny = ns.y_[ge.node_];
+                if ( (nx > xl) && (nx < xr) && (ny > yt) && (ny < yb) ) {
+                    int order = figures_.find(ge.fig_)->second.order_;
+                    if (!found || (order < best_order) || ((order == best_order) && (ge.node_ < best_node))) {
+                        found = true;
+                        best_order = order;
+                        best_node = ge.node_;
+                        fig = ge.fig_;
+                    }
+                }
+            }
+        }
+    }
+
+    if (found) {
+        n = best_node;
+    }
+    return found;
+}
+
+void spatial_grid::unbucket(figure* fig, figure_entry& entry)
+{
+    BOOST_FOREACH(const cell_key& key, entry.cells_) {
+        cell_map::iterator citer = cells_.find(key);
+        if (citer == cells_.end()) {
+            continue;
+        }
+
+        std::vector<grid_entry>& cell = citer->second;
+        unsigned count = 0;
+        for (unsigned i = 0; i < cell.size(); i++) {
+            if (cell[i].fig_ != fig) {
+                cell[count++] = cell[i];
+            }
+        }
+        cell.resize(count, grid_entry(NULL, -1));
+
+        if (cell.empty()) {
+            cells_.erase(citer);
+        }
+    }
+    entry.cells_.clear();
+}
+
+void spatial_grid::bucket(figure* fig, figure_entry& entry)
+{
+    const node_store& ns = fig->get_node_store();
+    for (int n = 0; n < ns.size(); n++) {
+        if (!ns.is_live(n)) {
+            continue;
+        }
+
+        cell_key key(to_cell(ns.x_[n]), to_cell(ns.y_[n]));
+        std::vector<grid_entry>& cell = cells_[key];
+        if (cell.empty() || cell.back().fig_ != fig) {
+            // first node of this figure in the cell (only this figure is
+            // being added, so its entries are always at the back)
+            entry.cells_.push_back(key);
+        }
+        cell.push_back(grid_entry(fig, n));
+    }
+
+    // listen from here on, solving in get_node_store() above is included
+    fig->set_change_listener(&entry);
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
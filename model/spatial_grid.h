@@ -0,0 +1,159 @@
+#ifndef _SPATIAL_GRID_H
+#define _SPATIAL_GRID_H       1
+
+/**
+ * @file spatial_grid.h
+ * @brief Uniform grid over the node positions of the figures in a frame,
+ *        used to answer hit-tests without visiting every node.
+ * @date 10-18-26
+ */
+
+#include <cmath>
+#include <list>
+#include <vector>
+#include <utility>
+
+#include <boost/unordered_map.hpp>
+
+#include "figure.h"
+
+namespace stan {
+
+/**
+ * The grid buckets every live node of every registered figure by the
+ * square cell containing it. Registered figures tell the grid when they
+ * change or are destroyed (see figure::set_change_listener()), so a query
+ * re-buckets just the figures which changed since the last one and never
+ * meets an entry of a deleted figure.
+ */
+class spatial_grid
+{
+public:
+    static const int DEFAULT_CELL_SIZE = 32;
+
+    spatial_grid(int cell_size = DEFAULT_CELL_SIZE) :
+        cell_size_(cell_size),
+        cells_(),
+        figures_(),
+        dirty_(),
+        sync_count_(0),
+        list_revision_(0),
+        list_synced_(false)
+    {
+    }
+
+    virtual ~spatial_grid() { clear(); }
+
+    /**
+     * Bring the grid up to date. The figure list is only walked when its
+     * revision differs from the last call: new figures are bucketed,
+     * figures no longer in the list are dropped and the list order defines
+     * the hit-test priority. Figures which reported a change since they
+     * were bucketed are re-bucketed.
+     * @param figures The figures
+     * @param revision Revision of the list, bumped by its owner whenever
+     *        the list changes
+     */
+    void sync(std::list<figure*>& figures, unsigned long revision);
+
+    /**
+     * Remove all entries of a (live) figure.
+     */
+    void remove_figure(figure* fig);
+
+    /**
+     * Remove everything from the grid.
+     */
+    void clear();
+
+    /**
+     * Find the node at a position, with the same rules as
+     * figure::get_node_at_pos(): the first figure (in list order) with a
+     * node strictly inside the square of the given radius around (x,y),
+     * and the lowest such node index within that figure.
+     * @param x,y The position
+     * @param radius Distance from point to consider a hit
+     * @param fig Return the figure if found
+     * @param n Return the node index within the figure
+     * @return true if a node was found
+     */
+    bool find(double x, double y, int radius, figure*& fig, int& n);
+
+    int get_cell_size() { return cell_size_; }
+
+private:
+    typedef std::pair<int, int> cell_key;
+
+    class grid_entry
+    {
+    public:
+        grid_entry(figure* fig, int n) :
+            fig_(fig),
+            node_(n)
+        {
+        }
+
+        figure* fig_;
+        int node_;
+    };
+
+    class figure_entry : public revision_listener
+    {
+    public:
+        figure_entry() :
+            grid_(NULL),
+            fig_(NULL),
+            order_(0),
+            seen_(0),
+            cells_()
+        {
+        }
+
+        virtual void revised() { grid_->dirty_.push_back(fig_); }
+
+        // destroys this entry, nothing may follow the call
+        virtual void released() { grid_->drop(fig_); }
+
+        spatial_grid* grid_;
+        figure* fig_;
+        int order_;                         // position in the figure list
+        unsigned seen_;                     // sync count when last seen
+        std::vector<cell_key> cells_;       // cells holding nodes of this figure
+    };
+    friend class figure_entry;
+
+    typedef boost::unordered_map<cell_key, std::vector<grid_entry> > cell_map;
+    typedef boost::unordered_map<figure*, figure_entry> figure_map;
+
+    int to_cell(double v)
+    {
+        return static_cast<int>(floor(v / cell_size_));
+    }
+
+    /**
+     * Drop the entries of a figure from the cells it occupies.
+     */
+    void unbucket(figure* fig, figure_entry& entry);
+
+    /**
+     * Bucket all live nodes of a figure and listen for its next change.
+     */
+    void bucket(figure* fig, figure_entry& entry);
+
+    /**
+     * Forget a figure without touching it (it may be being destroyed).
+     */
+    void drop(figure* fig);
+
+    int cell_size_;
+    cell_map cells_;
+    figure_map figures_;    // entries must not move, they are the listeners
+    std::vector<figure*> dirty_;    // figures changed since bucketed
+    unsigned sync_count_;
+    unsigned long list_revision_;   // figure list revision at the last walk
+    bool list_synced_;
+};
+
+};  // namespace stan
+
+#endif  // _SPATIAL_GRID_H
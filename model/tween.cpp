@@ -0,0 +1,215 @@
+/**
+ * @file tween.cpp
+ * @brief Implementation of keyframe interpolation.
+ * @date 10-18-26
+ */
+
+#include <cmath>
+
+#include "tween.h"
+
+namespace stan {
+
+namespace {
+
+const double TWO_PI = 6.28318530717958647692;
+
+double lerp(double a, double b, double t)
+{
+    return a + (b - a) * t;
+}
+
+/**
+ * Interpolate angles along the shorter arc.
+ */
+double lerp_angle(double a, double b, double t)
+{
+    double d = fmod(b - a, TWO_PI);
+    if (d > TWO_PI / 2) {
+        d -= TWO_PI;
+    }
+    else if (d < -TWO_PI / 2) {
+        d += TWO_PI;
+    }
+    return a + d * t;
+}
+
+};  // anonymous namespace
+
+bool tween::same_topology(figure* a, figure* b)
+{
+    if (a == b) {
+        return true;
+    }
+
+    std::vector<node*>& na = a->get_nodes();
+    std::vector<node*>& nb = b->get_nodes();
+    if ( (na.size() != nb.size()) || (a->get_root() != b->get_root()) ) {
+        return false;
+    }
+
+    for (unsigned n = 0; n < na.size(); n++) {
+        if ( (na[n] == NULL) != (nb[n] == NULL) ) {
+            return false;
+        }
+        if ( (na[n] != NULL) && (na[n]->get_parent() != nb[n]->get_parent()) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool tween::is_compatible()
+{
+    std::list<figure*>& fa = from_->get_figures();
+    std::list<figure*>& fb = to_->get_figures();
+    if (fa.size() != fb.size()) {
+        return false;
+    }
+
+    std::list<figure*>::iterator ia = fa.begin();
+    std::list<figure*>::iterator ib = fb.begin();
+    for ( ; ia != fa.end(); ia++, ib++) {
+        if (!same_topology(*ia, *ib)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+frame* tween::create_frame()
+{
+    frame* out = new frame(*from_);
+
+    // frame::clone() reverses the figure order, restore it so figures pair
+    // up with the keyframes
+    out->get_figures().reverse();
+    out->touch();
+    return out;
+}
+
+bool tween::interpolate(double t, frame* out)
+{
+    std::list<figure*>& fa = from_->get_figures();
+    std::list<figure*>& fb = to_->get_figures();
+    std::list<figure*>& fo = out->get_figures();
+    if ( (fa.size() != fb.size()) || (fa.size() != fo.size()) ) {
+        return false;
+    }
+
+    std::list<figure*>::iterator ia = fa.begin();
+    std::list<figure*>::iterator ib = fb.begin();
+    std::list<figure*>::iterator io = fo.begin();
+    for ( ; ia != fa.end(); ia++, ib++, io++) {
+        if (!same_topology(*ia, *ib) || !same_topology(*ia, *io)) {
+            return false;
+        }
+    }
+
+    ia = fa.begin();
+    ib = fb.begin();
+    io = fo.begin();
+    for ( ; ia != fa.end(); ia++, ib++, io++) {
+        interpolate_figure(t, *ia, *ib, *io);
+    }
+    return true;
+}
+
+void tween::interpolate_figure(double t, figure* a, figure* b, figure* out)
+{
+    std::vector<node*>& na = a->get_nodes();
+    std::vector<node*>& nb = b->get_nodes();
+    std::vector<node*>& no = out->get_nodes();
+
+    int root = a->get_root();
+    if ( (mode_ == TWEEN_LINEAR) || (root < 0) ) {
+        for (unsigned n = 0; n < na.size(); n++) {
+            if (na[n] != NULL) {
+                no[n]->move_to(lerp(na[n]->get_x(), nb[n]->get_x(), t),
+                               lerp(na[n]->get_y(), nb[n]->get_y(), t));
+            }
+        }
+        return;
+    }
+
+    // walk down from the root so every parent is placed before its
+    // children; each limb keeps its interpolated length and turns about
+    // the (already interpolated) parent joint
+    no[root]->move_to(lerp(na[root]->get_x(), nb[root]->get_x(), t),
+                      lerp(na[root]->get_y(), nb[root]->get_y(), t));
+
+    std::vector<int> pending;
+    pending.push_back(root);
+    while (!pending.empty()) {
+        int p = pending.back();
+        pending.pop_back();
+
+        BOOST_FOREACH(int c, na[p]->get_children()) {
+            if ( (c < 0) || (c >= static_cast<int>(na.size())) || (na[c] == NULL) ) {
+                continue;
+            }
+
+            double ax = na[c]->get_x() - na[p]->get_x();
+            double ay = na[c]->get_y() - na[p]->get_y();
+            double bx = nb[c]->get_x() - nb[p]->get_x();
+            double by = nb[c]->get_y() - nb[p]->get_y();
+
+            double angle = lerp_angle(atan2(ay, ax), atan2(by, bx), t);
+            double length = lerp(sqrt(ax * ax + ay * ay), sqrt(bx * bx + by * by), t);
+
+            no[c]->move_to(no[p]->get_x() + length * cos(angle),
+                           no[p]->get_y() + length * sin(angle));
+            pending.push_back(c);
+        }
+    }
+}
+
+void tween_sequence::add_key(frame* key, int steps)
+{
+    keys_.push_back(key_entry(key, (steps > 0) ? steps : 0));
+}
+
+int tween_sequence::get_length()
+{
+    int length = 0;
+    for (unsigned i = 0; i < keys_.size(); i++) {
+        length++;
+        if (i + 1 < keys_.size()) {
+            length += keys_[i].steps_;
+        }
+    }
+    return length;
+}
+
+frame* tween_sequence::create_frame()
+{
+    if (keys_.empty()) {
+        return NULL;
+    }
+
+    tween tw(keys_[0].key_, keys_[0].key_, mode_);
+    return tw.create_frame();
+}
+
+bool tween_sequence::get_frame(int n, frame* out)
+{
+    if (n < 0) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < keys_.size(); i++) {
+        bool last = (i + 1 == keys_.size());
+        int span = last ? 1 : keys_[i].steps_ + 1;
+        if (n < span) {
+            frame* to = last ? keys_[i].key_ : keys_[i + 1].key_;
+            tween tw(keys_[i].key_, to, mode_);
+            return tw.interpolate(static_cast<double>(n) / span, out);
+        }
+        n -= span;
+    }
+    return false;
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
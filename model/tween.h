@@ -0,0 +1,143 @@
+#ifndef _TWEEN_H
+#define _TWEEN_H       1
+
+/**
+ * @file tween.h
+ * @brief Generates the frames between two keyframes by interpolating the
+ *        node positions of structurally equal figures.
+ * @date 10-18-26
+ */
+
+#include <vector>
+
+#include "frame.h"
+
+namespace stan {
+
+typedef enum {
+    TWEEN_LINEAR,       // every node moves along a straight line
+    TWEEN_ANGULAR,      // limbs rotate about their parent joint, keeping their length
+} tween_mode;
+
+/**
+ * Interpolates between two keyframes. Figures are paired in list order
+ * and each pair must share its topology (same node slots and parents).
+ * Results are written into a caller supplied frame, which is reused for
+ * every in-between so nothing is materialized per frame.
+ */
+class tween
+{
+public:
+    tween(frame* from, frame* to, tween_mode mode = TWEEN_ANGULAR) :
+        from_(from),
+        to_(to),
+        mode_(mode)
+    {
+    }
+
+    virtual ~tween() {}
+
+    /**
+     * Do two figures have the same node slots and parent links?
+     */
+    static bool same_topology(figure* a, figure* b);
+
+    /**
+     * Can the keyframes be interpolated (same number of figures, each pair
+     * with the same topology)?
+     */
+    bool is_compatible();
+
+    /**
+     * Create a frame to receive interpolated poses: a copy of the first
+     * keyframe, owned by the caller.
+     */
+    frame* create_frame();
+
+    /**
+     * Pose the figures of a frame created by create_frame() (or otherwise
+     * sharing the keyframe topology).
+     * @param t Position between the keyframes, 0 = from, 1 = to
+     * @return false if the frames are not compatible
+     */
+    bool interpolate(double t, frame* out);
+
+    void set_mode(tween_mode mode) { mode_ = mode; }
+    tween_mode get_mode() { return mode_; }
+
+private:
+    void interpolate_figure(double t, figure* a, figure* b, figure* out);
+
+    frame* from_;
+    frame* to_;
+    tween_mode mode_;
+};
+
+/**
+ * A sequence of keyframes, each followed by a number of generated
+ * in-betweens. Only the keyframes are stored; frame n of the playback is
+ * computed on request.
+ * @note Used by stan_export (-t). The editor's playback still shows the
+ *       stored frames only.
+ */
+class tween_sequence
+{
+public:
+    tween_sequence(tween_mode mode = TWEEN_ANGULAR) :
+        keys_(),
+        mode_(mode)
+    {
+    }
+
+    virtual ~tween_sequence() {}
+
+    /**
+     * Append a keyframe (not owned).
+     * @param steps Number of in-betweens generated after this keyframe
+     *        (ignored for the last keyframe)
+     */
+    void add_key(frame* key, int steps);
+
+    void clear() { keys_.clear(); }
+
+    int get_key_count() { return static_cast<int>(keys_.size()); }
+
+    /**
+     * Number of playback frames: every keyframe plus the in-betweens.
+     */
+    int get_length();
+
+    /**
+     * Create a frame to pass to get_frame(), owned by the caller.
+     * @return NULL if there are no keyframes
+     */
+    frame* create_frame();
+
+    /**
+     * Pose playback frame n into out.
+     * @return false if n is out of range or the keyframes around it are
+     *         not compatible
+     */
+    bool get_frame(int n, frame* out);
+
+private:
+    class key_entry
+    {
+    public:
+        key_entry(frame* key, int steps) :
+            key_(key),
+            steps_(steps)
+        {
+        }
+
+        frame* key_;
+        int steps_;
+    };
+
+    std::vector<key_entry> keys_;
+    tween_mode mode_;
+};
+
+};  // namespace stan
+
+#endif  // _TWEEN_H
@@ -0,0 +1,164 @@
+/**
+ * @file bench_transform.cpp
+ * @brief Microbenchmark of the figure transform loops against the batch
+ *        kernels of trig.h.
+ * @date 10-18-26
+ *
+ * usage: bench_transform [nodes] [repeats]
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <ctime>
+#include <cmath>
+#include <vector>
+
+#include "trig.h"
+
+using namespace stan;
+
+namespace {
+
+const double ANGLE = PI / 8;
+
+/**
+ * A flat figure: every node hangs off the root, as in a crowd of rigs.
+ */
+figure* make_figure(int nodes)
+{
+    figure* fig = new figure(0, 0);
+    for (int n = 1; n < nodes; n++) {
+        fig->create_line(fig->get_root(), n % 1000, n / 1000);
+    }
+    return fig;
+}
+
+/**
+ * The per-node loop rotate_figure() used before the kernels: sin and cos
+ * evaluated twice per node.
+ */
+void rotate_nodes_old(figure* fig, double angle)
+{
+    node* on = fig->get_node(fig->get_root());
+    double dx = on->get_x();
+    double dy = on->get_y();
+    std::vector<node*>& nodes = fig->get_nodes();
+    for (unsigned n = 0; n < nodes.size(); n++) {
+        node* sn = nodes[n];
+        double x = sn->get_x();
+        double y = sn->get_y();
+        sn->set_x( ((x - dx) * cos(angle) - (y - dy) * sin(angle)) + dx );
+        sn->set_y( ((x - dx) * sin(angle) + (y - dy) * cos(angle)) + dy );
+    }
+}
+
+/**
+ * The path figure::rotate() took while a packed copy was current: the
+ * kernel over the packed arrays, then every position written back through
+ * its node, since the nodes hold the real positions.
+ */
+void rotate_store_old(figure* fig, std::vector<double>& x, std::vector<double>& y, double angle)
+{
+    node* on = fig->get_node(fig->get_root());
+    rotate_points(&x[0], &y[0], static_cast<unsigned>(x.size()), angle, on->get_x(), on->get_y());
+    for (unsigned n = 0; n < x.size(); n++) {
+        fig->get_node(n)->move_to(x[n], y[n]);
+    }
+}
+
+void report(const char* name, std::clock_t start, int nodes, int repeats)
+{
+    double seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+    double per_node = seconds * 1e9 / (static_cast<double>(nodes) * repeats);
+
+    // x and y are read and written once per node
+    double bytes = 4.0 * sizeof(double) * nodes * repeats;
+    std::cout << name << ": " << per_node << " ns/node";
+    if (seconds > 0) {
+        std::cout << ", " << (bytes / seconds / 1e9) << " GB/s";
+    }
+    std::cout << std::endl;
+}
+
+};  // namespace
+
+int main(int argc, char* argv[])
+{
+    int nodes = (argc > 1) ? atoi(argv[1]) : 100000;
+    int repeats = (argc > 2) ? atoi(argv[2]) : 200;
+    std::cout << nodes << " nodes, " << repeats << " repeats" << std::endl;
+
+    figure* fig = make_figure(nodes);
+    std::vector<double> x(nodes);
+    std::vector<double> y(nodes);
+    for (int n = 0; n < nodes; n++) {
+        x[n] = fig->get_node(n)->get_x();
+        y[n] = fig->get_node(n)->get_y();
+    }
+
+    std::clock_t start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        rotate_nodes_old(fig, ANGLE);
+    }
+    report("rotate, nodes, old loop   ", start, nodes, repeats);
+
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        fig->rotate(ANGLE);
+    }
+    report("rotate, nodes, in place   ", start, nodes, repeats);
+
+    // packed copy current, as after a paint: kernel plus write-back against
+    // the plain node loop figure::rotate() uses now
+    const node_store& ns = fig->get_node_store();
+    std::vector<double> sx(ns.x_.begin(), ns.x_.end());
+    std::vector<double> sy(ns.y_.begin(), ns.y_.end());
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        rotate_store_old(fig, sx, sy, ANGLE);
+    }
+    report("rotate, store, write-back ", start, nodes, repeats);
+
+    fig->get_node_store();
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        fig->rotate(ANGLE);
+    }
+    report("rotate, store, node loop  ", start, nodes, repeats);
+
+    affine rot = affine::rotation(ANGLE, 0, 0);
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        rot.apply(&x[0], &y[0], nodes);
+    }
+    report("rotate, arrays, scalar    ", start, nodes, repeats);
+
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        rotate_points(&x[0], &y[0], nodes, ANGLE, 0, 0);
+    }
+    report("rotate, arrays, kernel    ", start, nodes, repeats);
+
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        fig->move(1, 1);
+    }
+    report("translate, nodes          ", start, nodes, repeats);
+
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        translate_points(&x[0], &y[0], nodes, 1, 1);
+    }
+    report("translate, arrays, kernel ", start, nodes, repeats);
+
+    start = std::clock();
+    for (int r = 0; r < repeats; r++) {
+        scale_points(&x[0], &y[0], nodes, (r % 2) ? 1.25 : 0.8, 0, 0);
+    }
+    report("scale, arrays, kernel     ", start, nodes, repeats);
+
+    delete fig;
+    return 0;
+}
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,106 @@
+#include <string>
+#include "test_asset_cache.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_asset_cache);
+
+namespace {
+
+int released = 0;
+
+/**
+ * Fake decoder: the asset is the path itself, costing 10 bytes.
+ */
+std::string* load_string(const std::string& path, std::size_t& bytes)
+{
+    if (path.empty()) {
+        return NULL;
+    }
+    bytes = 10;
+    return new std::string(path);
+}
+
+void release_string(std::string* s)
+{
+    released++;
+    delete s;
+}
+
+};  // anonymous namespace
+
+void test_asset_cache::setUp()
+{
+    released = 0;
+}
+
+void test_asset_cache::tearDown()
+{
+}
+
+void test_asset_cache::test_shared_load()
+{
+    asset_cache<std::string> cache(&load_string, 100, &release_string);
+
+    asset_cache<std::string>::handle a = cache.get("a|1", "a.png");
+    asset_cache<std::string>::handle b = cache.get("a|1", "a.png");
+    CPPUNIT_ASSERT(a);
+    CPPUNIT_ASSERT(a.get() == b.get());
+    CPPUNIT_ASSERT(*a == "a.png");
+    CPPUNIT_ASSERT(cache.get_loads() == 1);
+
+    // a changed file gets a new key and is decoded again
+    asset_cache<std::string>::handle c = cache.get("a|2", "a.png");
+    CPPUNIT_ASSERT(c.get() != a.get());
+    CPPUNIT_ASSERT(cache.get_loads() == 2);
+    CPPUNIT_ASSERT(cache.get_live_count() == 2);
+    CPPUNIT_ASSERT(cache.get_live_bytes() == 20);
+    CPPUNIT_ASSERT(cache.get_resident_bytes() == 20);
+
+    // clearing keeps the assets in use
+    a.reset();
+    b.reset();
+    c.reset();
+    CPPUNIT_ASSERT(released == 0);
+    cache.clear();
+    CPPUNIT_ASSERT(released == 2);
+    CPPUNIT_ASSERT(cache.get_live_count() == 0);
+    CPPUNIT_ASSERT(cache.get_resident_bytes() == 0);
+}
+
+void test_asset_cache::test_budget()
+{
+    asset_cache<std::string> cache(&load_string, 20, &release_string);
+
+    asset_cache<std::string>::handle a = cache.get("a", "a.png");
+    cache.get("b", "b.png");
+    cache.get("c", "c.png");
+
+    // a was evicted from the resident set but is still held
+    CPPUNIT_ASSERT(cache.get_resident_bytes() == 20);
+    CPPUNIT_ASSERT(cache.get_live_bytes() == 30);
+    CPPUNIT_ASSERT(released == 0);
+    CPPUNIT_ASSERT(cache.get("a", "a.png").get() == a.get());
+    CPPUNIT_ASSERT(cache.get_loads() == 3);
+
+    // making a resident again pushed out b, which nobody holds
+    CPPUNIT_ASSERT(released == 1);
+    CPPUNIT_ASSERT(cache.get_live_count() == 2);
+    cache.get("b", "b.png");
+    CPPUNIT_ASSERT(cache.get_loads() == 4);
+
+    cache.set_budget(0);
+    CPPUNIT_ASSERT(cache.get_live_count() <= 2);
+    a.reset();
+    cache.clear();
+    CPPUNIT_ASSERT(cache.get_live_count() == 0);
+    CPPUNIT_ASSERT(released == 4);
+}
+
+void test_asset_cache::test_failure()
+{
+    asset_cache<std::string> cache(&load_string, 100);
+
+    CPPUNIT_ASSERT(!cache.get("missing", ""));
+    CPPUNIT_ASSERT(cache.get_loads() == 1);
+    CPPUNIT_ASSERT(cache.get_failures() == 1);
+    CPPUNIT_ASSERT(cache.get_live_count() == 0);
+}
@@ -0,0 +1,46 @@
+#ifndef _TEST_ASSET_CACHE_H
+#define _TEST_ASSET_CACHE_H      1
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "asset_cache.h"
+
+using namespace stan;
+
+class test_asset_cache : public CppUnit::TestFixture
+{
+    private:
+        CPPUNIT_TEST_SUITE(test_asset_cache);
+        CPPUNIT_TEST(test_shared_load);
+        CPPUNIT_TEST(test_budget);
+        CPPUNIT_TEST(test_failure);
+        CPPUNIT_TEST_SUITE_END ();
+
+    public:
+        test_asset_cache()
+        {}
+
+        void setUp();
+        void tearDown();
+
+    protected:
+        /**
+         * Test that an asset is decoded once per key and shared by every
+         * user.
+         */
+        void test_shared_load();
+
+        /**
+         * Test that the byte budget only evicts resident assets and that
+         * assets still in use are found again without a reload.
+         */
+        void test_budget();
+
+        /**
+         * Test that failed loads return empty handles and are counted.
+         */
+        void test_failure();
+};
+
+#endif  // _TEST_ASSET_CACHE_H
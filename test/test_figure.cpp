@@ -1,7 +1,11 @@
 #include <iostream>
+#include <cmath>
 #include <boost/serialization/nvp.hpp>
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
+#include "frame.h"
+#include "trig.h"
+#include "pivot_session.h"
 #include "test_figure.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(test_figure);
@@ -18,6 +22,7 @@ void test_figure::setUp()
 
     int rightarm = stick_fig_->create_line(stick_fig_->get_edge(torso_)->get_n2(), 160, 120);
     stick_fig_->create_line(stick_fig_->get_edge(rightarm)->get_n2(), 140, 100);    // righthand
+    rightarm_ = rightarm;
 
     int leftarm = stick_fig_->create_line(stick_fig_->get_edge(torso_)->get_n2(), 240, 120);
     stick_fig_->create_line(stick_fig_->get_edge(leftarm)->get_n2(), 260, 100);  // lefthand
@@ -224,4 +229,521 @@ void test_figure::test_image_store()
     CPPUNIT_ASSERT(imd->get_image_ptr() == img_ptr3);
 }
 
+void test_figure::test_node_store()
+{
+    const node_store& ns = stick_fig_->get_node_store();
+    CPPUNIT_ASSERT(ns.size() == static_cast<int>(stick_fig_->get_nodes().size()));
+
+    // packed positions, parents and children match the nodes
+    for (int n = 0; n < ns.size(); n++) {
+        node* pn = stick_fig_->get_node(n);
+        CPPUNIT_ASSERT(ns.is_live(n));
+        CPPUNIT_ASSERT(ns.get_x(n) == pn->get_x());
+        CPPUNIT_ASSERT(ns.get_y(n) == pn->get_y());
+        CPPUNIT_ASSERT(ns.get_parent(n) == pn->get_parent());
+
+        const std::list<int>& children = pn->get_children();
+        CPPUNIT_ASSERT(ns.get_child_count(n) == static_cast<int>(children.size()));
+        const int* c = ns.children_begin(n);
+        BOOST_FOREACH(int child, children) {
+            CPPUNIT_ASSERT(*c++ == child);
+        }
+        CPPUNIT_ASSERT(c == ns.children_end(n));
+    }
+
+    // moving the figure keeps the store in step
+    stick_fig_->move(10, -5);
+    const node_store& moved = stick_fig_->get_node_store();
+    CPPUNIT_ASSERT(moved.get_x(stick_fig_->get_root()) == 210);
+    CPPUNIT_ASSERT(moved.get_y(stick_fig_->get_root()) == 135);
+
+    // moving a single node is picked up on the next access
+    int neck = stick_fig_->get_edge(torso_)->get_n2();
+    stick_fig_->get_node(neck)->move_to(1, 2);
+    const node_store& touched = stick_fig_->get_node_store();
+    CPPUNIT_ASSERT(touched.get_x(neck) == 1);
+    CPPUNIT_ASSERT(touched.get_y(neck) == 2);
+
+    // new nodes rebuild the topology arrays
+    int count = touched.size();
+    stick_fig_->create_line(neck, 5, 5);
+    const node_store& grown = stick_fig_->get_node_store();
+    CPPUNIT_ASSERT(grown.size() == count + 1);
+    CPPUNIT_ASSERT(grown.get_parent(count) == neck);
+
+    // a copied figure tracks its own nodes
+    figure copy(*stick_fig_);
+    copy.get_node(neck)->move_to(7, 7);
+    CPPUNIT_ASSERT(copy.get_node_store().get_x(neck) == 7);
+    CPPUNIT_ASSERT(stick_fig_->get_node_store().get_x(neck) == 1);
+}
+
+void test_figure::test_edge_index()
+{
+    // every edge is found by its endpoints
+    std::vector<edge*>& edges = stick_fig_->get_edges();
+    for (unsigned eindex = 0; eindex < edges.size(); eindex++) {
+        edge* e = edges[eindex];
+        CPPUNIT_ASSERT(stick_fig_->get_edge(e->get_n1(), e->get_n2()) == static_cast<int>(eindex));
+        CPPUNIT_ASSERT(stick_fig_->find_edge(e->get_n1(), e->get_n2()) == e);
+    }
+    CPPUNIT_ASSERT(stick_fig_->get_edge(-1, 0) == -1);
+    CPPUNIT_ASSERT(stick_fig_->find_edge(0, 0) == NULL);
+
+    // a duplicate edge does not hide the first one
+    int neck = stick_fig_->get_edge(torso_)->get_n2();
+    int root = stick_fig_->get_root();
+    CPPUNIT_ASSERT(stick_fig_->get_edge(root, neck) == torso_);
+    stick_fig_->create_circle(root, neck);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(root, neck) == torso_);
+    int dup = stick_fig_->create_circle(neck, root);
+    stick_fig_->create_circle(neck, root);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(neck, root) == dup);
+
+    // cut the arms and head off at the neck, remaining edges are still found
+    stick_fig_->remove_decendants(neck);
+    CPPUNIT_ASSERT(stick_fig_->get_nodes().size() == 8);
+    CPPUNIT_ASSERT(stick_fig_->get_node(neck)->get_children().size() == 0);
+    for (unsigned eindex = 0; eindex < edges.size(); eindex++) {
+        edge* e = edges[eindex];
+        CPPUNIT_ASSERT(e->get_n1() < 8 && e->get_n2() < 8);
+        CPPUNIT_ASSERT(stick_fig_->get_edge(e->get_n1(), e->get_n2()) <= static_cast<int>(eindex));
+    }
+    CPPUNIT_ASSERT(stick_fig_->get_edge(root, neck) == torso_);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(neck, root) != -1);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(neck, neck + 1) == -1);
+
+    // legs are intact: root -> thigh -> shin -> foot
+    node* rn = stick_fig_->get_node(root);
+    BOOST_FOREACH(int thigh, rn->get_children()) {
+        CPPUNIT_ASSERT(stick_fig_->get_edge(root, thigh) != -1);
+    }
+
+    // removing a single edge hands its entry to the next duplicate and
+    // shifts the later entries down
+    int first = stick_fig_->get_edge(neck, root);
+    stick_fig_->remove_edge(first);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(neck, root) == first);
+    stick_fig_->remove_edge(first);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(neck, root) == -1);
+    stick_fig_->remove_edge(torso_);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(root, neck) != -1);
+    for (unsigned eindex = 0; eindex < edges.size(); eindex++) {
+        edge* e = edges[eindex];
+        CPPUNIT_ASSERT(stick_fig_->get_edge(e->get_n1(), e->get_n2()) <= static_cast<int>(eindex));
+        CPPUNIT_ASSERT(stick_fig_->find_edge(e->get_n1(), e->get_n2()) == edges[stick_fig_->get_edge(e->get_n1(), e->get_n2())]);
+    }
+}
+
+void test_figure::test_stable_handles()
+{
+    int count = static_cast<int>(stick_fig_->get_nodes().size());
+    int root = stick_fig_->get_root();
+    int neck = stick_fig_->get_edge(torso_)->get_n2();
+    int rightarm = stick_fig_->get_edge(rightarm_)->get_n2();
+    int lefthand = count - 7;   // last node of the left arm
+    node_handle neck_handle = stick_fig_->get_handle(neck);
+    node_handle arm_handle = stick_fig_->get_handle(rightarm);
+    node_handle hand_handle = stick_fig_->get_handle(lefthand);
+    node* hand = stick_fig_->get_node(lefthand);
+
+    // cutting the right arm leaves empty slots and renumbers nothing
+    stick_fig_->set_stable_handles(true);
+    stick_fig_->remove_children(rightarm);
+    CPPUNIT_ASSERT(static_cast<int>(stick_fig_->get_nodes().size()) == count);
+    CPPUNIT_ASSERT(stick_fig_->get_free_count() == 2);
+    CPPUNIT_ASSERT(!stick_fig_->is_valid(arm_handle));
+    CPPUNIT_ASSERT(stick_fig_->get_node(arm_handle) == NULL);
+    CPPUNIT_ASSERT(stick_fig_->get_node(hand_handle) == hand);
+    CPPUNIT_ASSERT(stick_fig_->get_node(rightarm) == NULL);
+    CPPUNIT_ASSERT(stick_fig_->get_edge(neck, rightarm) == -1);
+    BOOST_FOREACH(int c, stick_fig_->get_node(neck)->get_children()) {
+        CPPUNIT_ASSERT(c != rightarm);
+    }
+
+    // hit testing and the packed store skip empty slots
+    const node_store& ns = stick_fig_->get_node_store();
+    CPPUNIT_ASSERT(!ns.is_live(rightarm));
+    int found = -1;
+    CPPUNIT_ASSERT(!stick_fig_->get_node_at_pos(found, 160, 120, 2));
+
+    // copies keep the same indices
+    figure copy(*stick_fig_);
+    CPPUNIT_ASSERT(copy.get_node(rightarm) == NULL);
+    CPPUNIT_ASSERT(copy.get_node(lefthand)->get_x() == hand->get_x());
+
+    // new nodes reuse an empty slot with a new generation
+    int eindex = stick_fig_->create_line(neck, 1, 1);
+    int reused = stick_fig_->get_edge(eindex)->get_n2();
+    CPPUNIT_ASSERT(static_cast<int>(stick_fig_->get_nodes().size()) == count);
+    CPPUNIT_ASSERT(stick_fig_->get_free_count() == 1);
+    CPPUNIT_ASSERT(reused == rightarm);
+    CPPUNIT_ASSERT(!stick_fig_->is_valid(arm_handle));
+    CPPUNIT_ASSERT(stick_fig_->is_valid(stick_fig_->get_handle(reused)));
+
+    // compacting renumbers everything and invalidates all handles
+    std::vector<int> remap;
+    CPPUNIT_ASSERT(stick_fig_->compact(&remap) == 1);
+    CPPUNIT_ASSERT(static_cast<int>(stick_fig_->get_nodes().size()) == count - 1);
+    CPPUNIT_ASSERT(stick_fig_->get_free_count() == 0);
+    CPPUNIT_ASSERT(!stick_fig_->is_valid(neck_handle));
+    CPPUNIT_ASSERT(stick_fig_->get_root() == remap[root]);
+    CPPUNIT_ASSERT(stick_fig_->get_node(remap[lefthand]) == hand);
+
+    std::vector<edge*>& edges = stick_fig_->get_edges();
+    CPPUNIT_ASSERT(edges.size() == static_cast<unsigned>(count - 2));
+    BOOST_FOREACH(edge* e, edges) {
+        node* n2 = stick_fig_->get_node(e->get_n2());
+        CPPUNIT_ASSERT(n2 != NULL);
+        CPPUNIT_ASSERT(n2->get_parent() == e->get_n1());
+    }
+
+    // without stable handles removal compacts immediately
+    stick_fig_->set_stable_handles(false);
+    stick_fig_->remove_children(remap[lefthand]);
+    CPPUNIT_ASSERT(static_cast<int>(stick_fig_->get_nodes().size()) == count - 2);
+    CPPUNIT_ASSERT(stick_fig_->get_free_count() == 0);
+}
+
+void test_figure::test_shared_meta_store()
+{
+    std::string path = "images/hat.png";
+    meta_store* meta = stick_fig_->edit_meta_store();
+    int index = meta->add_meta_data(path, NULL, META_IMAGE);
+
+    // copies share the store and the path strings
+    CPPUNIT_ASSERT(intern_path(path) == intern_path(std::string("images/hat.png")));
+    figure copy(*stick_fig_);
+    CPPUNIT_ASSERT(copy.get_meta_store() == stick_fig_->get_meta_store());
+    CPPUNIT_ASSERT(copy.is_meta_store_shared());
+
+    // both figures go into one archive, the store is written once
+    std::vector<figure*> figures;
+    figures.push_back(stick_fig_);
+    figures.push_back(&copy);
+    std::string filename = "test_shared_meta.xml";
+    {
+        std::ofstream ofs(filename.c_str());
+        boost::archive::xml_oarchive oa(ofs);
+        oa << boost::serialization::make_nvp("figures", figures);
+    }
+    std::vector<figure*> loaded;
+    {
+        std::ifstream ifs(filename.c_str());
+        boost::archive::xml_iarchive ia(ifs);
+        ia >> boost::serialization::make_nvp("figures", loaded);
+    }
+    CPPUNIT_ASSERT(loaded.size() == 2);
+    CPPUNIT_ASSERT(loaded[0]->get_meta_store() == loaded[1]->get_meta_store());
+    CPPUNIT_ASSERT(loaded[1]->get_meta_store()->get_meta_data(index)->get_path() == path);
+    delete loaded[0];
+    delete loaded[1];
+
+    // changing one copy leaves the other untouched
+    std::string other = "images/cane.png";
+    copy.edit_meta_store()->add_meta_data(other, NULL, META_IMAGE);
+    CPPUNIT_ASSERT(copy.get_meta_store() != stick_fig_->get_meta_store());
+    CPPUNIT_ASSERT(!copy.is_meta_store_shared());
+    CPPUNIT_ASSERT(!stick_fig_->is_meta_store_shared());
+    CPPUNIT_ASSERT(copy.get_meta_store()->get_meta_table().size() == 2);
+    CPPUNIT_ASSERT(stick_fig_->get_meta_store()->get_meta_table().size() == 1);
+}
+
 // END of this file -----------------------------------------------------------
+
+void test_figure::test_bounds()
+{
+    double x1, y1, x2, y2;
+    CPPUNIT_ASSERT(stick_fig_->get_bounds(x1, y1, x2, y2));
+    CPPUNIT_ASSERT(x1 == 140 && y1 == 70 && x2 == 260 && y2 == 200);
+
+    // moving the figure moves the box
+    stick_fig_->move(10, 5);
+    CPPUNIT_ASSERT(stick_fig_->get_bounds(x1, y1, x2, y2));
+    CPPUNIT_ASSERT(x1 == 150 && y1 == 75 && x2 == 270 && y2 == 205);
+
+    // so does moving a single node
+    stick_fig_->get_node(5)->move_to(0, 0);
+    CPPUNIT_ASSERT(stick_fig_->get_bounds(x1, y1, x2, y2));
+    CPPUNIT_ASSERT(x1 == 0 && y1 == 0 && x2 == 270 && y2 == 205);
+
+    // circles extend past their end points
+    figure head(0, 0);
+    int circle = head.create_circle(head.get_root(), 0, 20);
+    CPPUNIT_ASSERT(head.get_bounds(x1, y1, x2, y2));
+    CPPUNIT_ASSERT(x1 == -10 && y1 == 0 && x2 == 10 && y2 == 20);
+
+    head.remove_edge(circle);
+    CPPUNIT_ASSERT(head.get_bounds(x1, y1, x2, y2));
+    CPPUNIT_ASSERT(x1 == 0 && y1 == 0 && x2 == 0 && y2 == 20);
+}
+
+void test_figure::test_archive_io()
+{
+    archive_format formats[] = { ARCHIVE_XML, ARCHIVE_BINARY };
+    for (int i = 0; i < 2; i++) {
+        std::string filename = "test_archive_io.fig";
+        CPPUNIT_ASSERT(save_figure(stick_fig_, filename, formats[i]));
+        CPPUNIT_ASSERT(detect_archive_format(filename) == formats[i]);
+
+        // the format is detected on load
+        figure* loaded = load_figure(filename);
+        CPPUNIT_ASSERT(loaded != NULL);
+        CPPUNIT_ASSERT(loaded->get_nodes().size() == stick_fig_->get_nodes().size());
+        CPPUNIT_ASSERT(loaded->get_edges().size() == stick_fig_->get_edges().size());
+        CPPUNIT_ASSERT(loaded->get_node(5)->get_x() == stick_fig_->get_node(5)->get_x());
+        CPPUNIT_ASSERT(loaded->get_edge(2)->get_type() == edge::edge_circle);
+        delete loaded;
+    }
+
+    CPPUNIT_ASSERT(detect_archive_format("no_such_file.fig") == ARCHIVE_UNKNOWN);
+    CPPUNIT_ASSERT(load_figure("no_such_file.fig") == NULL);
+}
+
+void test_figure::test_arena()
+{
+    boost::shared_ptr<graph_arena> arena(new graph_arena());
+    int nodes = static_cast<int>(stick_fig_->get_nodes().size());
+    int edges = static_cast<int>(stick_fig_->get_edges().size());
+
+    // two copies share one arena
+    figure* a = new figure(*stick_fig_, arena);
+    figure* b = new figure(*stick_fig_, arena);
+    CPPUNIT_ASSERT(a->get_arena() == arena);
+    CPPUNIT_ASSERT(arena->get_node_count() == 2 * nodes);
+    CPPUNIT_ASSERT(arena->get_edge_count() == 2 * edges);
+    CPPUNIT_ASSERT(a->get_node(5)->get_x() == stick_fig_->get_node(5)->get_x());
+    CPPUNIT_ASSERT(a->get_edge(2)->get_type() == edge::edge_circle);
+
+    // edits allocate from and return to the arena
+    a->create_line(a->get_root(), 10, 10);
+    CPPUNIT_ASSERT(arena->get_node_count() == 2 * nodes + 1);
+    CPPUNIT_ASSERT(arena->get_edge_count() == 2 * edges + 1);
+    a->remove_children(a->get_edge(rightarm_)->get_n2());
+    CPPUNIT_ASSERT(arena->get_node_count() == 2 * nodes - 1);
+    CPPUNIT_ASSERT(arena->get_edge_count() == 2 * edges - 1);
+
+    // a plain copy of an arena figure does not use the arena
+    figure* c = new figure(*a);
+    CPPUNIT_ASSERT(!c->get_arena());
+    CPPUNIT_ASSERT(arena->get_node_count() == 2 * nodes - 1);
+    CPPUNIT_ASSERT(c->get_nodes().size() == a->get_nodes().size());
+    delete c;
+
+    // a figure leaving a shared arena hands its objects back
+    delete a;
+    CPPUNIT_ASSERT(arena->get_node_count() == nodes);
+    CPPUNIT_ASSERT(arena->get_edge_count() == edges);
+
+    // the last one leaves them to the arena
+    arena.reset();
+    CPPUNIT_ASSERT(b->get_arena()->get_node_count() == nodes);
+    b->get_node(5)->move(1, 1);
+    delete b;
+
+    // frame copies put all of their figures into one new arena
+    frame fr;
+    fr.add_figure(stick_fig_);
+    fr.add_figure(new figure(*stick_fig_));
+    frame copy(fr);
+    std::list<figure*>& figures = copy.get_figures();
+    CPPUNIT_ASSERT(figures.size() == 2);
+    CPPUNIT_ASSERT(figures.front()->get_arena());
+    CPPUNIT_ASSERT(figures.front()->get_arena() == figures.back()->get_arena());
+    CPPUNIT_ASSERT(figures.front()->get_arena()->get_node_count() == 2 * nodes);
+    delete fr.get_figures().back();
+    BOOST_FOREACH(figure* f, figures) {
+        delete f;
+    }
+}
+
+void test_figure::test_transform()
+{
+    int root = stick_fig_->get_root();
+    int neck = stick_fig_->get_edge(torso_)->get_n2();
+    int elbow = stick_fig_->get_edge(rightarm_)->get_n2();
+    const double quarter = 1.57079632679489661923;   // pi / 2
+    const double eps = 1e-9;
+
+    // only the listed nodes move
+    std::list<int> arm;
+    arm.push_back(elbow);
+    stick_fig_->transform(affine::translation(5, -5), arm);
+    CPPUNIT_ASSERT(stick_fig_->get_node(elbow)->get_x() == 165);
+    CPPUNIT_ASSERT(stick_fig_->get_node(elbow)->get_y() == 115);
+    CPPUNIT_ASSERT(stick_fig_->get_node(neck)->get_x() == 200);
+
+    // a quarter turn about the root
+    stick_fig_->get_node_store();
+    stick_fig_->rotate(quarter);
+    CPPUNIT_ASSERT(stick_fig_->get_node(root)->get_x() == 200);
+    CPPUNIT_ASSERT(stick_fig_->get_node(root)->get_y() == 140);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(neck)->get_x() - 240) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(neck)->get_y() - 140) < eps);
+
+    // the packed copy was transformed along with the nodes
+    const node_store& ns = stick_fig_->get_node_store();
+    for (int n = 0; n < ns.size(); n++) {
+        CPPUNIT_ASSERT(ns.get_x(n) == stick_fig_->get_node(n)->get_x());
+        CPPUNIT_ASSERT(ns.get_y(n) == stick_fig_->get_node(n)->get_y());
+    }
+
+    // three more quarter turns go full circle, the root never drifts
+    for (int i = 0; i < 3; i++) {
+        stick_fig_->rotate(quarter);
+    }
+    CPPUNIT_ASSERT(stick_fig_->get_node(root)->get_x() == 200);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(neck)->get_y() - 100) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_x() - 165) < eps);
+
+    // scaling keeps the root in place
+    stick_fig_->scale(2);
+    CPPUNIT_ASSERT(stick_fig_->get_node(root)->get_y() == 140);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(neck)->get_y() - 60) < eps);
+
+    // the batch kernels give the same results as the scalar transform,
+    // an odd count exercises the tail loop
+    double kx[5] = { 1, -2, 3.5, 40, 0 };
+    double ky[5] = { 0, 7, -1, 2.25, 9 };
+    double sx[5];
+    double sy[5];
+    for (int i = 0; i < 5; i++) {
+        sx[i] = kx[i];
+        sy[i] = ky[i];
+        affine::rotation(0.3, 2, 3).apply(sx[i], sy[i]);
+    }
+    rotate_points(kx, ky, 5, 0.3, 2, 3);
+    for (int i = 0; i < 5; i++) {
+        CPPUNIT_ASSERT(kx[i] == sx[i]);
+        CPPUNIT_ASSERT(ky[i] == sy[i]);
+    }
+    translate_points(kx, ky, 5, 1, -1);
+    scale_points(kx, ky, 5, 2, kx[0], ky[0]);
+    CPPUNIT_ASSERT(kx[0] == sx[0] + 1);
+    CPPUNIT_ASSERT(fabs(kx[4] - (2 * (sx[4] - sx[0]) + sx[0] + 1)) < eps);
+}
+
+void test_figure::test_pivot_session()
+{
+    int shoulder = stick_fig_->get_edge(rightarm_)->get_n1();
+    int elbow = stick_fig_->get_edge(rightarm_)->get_n2();
+    int hand = stick_fig_->get_edge(rightarm_ + 1)->get_n2();
+    int lefthand = stick_fig_->get_edge(rightarm_ + 3)->get_n2();
+    const double quarter = 1.57079632679489661923;   // pi / 2
+    const double eps = 1e-9;
+
+    pivot_session pivot(stick_fig_, elbow);
+    CPPUNIT_ASSERT(pivot.get_pivot() == shoulder);
+    CPPUNIT_ASSERT(pivot.get_nodes().size() == 2);
+    CPPUNIT_ASSERT(pivot.get_selected() == elbow);
+    CPPUNIT_ASSERT(fabs(pivot.get_radius() - sqrt(60.0 * 60.0)) < eps);    // hand at (140, 100)
+    CPPUNIT_ASSERT(!pivot.apply());
+
+    // only the latest angle is applied
+    pivot.set_angle(1.0);
+    pivot.set_angle(quarter);
+    CPPUNIT_ASSERT(pivot.is_pending());
+    CPPUNIT_ASSERT(pivot.apply());
+    CPPUNIT_ASSERT(!pivot.is_pending());
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_x() - 180) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_y() - 60) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(hand)->get_x() - 200) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(hand)->get_y() - 40) < eps);
+    CPPUNIT_ASSERT(stick_fig_->get_node(lefthand)->get_x() == 260);
+
+    pivot.set_angle(quarter);
+    CPPUNIT_ASSERT(!pivot.apply());
+
+    // the base pose comes back exactly
+    pivot.reset();
+    CPPUNIT_ASSERT(stick_fig_->get_node(elbow)->get_x() == 160);
+    CPPUNIT_ASSERT(stick_fig_->get_node(elbow)->get_y() == 120);
+    CPPUNIT_ASSERT(stick_fig_->get_node(hand)->get_x() == 140);
+}
+
+void test_figure::test_skeleton()
+{
+    int root = stick_fig_->get_root();
+    int elbow = stick_fig_->get_edge(rightarm_)->get_n2();
+    int hand = stick_fig_->get_edge(rightarm_ + 1)->get_n2();
+    int lefthand = stick_fig_->get_edge(rightarm_ + 3)->get_n2();
+    const double quarter = 1.57079632679489661923;   // pi / 2
+    const double eps = 1e-9;
+
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_bone_length(hand) - sqrt(800.0)) < eps);
+    CPPUNIT_ASSERT(!stick_fig_->is_skeleton_dirty());
+
+    // the edit itself moves nothing, only the elbow and the hand below it
+    // are solved
+    stick_fig_->rotate_bone(elbow, quarter);
+    CPPUNIT_ASSERT(stick_fig_->is_skeleton_dirty());
+    CPPUNIT_ASSERT(stick_fig_->solve_skeleton() == 2);
+    CPPUNIT_ASSERT(!stick_fig_->is_skeleton_dirty());
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_x() - 180) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_y() - 60) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(hand)->get_x() - 200) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(hand)->get_y() - 40) < eps);
+    CPPUNIT_ASSERT(stick_fig_->get_node(lefthand)->get_x() == 260);
+    CPPUNIT_ASSERT(stick_fig_->solve_skeleton() == 0);
+
+    // nested changes are solved in one walk of the outer subtree
+    stick_fig_->rotate_bone(hand, quarter);
+    stick_fig_->rotate_bone(elbow, -quarter);
+    CPPUNIT_ASSERT(stick_fig_->solve_skeleton() == 2);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_x() - 160) < eps);
+    stick_fig_->rotate_bone(hand, -quarter);
+    stick_fig_->rotate_bone(elbow, quarter);
+    CPPUNIT_ASSERT(stick_fig_->solve_skeleton() == 2);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(hand)->get_x() - 200) < eps);
+
+    // readers of the packed store see solved positions
+    stick_fig_->set_bone_length(hand, 10);
+    const node_store& ns = stick_fig_->get_node_store();
+    double dx = ns.get_x(hand) - ns.get_x(elbow);
+    double dy = ns.get_y(hand) - ns.get_y(elbow);
+    CPPUNIT_ASSERT(fabs(sqrt((dx * dx) + (dy * dy)) - 10) < eps);
+
+    // a world space edit rebuilds the bones
+    stick_fig_->move(5, 0);
+    stick_fig_->rotate_bone(root, quarter);
+    stick_fig_->solve_skeleton();
+    CPPUNIT_ASSERT(stick_fig_->get_node(root)->get_x() == 205);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(lefthand)->get_x() - (205 + 40)) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(lefthand)->get_y() - (140 + 60)) < eps);
+}
+
+void test_figure::test_skeleton_pending()
+{
+    int elbow = stick_fig_->get_edge(rightarm_)->get_n2();
+    int hand = stick_fig_->get_edge(rightarm_ + 1)->get_n2();
+    const double quarter = 1.57079632679489661923;   // pi / 2
+    const double eps = 1e-9;
+
+    // reading a node solves first
+    stick_fig_->rotate_bone(elbow, quarter);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_x() - 180) < eps);
+    CPPUNIT_ASSERT(!stick_fig_->is_skeleton_dirty());
+    stick_fig_->rotate_bone(elbow, -quarter);
+    stick_fig_->get_node(hand)->move(1, 0);
+    stick_fig_->get_node(hand)->move(-1, 0);
+    CPPUNIT_ASSERT(stick_fig_->get_node(elbow)->get_x() == 160);
+
+    // a copy carries the bone change
+    stick_fig_->rotate_bone(elbow, quarter);
+    figure copy(*stick_fig_);
+    CPPUNIT_ASSERT(fabs(copy.get_node(elbow)->get_x() - 180) < eps);
+    CPPUNIT_ASSERT(fabs(copy.get_node(hand)->get_y() - 40) < eps);
+
+    // edge edits and moves solve before the bones are rebuilt
+    stick_fig_->rotate_bone(elbow, -quarter);
+    stick_fig_->set_weight(3);
+    CPPUNIT_ASSERT(!stick_fig_->is_skeleton_dirty());
+    CPPUNIT_ASSERT(stick_fig_->get_node(elbow)->get_x() == 160);
+
+    stick_fig_->rotate_bone(elbow, quarter);
+    stick_fig_->move(5, 0);
+    CPPUNIT_ASSERT(!stick_fig_->is_skeleton_dirty());
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_x() - 185) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(elbow)->get_y() - 60) < eps);
+    CPPUNIT_ASSERT(fabs(stick_fig_->get_node(hand)->get_x() - 205) < eps);
+}
@@ -5,6 +5,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "figure.h"
+#include "archive_io.h"
 
 using namespace stan;
 
@@ -18,6 +19,17 @@ class test_figure : public CppUnit::TestFixture
         CPPUNIT_TEST(test_clone_subtree);
         CPPUNIT_TEST(test_remove_nodes);
         CPPUNIT_TEST(test_image_store);
+        CPPUNIT_TEST(test_node_store);
+        CPPUNIT_TEST(test_edge_index);
+        CPPUNIT_TEST(test_stable_handles);
+        CPPUNIT_TEST(test_bounds);
+        CPPUNIT_TEST(test_archive_io);
+        CPPUNIT_TEST(test_shared_meta_store);
+        CPPUNIT_TEST(test_arena);
+        CPPUNIT_TEST(test_transform);
+        CPPUNIT_TEST(test_pivot_session);
+        CPPUNIT_TEST(test_skeleton);
+        CPPUNIT_TEST(test_skeleton_pending);
         CPPUNIT_TEST_SUITE_END ();
 
     public:
@@ -59,6 +71,69 @@ class test_figure : public CppUnit::TestFixture
          */
         void test_image_store();
 
+        /**
+         * Test that the packed node store tracks the figure nodes.
+         */
+        void test_node_store();
+
+        /**
+         * Test edge lookup by endpoints across edits, including single
+         * edge removal which updates the index in place.
+         */
+        void test_edge_index();
+
+        /**
+         * Test node removal with stable handles and compaction.
+         */
+        void test_stable_handles();
+
+        /**
+         * Test that the cached bounding box follows changes to the figure.
+         */
+        void test_bounds();
+
+        /**
+         * Test saving and loading a figure through archive_io, in XML and
+         * binary format.
+         */
+        void test_archive_io();
+
+        /**
+         * Test copies share the meta store until one of them changes it,
+         * and that shared stores survive serialization.
+         */
+        void test_shared_meta_store();
+
+        /**
+         * Test figures allocating their nodes and edges from a shared
+         * arena, including removal and copies out of the arena.
+         */
+        void test_arena();
+
+        /**
+         * Test in place affine transforms of a node subset and of the whole
+         * figure, including the packed node store kept in step.
+         */
+        void test_transform();
+
+        /**
+         * Test a pivot drag rotating a subtree from its base pose, with
+         * angles coalesced until applied.
+         */
+        void test_pivot_session();
+
+        /**
+         * Test bone edits in local space, solved lazily into the nodes,
+         * and the bones following world space edits.
+         */
+        void test_skeleton();
+
+        /**
+         * Test that node reads, copies and world space edits keep bone
+         * changes which were not solved yet.
+         */
+        void test_skeleton_pending();
+
     private:
         figure* stick_fig_;
         int torso_;
@@ -1,8 +1,13 @@
 #include <iostream>
+#include <boost/weak_ptr.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include "test_frame.h"
+#include "indexed_animation.h"
+#include "packed_animation.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(test_frame);
 
@@ -92,3 +97,325 @@ void test_frame::test_iterator()
 }
 
 // END of this file -----------------------------------------------------------
+
+void test_frame::test_figure_at_pos()
+{
+    // frame position is subtracted from the query
+    frame fr(5, 10, 640, 480);
+
+    figure* fig1 = test_fr_->get_first_figure();
+    figure* fig2(new figure(60, 50));
+    fig2->create_line(fig2->get_root(), 60, 120);
+    fr.add_figure(fig1);
+    fr.add_figure(fig2);
+
+    figure* fig3 = NULL;
+    const int radius = 4;
+    for (int pass = 0; pass < 4; pass++) {
+        for (int y = 0; y < 150; y += 3) {
+            for (int x = 0; x < 200; x += 3) {
+                figure* expect_fig = NULL;
+                int expect_n = -1;
+                BOOST_FOREACH(figure* f, fr.get_figures()) {
+                    if (f->get_node_at_pos(expect_n, x - 5, y - 10, radius)) {
+                        expect_fig = f;
+                        break;
+                    }
+                }
+
+                figure* fig = NULL;
+                int n = -1;
+                bool found = fr.get_figure_at_pos(x, y, radius, fig, n);
+                CPPUNIT_ASSERT_EQUAL(expect_fig != NULL, found);
+                if (found) {
+                    CPPUNIT_ASSERT(fig == expect_fig);
+                    CPPUNIT_ASSERT_EQUAL(expect_n, n);
+                }
+            }
+        }
+
+        if (pass == 0) {
+            // move one figure and a single node of the other
+            fig2->move(40, 20);
+            fig1->get_node(1)->move(-30, 30);
+        }
+        else if (pass == 1) {
+            fr.remove_figure(fig2);
+            delete fig2;
+        }
+        else if (pass == 2) {
+            // a new figure, possibly where the deleted one lived
+            fig3 = new figure(60, 50);
+            fig3->create_line(fig3->get_root(), 60, 120);
+            fr.add_figure(fig3);
+            fig3->move(10, 0);
+        }
+    }
+
+    // a figure deleted while indexed takes its entries with it
+    delete fig3;
+    fr.get_figures().remove(fig3);
+    fr.touch();
+    figure* fig = NULL;
+    int n = -1;
+    CPPUNIT_ASSERT(!fr.get_figure_at_pos(75, 60, radius, fig, n));
+}
+
+void test_frame::test_binary_animation()
+{
+    animation anim;
+    for (int i = 0; i < 3; i++) {
+        frame* fr = new frame(*test_fr_);
+        fr->get_first_figure()->move(i * 10, 0);
+        anim.add_frame(fr);
+    }
+
+    std::string filename = "test_frame.anb";
+    CPPUNIT_ASSERT(save_animation(&anim, filename, ARCHIVE_BINARY));
+    CPPUNIT_ASSERT(detect_archive_format(filename) == ARCHIVE_BINARY);
+
+    animation* loaded = load_animation(filename);
+    CPPUNIT_ASSERT(loaded != NULL);
+    CPPUNIT_ASSERT(loaded->get_frames().size() == 3);
+
+    int i = 0;
+    BOOST_FOREACH(frame* fr, loaded->get_frames()) {
+        CPPUNIT_ASSERT(fr->get_width() == 640);
+        figure* fig = fr->get_first_figure();
+        CPPUNIT_ASSERT(fig != NULL);
+        CPPUNIT_ASSERT(fig->get_nodes().size() == 4);
+        CPPUNIT_ASSERT(fig->get_node(fig->get_root())->get_x() == 50 + i * 10);
+        i++;
+    }
+    delete loaded;
+}
+
+void test_frame::test_indexed_animation()
+{
+    animation anim;
+    for (int i = 0; i < 10; i++) {
+        frame* fr = new frame(*test_fr_);
+        fr->get_first_figure()->move(i * 10, 0);
+        anim.add_frame(fr);
+    }
+
+    std::string filename = "test_frame.ani";
+    CPPUNIT_ASSERT(save_animation(&anim, filename, ARCHIVE_INDEXED));
+    CPPUNIT_ASSERT(detect_archive_format(filename) == ARCHIVE_INDEXED);
+
+    indexed_animation indexed(3);
+    CPPUNIT_ASSERT(indexed.open(filename));
+    CPPUNIT_ASSERT(indexed.get_frame_count() == 10);
+    CPPUNIT_ASSERT(indexed.get_meta_store() != NULL);
+    CPPUNIT_ASSERT(indexed.get_resident_count() == 0);
+
+    // random access, only the requested frames are materialized
+    int order[] = { 7, 2, 9, 0, 7, 5 };
+    boost::shared_ptr<frame> held = indexed.get_frame(order[0]);
+    for (unsigned i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        boost::shared_ptr<frame> fr = indexed.get_frame(order[i]);
+        CPPUNIT_ASSERT(fr);
+        figure* fig = fr->get_first_figure();
+        CPPUNIT_ASSERT(fig->get_node(fig->get_root())->get_x() == 50 + order[i] * 10);
+        CPPUNIT_ASSERT(indexed.get_resident_count() <= 3);
+    }
+    CPPUNIT_ASSERT(!indexed.get_frame(10));
+    CPPUNIT_ASSERT(!indexed.get_frame(-1));
+
+    // evicted frames stay valid while they are held
+    indexed.set_resident_limit(1);
+    CPPUNIT_ASSERT(indexed.get_resident_count() == 1);
+    CPPUNIT_ASSERT(held->get_first_figure()->get_nodes().size() == 4);
+
+    animation* loaded = load_animation(filename);
+    CPPUNIT_ASSERT(loaded != NULL);
+    CPPUNIT_ASSERT(loaded->get_frames().size() == 10);
+    delete loaded;
+
+    indexed.close();
+    CPPUNIT_ASSERT(!indexed.is_open());
+    CPPUNIT_ASSERT(!indexed.open("test_frame.anb"));
+}
+
+void test_frame::test_incremental_save()
+{
+    animation anim;
+    std::vector<frame*> frames;
+    for (int i = 0; i < 10; i++) {
+        frame* fr = new frame(*test_fr_);
+        fr->get_first_figure()->move(i * 10, 0);
+        anim.add_frame(fr);
+        frames.push_back(fr);
+    }
+
+    std::string filename = "test_frame.anx";
+    indexed_writer writer;
+    CPPUNIT_ASSERT(writer.save(&anim, filename));
+    CPPUNIT_ASSERT(writer.get_written_frames() == 10);
+
+    // nothing changed, saving compacts but must not dirty the frames
+    CPPUNIT_ASSERT(writer.save(&anim, filename));
+    CPPUNIT_ASSERT(writer.get_written_frames() == 0);
+
+    // only edited frames are written
+    frames[3]->get_first_figure()->move(0, 5);
+    frames[7]->set_image_index(2);
+    CPPUNIT_ASSERT(writer.save(&anim, filename));
+    CPPUNIT_ASSERT(writer.get_written_frames() == 2);
+
+    frame* added = new frame(*test_fr_);
+    anim.add_frame(added);
+    anim.del_frame(frames[0]);
+    CPPUNIT_ASSERT(writer.save(&anim, filename));
+    CPPUNIT_ASSERT(writer.get_written_frames() == 1);
+
+    indexed_animation indexed;
+    CPPUNIT_ASSERT(indexed.open(filename));
+    CPPUNIT_ASSERT(indexed.get_frame_count() == 10);
+    figure* fig = indexed.get_frame(2)->get_first_figure();
+    CPPUNIT_ASSERT(fig->get_node(fig->get_root())->get_x() == 80);
+    CPPUNIT_ASSERT(fig->get_node(fig->get_root())->get_y() == 55);
+    CPPUNIT_ASSERT(indexed.get_frame(6)->get_image_index() == 2);
+    fig = indexed.get_frame(9)->get_first_figure();
+    CPPUNIT_ASSERT(fig->get_node(fig->get_root())->get_x() == 50);
+    indexed.close();
+
+    // the line weight is saved, changing only it dirties the frame
+    int weight = frames[5]->get_first_figure()->get_weight();
+    CPPUNIT_ASSERT(frames[5]->get_first_figure()->thicker());
+    CPPUNIT_ASSERT(writer.save(&anim, filename));
+    CPPUNIT_ASSERT(writer.get_written_frames() == 1);
+    CPPUNIT_ASSERT(indexed.open(filename));
+    CPPUNIT_ASSERT(indexed.get_frame(4)->get_first_figure()->get_weight() == weight + 1);
+    indexed.close();
+
+    // a different file is always written in full
+    CPPUNIT_ASSERT(writer.save(&anim, "test_frame2.anx"));
+    CPPUNIT_ASSERT(writer.get_written_frames() == 10);
+}
+
+void test_frame::test_packed_animation()
+{
+    animation anim;
+    for (int i = 0; i < 10; i++) {
+        frame* fr = new frame(*test_fr_);
+        figure* fig = fr->get_first_figure();
+        fig->get_node(2)->move(0, i);
+        anim.add_frame(fr);
+    }
+
+    packed_animation packed;
+    packed.pack(&anim);
+    CPPUNIT_ASSERT(packed.get_frame_count() == 10);
+    CPPUNIT_ASSERT(packed.get_topology_count() == 1);
+
+    // frames are rebuilt from the shared topology and their deltas
+    frame* fr = packed.unpack_frame(4);
+    figure* fig = fr->get_first_figure();
+    CPPUNIT_ASSERT(fig->get_nodes().size() == 4);
+    CPPUNIT_ASSERT(fig->get_edges().size() == 3);
+    CPPUNIT_ASSERT(fig->get_node(2)->get_y() == 29);
+    CPPUNIT_ASSERT(fig->get_node(3)->get_y() == 75);
+    CPPUNIT_ASSERT(fr->get_width() == 640);
+
+    // a structural edit gives only the edited figure a new topology
+    fig->create_line(fig->get_root(), 50, 100);
+    CPPUNIT_ASSERT(packed.set_frame(4, fr));
+    CPPUNIT_ASSERT(packed.get_topology_count() == 2);
+    CPPUNIT_ASSERT(packed.unpack_frame(4)->get_first_figure()->get_nodes().size() == 5);
+    CPPUNIT_ASSERT(packed.unpack_frame(5)->get_first_figure()->get_nodes().size() == 4);
+    CPPUNIT_ASSERT(!packed.set_frame(10, fr));
+
+    // a pose edit keeps sharing
+    frame* fr6 = packed.unpack_frame(6);
+    fr6->get_first_figure()->get_node(3)->move(1, 1);
+    CPPUNIT_ASSERT(packed.set_frame(6, fr6));
+    CPPUNIT_ASSERT(packed.get_topology_count() == 2);
+
+    // shared topologies are written once
+    std::string filename = "test_frame.pak";
+    {
+        std::ofstream ofs(filename.c_str(), std::ios::out | std::ios::binary);
+        boost::archive::binary_oarchive oa(ofs);
+        oa << boost::serialization::make_nvp("packed", packed);
+    }
+    packed_animation loaded;
+    {
+        std::ifstream ifs(filename.c_str(), std::ios::in | std::ios::binary);
+        boost::archive::binary_iarchive ia(ifs);
+        ia >> boost::serialization::make_nvp("packed", loaded);
+    }
+    CPPUNIT_ASSERT(loaded.get_topology_count() == 2);
+
+    animation* unpacked = loaded.unpack();
+    CPPUNIT_ASSERT(unpacked->get_frames().size() == 10);
+    int i = 0;
+    BOOST_FOREACH(frame* f, unpacked->get_frames()) {
+        figure* uf = f->get_first_figure();
+        CPPUNIT_ASSERT(uf->get_node(2)->get_y() == 25 + i);
+        CPPUNIT_ASSERT(uf->get_node(3)->get_y() == ((i == 6) ? 76 : 75));
+        i++;
+    }
+    delete unpacked;
+}
+
+void test_frame::test_packed_archive()
+{
+    animation anim;
+    for (int i = 0; i < 20; i++) {
+        frame* fr = new frame(*test_fr_);
+        fr->get_first_figure()->get_node(2)->move(0, i);
+        anim.add_frame(fr);
+    }
+
+    std::string packed_name = "test_frame.anp";
+    std::string binary_name = "test_frame_packed.anb";
+    CPPUNIT_ASSERT(save_animation(&anim, packed_name, ARCHIVE_PACKED));
+    CPPUNIT_ASSERT(save_animation(&anim, binary_name, ARCHIVE_BINARY));
+    CPPUNIT_ASSERT(detect_archive_format(packed_name) == ARCHIVE_PACKED);
+    CPPUNIT_ASSERT(!save_figure(test_fr_->get_first_figure(), packed_name, ARCHIVE_PACKED));
+
+    // duplicated frames only store the moved node
+    std::ifstream packed_file(packed_name.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    std::ifstream binary_file(binary_name.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    CPPUNIT_ASSERT(packed_file.tellg() < binary_file.tellg());
+
+    animation* loaded = load_animation(packed_name);
+    CPPUNIT_ASSERT(loaded != NULL);
+    CPPUNIT_ASSERT(loaded->get_frames().size() == 20);
+    int i = 0;
+    BOOST_FOREACH(frame* fr, loaded->get_frames()) {
+        figure* fig = fr->get_first_figure();
+        CPPUNIT_ASSERT(fig->get_nodes().size() == 4);
+        CPPUNIT_ASSERT(fig->get_node(2)->get_y() == 25 + i);
+        i++;
+    }
+    delete loaded;
+}
+
+void test_frame::test_delete_figures()
+{
+    frame source(0, 0, 640, 480);
+    for (int i = 0; i < 50; i++) {
+        source.add_figure(new figure(*test_fr_->get_first_figure()));
+    }
+
+    frame* fr = new frame(source);
+    CPPUNIT_ASSERT(fr->get_figures().size() == 50);
+    boost::weak_ptr<graph_arena> arena = fr->get_first_figure()->get_arena();
+    CPPUNIT_ASSERT(arena.lock()->get_node_count() == 200);
+
+    // a figure taken out of the frame keeps the arena and its nodes
+    figure* kept = fr->get_first_figure();
+    fr->remove_figure(kept);
+    fr->delete_figures();
+    CPPUNIT_ASSERT(fr->get_figures().empty());
+    CPPUNIT_ASSERT(!arena.expired());
+    CPPUNIT_ASSERT(kept->get_node(3)->get_y() == 75);
+
+    delete kept;
+    CPPUNIT_ASSERT(arena.expired());
+
+    source.delete_figures();
+    delete fr;
+}
@@ -5,6 +5,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "frame.h"
+#include "archive_io.h"
 
 using namespace stan;
 
@@ -15,6 +16,13 @@ class test_frame : public CppUnit::TestFixture
         CPPUNIT_TEST(test_copy);
         CPPUNIT_TEST(test_serialization);
         CPPUNIT_TEST(test_iterator);
+        CPPUNIT_TEST(test_figure_at_pos);
+        CPPUNIT_TEST(test_binary_animation);
+        CPPUNIT_TEST(test_indexed_animation);
+        CPPUNIT_TEST(test_incremental_save);
+        CPPUNIT_TEST(test_packed_animation);
+        CPPUNIT_TEST(test_packed_archive);
+        CPPUNIT_TEST(test_delete_figures);
         CPPUNIT_TEST_SUITE_END ();
 
     public:
@@ -37,6 +45,33 @@ class test_frame : public CppUnit::TestFixture
 
         void test_iterator();
 
+        /**
+         * Test that the grid based hit-test agrees with a scan of every
+         * figure, including after figures are moved, added, removed and
+         * deleted.
+         */
+        void test_figure_at_pos();
+
+        /**
+         * Test an animation survives a round trip through a binary archive.
+         */
+        void test_binary_animation();
+        void test_indexed_animation();
+        void test_incremental_save();
+        void test_packed_animation();
+
+        /**
+         * Test a packed archive is smaller than a binary one for duplicated
+         * frames and loads back the same poses.
+         */
+        void test_packed_archive();
+
+        /**
+         * Test deleting the figures of a duplicated frame releases its
+         * arena, except for figures taken out of the frame.
+         */
+        void test_delete_figures();
+
     private:
         frame* test_fr_;
 };
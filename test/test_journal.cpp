@@ -0,0 +1,287 @@
+#include <cmath>
+
+#include "test_journal.h"
+#include "archive_io.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_journal);
+
+void test_journal::setUp()
+{
+    fig_ = new figure(200, 140);
+    int torso = fig_->create_line(fig_->get_root(), 200, 100);
+    int shoulder = fig_->get_edge(torso)->get_n2();
+    fig_->create_circle(shoulder, 200, 70);    // head
+    arm_ = fig_->create_line(shoulder, 160, 120);
+    fig_->create_line(fig_->get_edge(arm_)->get_n2(), 140, 100);    // hand
+    fig_->create_line(fig_->get_root(), 180, 180);     // leg
+}
+
+void test_journal::tearDown()
+{
+    delete fig_;
+    fig_ = NULL;
+}
+
+void test_journal::test_positions()
+{
+    edit_journal journal;
+    CPPUNIT_ASSERT(!journal.can_undo());
+    CPPUNIT_ASSERT(!journal.undo());
+
+    fig_->move(10, 20);
+    journal.record(new move_command(fig_, 10, 20));
+    CPPUNIT_ASSERT(fig_->get_xpos() == 210);
+
+    // only the hand moves, the other nodes are not kept
+    int hand = fig_->get_edge(arm_ + 1)->get_n2();
+    std::list<int> nodes;
+    nodes.push_back(fig_->get_edge(arm_)->get_n2());
+    nodes.push_back(hand);
+    position_command* pos = new position_command(fig_, nodes);
+    fig_->get_node(hand)->move_to(0, 0);
+    CPPUNIT_ASSERT(pos->commit());
+    journal.record(pos);
+
+    int old_color = fig_->get_edge(arm_)->get_color();
+    journal.execute(new color_command(fig_, arm_, old_color, 0xff));
+    CPPUNIT_ASSERT(fig_->get_edge(arm_)->get_color() == 0xff);
+    CPPUNIT_ASSERT(journal.get_undo_count() == 3);
+
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fig_->get_edge(arm_)->get_color() == old_color);
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fig_->get_node(hand)->get_x() == 150);
+    CPPUNIT_ASSERT(fig_->get_node(hand)->get_y() == 120);
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fig_->get_xpos() == 200);
+    CPPUNIT_ASSERT(fig_->get_ypos() == 140);
+    CPPUNIT_ASSERT(!journal.can_undo());
+    CPPUNIT_ASSERT(journal.get_redo_count() == 3);
+
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(fig_->get_node(hand)->get_x() == 0);
+    CPPUNIT_ASSERT(fig_->get_ypos() == 160);
+
+    // a new edit makes the color change unreachable
+    fig_->move(1, 1);
+    journal.record(new move_command(fig_, 1, 1));
+    CPPUNIT_ASSERT(!journal.can_redo());
+    CPPUNIT_ASSERT(journal.get_undo_count() == 3);
+
+    // nothing moved, nothing to record
+    position_command still(fig_);
+    CPPUNIT_ASSERT(!still.commit());
+}
+
+void test_journal::test_transform()
+{
+    edit_journal journal;
+    int hand = fig_->get_edge(arm_ + 1)->get_n2();
+
+    journal.execute(new rotate_command(fig_, 0.5));
+    journal.execute(new scale_command(fig_, 1.2));
+    CPPUNIT_ASSERT(fabs(fig_->get_node(hand)->get_x() - 140) > 1);
+
+    // the commands keep no node positions, whatever the figure size
+    CPPUNIT_ASSERT(journal.get_size() == sizeof(rotate_command) + sizeof(scale_command));
+
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fabs(fig_->get_node(hand)->get_x() - 140) < 1e-9);
+    CPPUNIT_ASSERT(fabs(fig_->get_node(hand)->get_y() - 100) < 1e-9);
+    CPPUNIT_ASSERT(fig_->get_xpos() == 200);
+    CPPUNIT_ASSERT(fig_->get_ypos() == 140);
+
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fabs(fig_->get_node(hand)->get_x() - 140) < 1e-9);
+}
+
+void test_journal::test_create()
+{
+    edit_journal journal;
+    int nodes = static_cast<int>(fig_->get_nodes().size());
+    int edges = static_cast<int>(fig_->get_edges().size());
+
+    int eindex = fig_->create_line(fig_->get_root(), 220, 180);
+    fig_->get_edge(eindex)->set_color(0x00ff00);
+    int n = fig_->get_edge(eindex)->get_n2();
+    fig_->get_node(n)->move_to(230, 190);     // dragged into place
+    journal.record(new create_command(fig_, eindex));
+
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(static_cast<int>(fig_->get_nodes().size()) == nodes);
+    CPPUNIT_ASSERT(static_cast<int>(fig_->get_edges().size()) == edges);
+
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(static_cast<int>(fig_->get_edges().size()) == edges + 1);
+    edge* e = fig_->get_edge(eindex);
+    CPPUNIT_ASSERT(e->get_n1() == fig_->get_root());
+    CPPUNIT_ASSERT(e->get_n2() == n);
+    CPPUNIT_ASSERT(e->get_color() == 0x00ff00);
+    CPPUNIT_ASSERT(fig_->get_node(n)->get_x() == 230);
+    CPPUNIT_ASSERT(fig_->get_node(n)->get_y() == 190);
+}
+
+void test_journal::test_cut()
+{
+    edit_journal journal;
+    int elbow = fig_->get_edge(arm_)->get_n2();
+    int hand = fig_->get_edge(arm_ + 1)->get_n2();
+    int shoulder = fig_->get_edge(arm_)->get_n1();
+    std::list<int> before(fig_->get_node(shoulder)->get_children());
+    int edges = static_cast<int>(fig_->get_edges().size());
+    int last = fig_->get_edge(edges - 1)->get_n2();
+
+    journal.execute(new cut_command(fig_, elbow));
+    CPPUNIT_ASSERT(fig_->get_node(elbow) == NULL);
+    CPPUNIT_ASSERT(fig_->get_node(hand) == NULL);
+    CPPUNIT_ASSERT(static_cast<int>(fig_->get_edges().size()) == edges - 2);
+
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fig_->get_free_count() == 0);
+    CPPUNIT_ASSERT(static_cast<int>(fig_->get_edges().size()) == edges);
+    CPPUNIT_ASSERT(fig_->get_edge(arm_)->get_n1() == shoulder);
+    CPPUNIT_ASSERT(fig_->get_edge(arm_)->get_n2() == elbow);
+    CPPUNIT_ASSERT(fig_->get_edge(arm_ + 1)->get_n2() == hand);
+    CPPUNIT_ASSERT(fig_->get_edge(edges - 1)->get_n2() == last);
+    CPPUNIT_ASSERT(fig_->get_node(hand)->get_parent() == elbow);
+    CPPUNIT_ASSERT(fig_->get_node(hand)->get_x() == 140);
+    CPPUNIT_ASSERT(fig_->get_node(shoulder)->get_children() == before);
+    CPPUNIT_ASSERT(fig_->find_edge(elbow, hand) == fig_->get_edge(arm_ + 1));
+
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(fig_->get_node(elbow) == NULL);
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fig_->get_node(elbow)->get_children().size() == 1);
+}
+
+void test_journal::test_cut_save()
+{
+    animation anim;
+    frame* fr = new frame();
+    fr->add_figure(fig_);
+    anim.add_frame(fr);
+
+    edit_journal journal;
+    int elbow = fig_->get_edge(arm_)->get_n2();
+    int hand = fig_->get_edge(arm_ + 1)->get_n2();
+    int nodes = static_cast<int>(fig_->get_nodes().size());
+    journal.execute(new cut_command(fig_, elbow));
+
+    // the cut still refers to the empty slots, saving must keep them
+    std::string filename = "test_journal.ani";
+    CPPUNIT_ASSERT(save_animation(&anim, filename, ARCHIVE_XML, &journal));
+    CPPUNIT_ASSERT(static_cast<int>(fig_->get_nodes().size()) == nodes);
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fig_->get_node(hand)->get_parent() == elbow);
+    CPPUNIT_ASSERT(fig_->get_node(hand)->get_x() == 140);
+    CPPUNIT_ASSERT(fig_->find_edge(elbow, hand) == fig_->get_edge(arm_ + 1));
+
+    animation* loaded = load_animation(filename);
+    CPPUNIT_ASSERT(loaded != NULL);
+    figure* fig = loaded->get_first_frame()->get_first_figure();
+    CPPUNIT_ASSERT(static_cast<int>(fig->get_nodes().size()) == nodes);
+    CPPUNIT_ASSERT(fig->get_node(elbow) == NULL);
+    delete loaded;
+
+    // without history the figure is compacted
+    CPPUNIT_ASSERT(journal.redo());
+    journal.clear();
+    CPPUNIT_ASSERT(save_animation(&anim, filename, ARCHIVE_XML, &journal));
+    CPPUNIT_ASSERT(static_cast<int>(fig_->get_nodes().size()) == nodes - 2);
+
+    fr->remove_figure(fig_);
+    delete fr;
+}
+
+void test_journal::test_add_figure()
+{
+    frame fr;
+    edit_journal journal;
+    journal.execute(new add_figure_command(&fr, fig_));
+    figure* own = fig_;
+    fig_ = NULL;     // owned by the frame now
+    CPPUNIT_ASSERT(fr.get_figures().size() == 1);
+
+    figure* other = new figure(10, 10);
+    other->create_line(other->get_root(), 10, 20);
+    fr.add_figure(other);
+    journal.record(new add_figure_command(&fr, other));
+
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fr.get_figures().size() == 1);
+    CPPUNIT_ASSERT(fr.get_first_figure() == own);
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(fr.get_figures().size() == 2);
+
+    // dropping the undone command deletes the figure it owns
+    CPPUNIT_ASSERT(journal.undo());
+    journal.clear();
+    CPPUNIT_ASSERT(fr.get_figures().size() == 1);
+
+    fr.remove_figure(own);
+    delete own;
+}
+
+void test_journal::test_remove_figure()
+{
+    frame fr;
+    figure* other = new figure(10, 10);
+    other->create_line(other->get_root(), 10, 20);
+    fr.add_figure(fig_);
+    fr.add_figure(other);
+
+    edit_journal journal;
+    position_command* pos = new position_command(fig_);
+    fig_->move(5, 5);
+    CPPUNIT_ASSERT(pos->commit());
+    journal.record(pos);
+    journal.execute(new remove_figure_command(&fr, fig_));
+    CPPUNIT_ASSERT(fr.get_figures().size() == 1);
+
+    // the figure comes back first in the list and earlier commands apply
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fr.get_first_figure() == fig_);
+    CPPUNIT_ASSERT(fr.get_figures().size() == 2);
+    CPPUNIT_ASSERT(journal.undo());
+    CPPUNIT_ASSERT(fig_->get_node(fig_->get_root())->get_x() == 200);
+
+    // dropping the done command deletes the figure it owns
+    CPPUNIT_ASSERT(journal.redo());
+    CPPUNIT_ASSERT(journal.redo());
+    journal.clear();
+    fig_ = NULL;
+    CPPUNIT_ASSERT(fr.get_figures().size() == 1);
+
+    fr.remove_figure(other);
+    delete other;
+}
+
+void test_journal::test_budget()
+{
+    edit_journal journal;
+    std::size_t one = move_command(fig_, 1, 1).get_size();
+    journal.set_budget(3 * one);
+
+    for (int i = 0; i < 5; i++) {
+        fig_->move(1, 0);
+        journal.record(new move_command(fig_, 1, 0));
+    }
+    CPPUNIT_ASSERT(journal.get_undo_count() == 3);
+    CPPUNIT_ASSERT(journal.get_size() == 3 * one);
+
+    while (journal.undo()) {
+    }
+    CPPUNIT_ASSERT(fig_->get_xpos() == 202);
+
+    // the latest command is kept whatever its size
+    journal.set_budget(1);
+    CPPUNIT_ASSERT(journal.get_undo_count() == 0);
+    CPPUNIT_ASSERT(journal.redo());
+    journal.set_budget(1);
+    CPPUNIT_ASSERT(journal.get_undo_count() == 1);
+}
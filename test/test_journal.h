@@ -0,0 +1,86 @@
+#ifndef _TEST_JOURNAL_H
+#define _TEST_JOURNAL_H      1
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "edit_journal.h"
+
+using namespace stan;
+
+class test_journal : public CppUnit::TestFixture
+{
+    private:
+        CPPUNIT_TEST_SUITE(test_journal);
+        CPPUNIT_TEST(test_positions);
+        CPPUNIT_TEST(test_transform);
+        CPPUNIT_TEST(test_create);
+        CPPUNIT_TEST(test_cut);
+        CPPUNIT_TEST(test_cut_save);
+        CPPUNIT_TEST(test_add_figure);
+        CPPUNIT_TEST(test_remove_figure);
+        CPPUNIT_TEST(test_budget);
+        CPPUNIT_TEST_SUITE_END ();
+
+    public:
+        test_journal() :
+            fig_(NULL),
+            arm_(-1)
+        {}
+
+        void setUp();
+        void tearDown();
+
+    protected:
+        /**
+         * Test undo / redo of moves, node position changes and colors, and
+         * that a new command drops the undone ones.
+         */
+        void test_positions();
+
+        /**
+         * Test undo / redo of whole figure rotations and scaling, which
+         * only keep the angle or factor.
+         */
+        void test_transform();
+
+        /**
+         * Test that an undone line comes back with the same node and edge.
+         */
+        void test_create();
+
+        /**
+         * Test that undoing a cut puts the subtree back into the same node
+         * and edge slots.
+         */
+        void test_cut();
+
+        /**
+         * Test that saving does not compact a figure the history refers
+         * to, so a cut can still be undone after a save.
+         */
+        void test_cut_save();
+
+        /**
+         * Test that an undone figure is taken out of the frame and owned by
+         * the journal.
+         */
+        void test_add_figure();
+
+        /**
+         * Test that a cut figure is owned by the journal while done and
+         * goes back to its place in the frame on undo.
+         */
+        void test_remove_figure();
+
+        /**
+         * Test that the oldest commands are dropped to stay within budget.
+         */
+        void test_budget();
+
+    private:
+        figure* fig_;
+        int arm_;       // upper arm edge, the hand hangs below it
+};
+
+#endif  // _TEST_JOURNAL_H
@@ -0,0 +1,124 @@
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "test_load_queue.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_load_queue);
+
+namespace {
+
+/**
+ * Holds the loading thread until opened, so the following loads queue up.
+ */
+class gate
+{
+public:
+    gate() :
+        open_(false)
+    {
+    }
+
+    void pass()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        while (!open_) {
+            cond_.wait(lock);
+        }
+    }
+
+    void open()
+    {
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            open_ = true;
+        }
+        cond_.notify_all();
+    }
+
+private:
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+    bool open_;
+};
+
+boost::mutex order_mutex;
+
+void load(std::vector<int>* order, int n)
+{
+    boost::mutex::scoped_lock lock(order_mutex);
+    order->push_back(n);
+}
+
+void done(std::vector<int>* order, int n)
+{
+    order->push_back(n);
+}
+
+};  // anonymous namespace
+
+void test_load_queue::setUp()
+{
+}
+
+void test_load_queue::tearDown()
+{
+}
+
+void test_load_queue::test_priority()
+{
+    load_queue queue(1);
+    gate g;
+    std::vector<int> loaded;
+    std::vector<int> completed;
+
+    queue.submit(boost::bind(&gate::pass, &g), load_queue::job(), 0);
+    queue.submit(boost::bind(load, &loaded, 1), boost::bind(done, &completed, 1), 0);
+    queue.submit(boost::bind(load, &loaded, 2), boost::bind(done, &completed, 2), 5);
+    queue.submit(boost::bind(load, &loaded, 3), boost::bind(done, &completed, 3), 5);
+    queue.submit(boost::bind(load, &loaded, 4), boost::bind(done, &completed, 4), -1);
+    CPPUNIT_ASSERT(queue.get_pending() == 5);
+
+    g.open();
+    queue.wait();
+    CPPUNIT_ASSERT(completed.empty());
+
+    CPPUNIT_ASSERT(loaded.size() == 4);
+    CPPUNIT_ASSERT(loaded[0] == 2);
+    CPPUNIT_ASSERT(loaded[1] == 3);
+    CPPUNIT_ASSERT(loaded[2] == 1);
+    CPPUNIT_ASSERT(loaded[3] == 4);
+
+    CPPUNIT_ASSERT(queue.poll() == 5);
+    CPPUNIT_ASSERT(completed == loaded);
+    CPPUNIT_ASSERT(queue.get_pending() == 0);
+    CPPUNIT_ASSERT(queue.poll() == 0);
+}
+
+void test_load_queue::test_cancel()
+{
+    load_queue queue(1);
+    gate g;
+    std::vector<int> loaded;
+    std::vector<int> completed;
+
+    queue.submit(boost::bind(&gate::pass, &g), boost::bind(done, &completed, 0), 0);
+    queue.submit(boost::bind(load, &loaded, 1), boost::bind(done, &completed, 1), 0);
+
+    // the gate is running (or about to), the second load is still queued
+    queue.cancel();
+    CPPUNIT_ASSERT(queue.get_pending() == 0);
+    queue.submit(boost::bind(load, &loaded, 2), boost::bind(done, &completed, 2), 0);
+
+    g.open();
+    queue.wait();
+    CPPUNIT_ASSERT(loaded.size() == 1);
+    CPPUNIT_ASSERT(loaded[0] == 2);
+
+    CPPUNIT_ASSERT(queue.poll() == 1);
+    CPPUNIT_ASSERT(completed.size() == 1);
+    CPPUNIT_ASSERT(completed[0] == 2);
+}
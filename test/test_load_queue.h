@@ -0,0 +1,40 @@
+#ifndef _TEST_LOAD_QUEUE_H
+#define _TEST_LOAD_QUEUE_H      1
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "load_queue.h"
+
+using namespace stan;
+
+class test_load_queue : public CppUnit::TestFixture
+{
+    private:
+        CPPUNIT_TEST_SUITE(test_load_queue);
+        CPPUNIT_TEST(test_priority);
+        CPPUNIT_TEST(test_cancel);
+        CPPUNIT_TEST_SUITE_END ();
+
+    public:
+        test_load_queue()
+        {}
+
+        void setUp();
+        void tearDown();
+
+    protected:
+        /**
+         * Test that queued loads run highest priority first and that the
+         * completions only run when polled.
+         */
+        void test_priority();
+
+        /**
+         * Test that cancelling drops queued loads and the completions of
+         * running ones.
+         */
+        void test_cancel();
+};
+
+#endif  // _TEST_LOAD_QUEUE_H
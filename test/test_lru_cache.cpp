@@ -0,0 +1,65 @@
+#include <string>
+#include "test_lru_cache.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_lru_cache);
+
+void test_lru_cache::setUp()
+{
+}
+
+void test_lru_cache::tearDown()
+{
+}
+
+void test_lru_cache::test_eviction()
+{
+    lru_cache<int, std::string> cache(30);
+    cache.put(1, "one", 10);
+    cache.put(2, "two", 10);
+    cache.put(3, "three", 10);
+    CPPUNIT_ASSERT(cache.size() == 3);
+    CPPUNIT_ASSERT(cache.get_cost() == 30);
+
+    // touching 1 makes 2 the oldest entry
+    CPPUNIT_ASSERT(*cache.get(1) == "one");
+    cache.put(4, "four", 10);
+    CPPUNIT_ASSERT(cache.get(2) == NULL);
+    CPPUNIT_ASSERT(cache.get(1) != NULL);
+    CPPUNIT_ASSERT(cache.get(3) != NULL);
+    CPPUNIT_ASSERT(cache.get(4) != NULL);
+    CPPUNIT_ASSERT(cache.get_cost() == 30);
+
+    // an entry larger than the budget replaces everything but is kept
+    cache.put(5, "five", 50);
+    CPPUNIT_ASSERT(cache.size() == 1);
+    CPPUNIT_ASSERT(*cache.get(5) == "five");
+
+    // lowering the budget evicts (but keeps the newest)
+    cache.set_budget(0);
+    CPPUNIT_ASSERT(cache.size() == 1);
+    cache.put(6, "six", 1);
+    CPPUNIT_ASSERT(cache.size() == 1);
+    CPPUNIT_ASSERT(cache.get(5) == NULL);
+
+    CPPUNIT_ASSERT(cache.get_hits() == 5);
+    CPPUNIT_ASSERT(cache.get_misses() == 2);
+}
+
+void test_lru_cache::test_replace()
+{
+    lru_cache<int, std::string> cache(100);
+    cache.put(1, "one", 10);
+    cache.put(1, "uno", 20);
+    CPPUNIT_ASSERT(cache.size() == 1);
+    CPPUNIT_ASSERT(cache.get_cost() == 20);
+    CPPUNIT_ASSERT(*cache.get(1) == "uno");
+
+    CPPUNIT_ASSERT(cache.erase(1));
+    CPPUNIT_ASSERT(!cache.erase(1));
+    CPPUNIT_ASSERT(cache.get_cost() == 0);
+
+    cache.put(2, "two", 10);
+    cache.clear();
+    CPPUNIT_ASSERT(cache.size() == 0);
+    CPPUNIT_ASSERT(cache.get(2) == NULL);
+}
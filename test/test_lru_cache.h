@@ -0,0 +1,39 @@
+#ifndef _TEST_LRU_CACHE_H
+#define _TEST_LRU_CACHE_H      1
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "lru_cache.h"
+
+using namespace stan;
+
+class test_lru_cache : public CppUnit::TestFixture
+{
+    private:
+        CPPUNIT_TEST_SUITE(test_lru_cache);
+        CPPUNIT_TEST(test_eviction);
+        CPPUNIT_TEST(test_replace);
+        CPPUNIT_TEST_SUITE_END ();
+
+    public:
+        test_lru_cache()
+        {}
+
+        void setUp();
+        void tearDown();
+
+    protected:
+        /**
+         * Test that the least recently used entries are dropped when the
+         * budget is exceeded.
+         */
+        void test_eviction();
+
+        /**
+         * Test replacing and erasing entries keeps the cost in step.
+         */
+        void test_replace();
+};
+
+#endif  // _TEST_LRU_CACHE_H
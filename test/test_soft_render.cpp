@@ -0,0 +1,118 @@
+#include "test_soft_render.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_soft_render);
+
+namespace {
+
+const int BLACK = 0;
+
+int rgb(unsigned char r, unsigned char g, unsigned char b)
+{
+    int color = 0;
+    unsigned char* p_color_bytes = reinterpret_cast<unsigned char*>(&color);
+    p_color_bytes[0] = r;
+    p_color_bytes[1] = g;
+    p_color_bytes[2] = b;
+    return color;
+}
+
+};
+
+void test_soft_render::setUp()
+{
+}
+
+void test_soft_render::tearDown()
+{
+}
+
+void test_soft_render::test_primitives()
+{
+    const int white = rgb(255, 255, 255);
+    const int red = rgb(255, 0, 0);
+
+    SoftRender sr(40, 40);
+    sr.clear(white);
+    CPPUNIT_ASSERT(sr.get_color(0, 0) == white);
+    CPPUNIT_ASSERT(sr.get_target().get_pixel(0, 0)[3] == 255);
+
+    // thin line is one pixel wide
+    sr.draw_line(5, 10, 30, 10, 1, red);
+    CPPUNIT_ASSERT(sr.get_color(5, 10) == red);
+    CPPUNIT_ASSERT(sr.get_color(30, 10) == red);
+    CPPUNIT_ASSERT(sr.get_color(17, 9) == white);
+    CPPUNIT_ASSERT(sr.get_color(31, 10) == white);
+
+    // weight 5 covers two pixels either side
+    sr.draw_line(5, 20, 30, 20, 5, red);
+    CPPUNIT_ASSERT(sr.get_color(17, 18) == red);
+    CPPUNIT_ASSERT(sr.get_color(17, 22) == red);
+    CPPUNIT_ASSERT(sr.get_color(17, 23) == white);
+
+    // circle outline, but not its inside
+    sr.clear(white);
+    sr.draw_circle(20, 20, 10, 1, red);
+    CPPUNIT_ASSERT(sr.get_color(30, 20) == red);
+    CPPUNIT_ASSERT(sr.get_color(20, 10) == red);
+    CPPUNIT_ASSERT(sr.get_color(20, 20) == white);
+    CPPUNIT_ASSERT(sr.get_color(33, 20) == white);
+
+    // drawing off the target is clipped
+    sr.draw_line(-10, -10, 100, 100, 3, BLACK);
+    CPPUNIT_ASSERT(sr.get_color(39, 39) == BLACK);
+}
+
+void test_soft_render::test_image()
+{
+    // top half blue, bottom half black (transparent)
+    soft_image img(4, 4);
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 4; x++) {
+            unsigned char* p = img.get_pixel(x, y);
+            p[2] = 255;
+            p[3] = 255;
+        }
+    }
+    for (int y = 2; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            img.get_pixel(x, y)[3] = 255;
+        }
+    }
+
+    const int white = rgb(255, 255, 255);
+    SoftRender sr(40, 40);
+    sr.clear(white);
+
+    // upright image, bottom center at (20, 30), top center at (20, 10)
+    Point p0(20, 30);
+    Point p1(20, 10);
+    sr.draw_image(img, p0, p1);
+    CPPUNIT_ASSERT(sr.get_color(20, 12) == rgb(0, 0, 255));
+    CPPUNIT_ASSERT(sr.get_color(12, 12) == rgb(0, 0, 255));
+    CPPUNIT_ASSERT(sr.get_color(20, 28) == white);
+    CPPUNIT_ASSERT(sr.get_color(5, 12) == white);
+}
+
+void test_soft_render::test_frame()
+{
+    figure* fig(new figure(10, 10));
+    int l1 = fig->create_line(fig->get_root(), 90, 10);
+    fig->get_edge(l1)->set_color(rgb(255, 0, 0));
+
+    frame fr(0, 0, 100, 50);
+    fr.add_figure(fig);
+
+    // render at twice the frame size
+    SoftRender sr(200, 100);
+    sr.render_frame(&fr, NULL);
+    CPPUNIT_ASSERT(sr.get_color(20, 20) == rgb(255, 0, 0));
+    CPPUNIT_ASSERT(sr.get_color(180, 20) == rgb(255, 0, 0));
+    CPPUNIT_ASSERT(sr.get_color(100, 60) == rgb(255, 255, 255));
+
+    // disabled figures are drawn grey
+    fig->set_enabled(false);
+    sr.render_frame(&fr, NULL);
+    CPPUNIT_ASSERT(sr.get_color(100, 20) == rgb(136, 136, 136));
+
+    delete fig;
+}
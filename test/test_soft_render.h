@@ -0,0 +1,44 @@
+#ifndef _TEST_SOFT_RENDER_H
+#define _TEST_SOFT_RENDER_H      1
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "soft_render.h"
+
+using namespace stan;
+
+class test_soft_render : public CppUnit::TestFixture
+{
+    private:
+        CPPUNIT_TEST_SUITE(test_soft_render);
+        CPPUNIT_TEST(test_primitives);
+        CPPUNIT_TEST(test_image);
+        CPPUNIT_TEST(test_frame);
+        CPPUNIT_TEST_SUITE_END ();
+
+    public:
+        test_soft_render()
+        {}
+
+        void setUp();
+        void tearDown();
+
+    protected:
+        /**
+         * Test lines (with weight) and circles land on the expected pixels.
+         */
+        void test_primitives();
+
+        /**
+         * Test image edges are drawn with black as transparent.
+         */
+        void test_image();
+
+        /**
+         * Test a frame is scaled to the size of the target.
+         */
+        void test_frame();
+};
+
+#endif  // _TEST_SOFT_RENDER_H
@@ -0,0 +1,138 @@
+#include <cmath>
+
+#include "test_tween.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_tween);
+
+namespace {
+
+/**
+ * An arm: shoulder at (100,100), elbow 50 to the right, hand 30 further.
+ */
+figure* create_arm()
+{
+    figure* fig = new figure(100, 100);
+    int upper = fig->create_line(fig->get_root(), 150, 100);
+    fig->create_line(fig->get_edge(upper)->get_n2(), 180, 100);
+    return fig;
+}
+
+bool is_near(double a, double b)
+{
+    return fabs(a - b) < 1e-6;
+}
+
+};  // anonymous namespace
+
+void test_tween::setUp()
+{
+    key1_ = new frame(0, 0, 640, 480);
+    key1_->add_figure(create_arm());
+
+    // second key: whole arm turned a quarter around the shoulder, moved by 20
+    figure* fig = create_arm();
+    fig->get_node(0)->move_to(120, 100);
+    fig->get_node(1)->move_to(120, 150);
+    fig->get_node(2)->move_to(120, 180);
+    key2_ = new frame(0, 0, 640, 480);
+    key2_->add_figure(fig);
+}
+
+void test_tween::tearDown()
+{
+    delete key1_->get_first_figure();
+    delete key1_;
+    delete key2_->get_first_figure();
+    delete key2_;
+}
+
+void test_tween::test_linear()
+{
+    tween tw(key1_, key2_, TWEEN_LINEAR);
+    CPPUNIT_ASSERT(tw.is_compatible());
+
+    frame* out = tw.create_frame();
+    CPPUNIT_ASSERT(tw.interpolate(0.5, out));
+    figure* fig = out->get_first_figure();
+    CPPUNIT_ASSERT(is_near(fig->get_node(1)->get_x(), 135));
+    CPPUNIT_ASSERT(is_near(fig->get_node(1)->get_y(), 125));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_x(), 150));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_y(), 140));
+
+    CPPUNIT_ASSERT(tw.interpolate(1, out));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_x(), 120));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_y(), 180));
+
+    delete fig;
+    delete out;
+}
+
+void test_tween::test_angular()
+{
+    tween tw(key1_, key2_, TWEEN_ANGULAR);
+    frame* out = tw.create_frame();
+    figure* fig = out->get_first_figure();
+
+    unsigned long revision = fig->get_revision();
+    CPPUNIT_ASSERT(tw.interpolate(0.5, out));
+    CPPUNIT_ASSERT(fig->get_revision() != revision);
+
+    // the shoulder moves linearly, the limbs turn 45 degrees
+    double d = sqrt(0.5);
+    CPPUNIT_ASSERT(is_near(fig->get_node(0)->get_x(), 110));
+    CPPUNIT_ASSERT(is_near(fig->get_node(0)->get_y(), 100));
+    CPPUNIT_ASSERT(is_near(fig->get_node(1)->get_x(), 110 + 50 * d));
+    CPPUNIT_ASSERT(is_near(fig->get_node(1)->get_y(), 100 + 50 * d));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_x(), 110 + 80 * d));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_y(), 100 + 80 * d));
+
+    // the keyframes themselves are reproduced
+    CPPUNIT_ASSERT(tw.interpolate(0, out));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_x(), 180));
+    CPPUNIT_ASSERT(is_near(fig->get_node(2)->get_y(), 100));
+
+    delete fig;
+    delete out;
+}
+
+void test_tween::test_sequence()
+{
+    tween_sequence seq(TWEEN_LINEAR);
+    seq.add_key(key1_, 3);
+    seq.add_key(key2_, 3);
+    CPPUNIT_ASSERT(seq.get_key_count() == 2);
+    CPPUNIT_ASSERT(seq.get_length() == 5);
+
+    frame* out = seq.create_frame();
+    figure* fig = out->get_first_figure();
+    double expected[] = { 100, 105, 110, 115, 120 };
+    for (int n = 0; n < seq.get_length(); n++) {
+        CPPUNIT_ASSERT(seq.get_frame(n, out));
+        CPPUNIT_ASSERT(is_near(fig->get_node(0)->get_x(), expected[n]));
+    }
+    CPPUNIT_ASSERT(!seq.get_frame(5, out));
+    CPPUNIT_ASSERT(!seq.get_frame(-1, out));
+
+    delete fig;
+    delete out;
+}
+
+void test_tween::test_incompatible()
+{
+    frame other(0, 0, 640, 480);
+    figure* fig = create_arm();
+    fig->create_line(fig->get_root(), 100, 150);
+    other.add_figure(fig);
+
+    tween tw(key1_, &other);
+    CPPUNIT_ASSERT(!tw.is_compatible());
+
+    frame* out = tw.create_frame();
+    CPPUNIT_ASSERT(!tw.interpolate(0.5, out));
+
+    delete out->get_first_figure();
+    delete out;
+    delete fig;
+}
+
+// END of this file -----------------------------------------------------------
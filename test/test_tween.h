@@ -0,0 +1,55 @@
+#ifndef _TEST_TWEEN_H
+#define _TEST_TWEEN_H      1
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "tween.h"
+
+using namespace stan;
+
+class test_tween : public CppUnit::TestFixture
+{
+    private:
+        CPPUNIT_TEST_SUITE(test_tween);
+        CPPUNIT_TEST(test_linear);
+        CPPUNIT_TEST(test_angular);
+        CPPUNIT_TEST(test_sequence);
+        CPPUNIT_TEST(test_incompatible);
+        CPPUNIT_TEST_SUITE_END ();
+
+        frame* key1_;
+        frame* key2_;
+
+    public:
+        test_tween() :
+            key1_(NULL),
+            key2_(NULL)
+        {}
+
+        void setUp();
+        void tearDown();
+
+    protected:
+        /**
+         * Test nodes move in a straight line between the keyframes.
+         */
+        void test_linear();
+
+        /**
+         * Test limbs rotate about their parent and keep their length.
+         */
+        void test_angular();
+
+        /**
+         * Test playback frames of a keyframe sequence.
+         */
+        void test_sequence();
+
+        /**
+         * Test keyframes with different topologies are rejected.
+         */
+        void test_incompatible();
+};
+
+#endif  // _TEST_TWEEN_H
@@ -0,0 +1,92 @@
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "test_work_pool.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_work_pool);
+
+namespace {
+
+boost::mutex result_mutex;
+
+void mark(std::vector<int>* runs, int n, int threads, int worker)
+{
+    // uneven task sizes so the idle workers have to steal
+    if (n % threads == 0) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(2));
+    }
+
+    boost::mutex::scoped_lock lock(result_mutex);
+    CPPUNIT_ASSERT(worker >= 0 && worker < threads);
+    (*runs)[n]++;
+}
+
+void produce(ordered_writer<int>* writer, int n, int worker)
+{
+    // later items finish first
+    if (n % 3 == 0) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    writer->put(n, n * 10);
+}
+
+void consume(std::vector<int>* written, int index, int& item)
+{
+    CPPUNIT_ASSERT(item == index * 10);
+    written->push_back(index);
+}
+
+};
+
+void test_work_pool::setUp()
+{
+}
+
+void test_work_pool::tearDown()
+{
+}
+
+void test_work_pool::test_run_all()
+{
+    const int count = 200;
+    std::vector<int> runs(count, 0);
+
+    work_pool pool(4);
+    CPPUNIT_ASSERT(pool.get_thread_count() == 4);
+    for (int n = 0; n < count; n++) {
+        pool.submit(boost::bind(&mark, &runs, n, 4, _1));
+    }
+    pool.wait();
+
+    for (int n = 0; n < count; n++) {
+        CPPUNIT_ASSERT_EQUAL(1, runs[n]);
+    }
+
+    // pool can be reused after wait()
+    pool.submit(boost::bind(&mark, &runs, 0, 4, _1));
+    pool.wait();
+    CPPUNIT_ASSERT_EQUAL(2, runs[0]);
+}
+
+void test_work_pool::test_ordered_writer()
+{
+    const int count = 100;
+    std::vector<int> written;
+    ordered_writer<int> writer(boost::bind(&consume, &written, _1, _2));
+
+    work_pool pool(4);
+    for (int n = 0; n < count; n++) {
+        // never more than 8 items held or in flight
+        writer.wait_for_slot(n, 8);
+        pool.submit(boost::bind(&produce, &writer, n, _1));
+    }
+    pool.wait();
+
+    CPPUNIT_ASSERT(writer.get_next() == count);
+    CPPUNIT_ASSERT(static_cast<int>(written.size()) == count);
+    for (int n = 0; n < count; n++) {
+        CPPUNIT_ASSERT_EQUAL(n, written[n]);
+    }
+}
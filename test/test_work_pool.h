@@ -0,0 +1,39 @@
+#ifndef _TEST_WORK_POOL_H
+#define _TEST_WORK_POOL_H      1
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "work_pool.h"
+#include "ordered_writer.h"
+
+using namespace stan;
+
+class test_work_pool : public CppUnit::TestFixture
+{
+    private:
+        CPPUNIT_TEST_SUITE(test_work_pool);
+        CPPUNIT_TEST(test_run_all);
+        CPPUNIT_TEST(test_ordered_writer);
+        CPPUNIT_TEST_SUITE_END ();
+
+    public:
+        test_work_pool()
+        {}
+
+        void setUp();
+        void tearDown();
+
+    protected:
+        /**
+         * Test every task runs exactly once, on a valid worker.
+         */
+        void test_run_all();
+
+        /**
+         * Test results finished out of order by a pool are written in order.
+         */
+        void test_ordered_writer();
+};
+
+#endif  // _TEST_WORK_POOL_H
@@ -0,0 +1,242 @@
+#ifndef _ASSET_CACHE_H
+#define _ASSET_CACHE_H       1
+
+/**
+ * @file asset_cache.h
+ * @brief Shared cache of decoded assets (images, sounds) keyed by content.
+ * @date 10-18-26
+ */
+
+#include <string>
+#include <cstddef>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "lru_cache.h"
+
+namespace stan {
+
+/**
+ * Decodes every distinct asset once and hands out shared handles to it.
+ * The key identifies the content (e.g. canonical path plus modification
+ * time), so the same file used by any number of figures is decoded once
+ * and an edited file is decoded again.
+ *
+ * Recently used assets are kept resident within a byte budget even when
+ * nobody holds a handle. Evicted assets stay alive as long as a handle
+ * exists and are still found by get(), so eviction never causes a second
+ * copy of an asset in use. All methods are thread safe; loading happens
+ * outside the lock so several assets can be decoded in parallel.
+ */
+template <class Asset>
+class asset_cache
+{
+public:
+    typedef boost::shared_ptr<Asset> handle;
+
+    /**
+     * Decode the asset at a path.
+     * @param path The path to load
+     * @param bytes Return the memory used by the asset
+     * @return The new asset or NULL on failure
+     */
+    typedef boost::function<Asset* (const std::string& path, std::size_t& bytes)> loader;
+
+    /**
+     * Destroy an asset once the last handle is gone. The default deletes
+     * it; a releaser can also drop objects derived from the asset.
+     */
+    typedef boost::function<void (Asset* asset)> releaser;
+
+    asset_cache(loader load, std::size_t budget, releaser release = releaser()) :
+        load_(load),
+        release_(release),
+        resident_(budget),
+        live_(),
+        loads_(0),
+        failures_(0),
+        mutex_()
+    {
+    }
+
+    virtual ~asset_cache() {}
+
+    /**
+     * Get the asset for a key, decoding it from the path if it is not
+     * already loaded.
+     * @return The handle, empty if the asset could not be loaded
+     */
+    handle get(const std::string& key, const std::string& path)
+    {
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            handle found = find(key);
+            if (found) {
+                return found;
+            }
+        }
+
+        std::size_t bytes = 0;
+        Asset* asset = load_(path, bytes);
+
+        boost::mutex::scoped_lock lock(mutex_);
+        loads_++;
+        if (asset == NULL) {
+            failures_++;
+            return handle();
+        }
+
+        // another thread may have loaded the same asset meanwhile
+        handle found = find(key);
+        if (found) {
+            if (release_) {
+                release_(asset);
+            }
+            else {
+                delete asset;
+            }
+            return found;
+        }
+
+        handle loaded = release_ ? handle(asset, release_) : handle(asset);
+        live_[key] = live_entry(loaded, bytes);
+        resident_.put(key, loaded, bytes);
+        return loaded;
+    }
+
+    /**
+     * Bytes of the assets kept resident by the cache itself.
+     */
+    std::size_t get_resident_bytes()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        return resident_.get_cost();
+    }
+
+    /**
+     * Bytes of all assets still alive, resident or held through handles.
+     */
+    std::size_t get_live_bytes()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        prune();
+
+        std::size_t bytes = 0;
+        typename live_map::iterator iter;
+        for (iter = live_.begin(); iter != live_.end(); iter++) {
+            bytes += iter->second.bytes_;
+        }
+        return bytes;
+    }
+
+    /**
+     * Number of distinct assets alive.
+     */
+    std::size_t get_live_count()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        prune();
+        return live_.size();
+    }
+
+    /**
+     * Number of decodes attempted / failed.
+     */
+    unsigned long get_loads() { boost::mutex::scoped_lock lock(mutex_); return loads_; }
+    unsigned long get_failures() { boost::mutex::scoped_lock lock(mutex_); return failures_; }
+
+    void set_budget(std::size_t budget)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        resident_.set_budget(budget);
+    }
+
+    /**
+     * Drop the resident assets. Handles stay valid.
+     */
+    void clear()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        resident_.clear();
+        prune();
+    }
+
+private:
+    class live_entry
+    {
+    public:
+        live_entry() :
+            asset_(),
+            bytes_(0)
+        {
+        }
+
+        live_entry(handle asset, std::size_t bytes) :
+            asset_(asset),
+            bytes_(bytes)
+        {
+        }
+
+        boost::weak_ptr<Asset> asset_;
+        std::size_t bytes_;
+    };
+
+    typedef boost::unordered_map<std::string, live_entry> live_map;
+
+    /**
+     * Look up a live asset, making it resident again. Caller holds the lock.
+     */
+    handle find(const std::string& key)
+    {
+        handle* resident = resident_.get(key);
+        if (resident != NULL) {
+            return *resident;
+        }
+
+        typename live_map::iterator iter = live_.find(key);
+        if (iter == live_.end()) {
+            return handle();
+        }
+
+        handle alive = iter->second.asset_.lock();
+        if (alive) {
+            resident_.put(key, alive, iter->second.bytes_);
+        }
+        else {
+            live_.erase(iter);
+        }
+        return alive;
+    }
+
+    /**
+     * Forget assets which are no longer referenced. Caller holds the lock.
+     */
+    void prune()
+    {
+        typename live_map::iterator iter = live_.begin();
+        while (iter != live_.end()) {
+            if (iter->second.asset_.expired()) {
+                iter = live_.erase(iter);
+            }
+            else {
+                iter++;
+            }
+        }
+    }
+
+    loader load_;
+    releaser release_;
+    lru_cache<std::string, handle> resident_;
+    live_map live_;
+    unsigned long loads_;
+    unsigned long failures_;
+    boost::mutex mutex_;
+};
+
+};  // namespace stan
+
+#endif  // _ASSET_CACHE_H
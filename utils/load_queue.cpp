@@ -0,0 +1,127 @@
+/**
+ * @file load_queue.cpp
+ * @brief Implementation of the prioritized background loader.
+ * @date 10-18-26
+ */
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "load_queue.h"
+
+namespace stan {
+
+load_queue::load_queue(int threads) :
+    threads_(threads),
+    mutex_(),
+    queued_(),
+    finished_(),
+    generation_(0),
+    pending_(0),
+    pool_()
+{
+}
+
+load_queue::~load_queue()
+{
+    cancel();
+
+    // the pool runs tasks referring to this queue, stop it while the
+    // members are still alive
+    pool_.reset();
+}
+
+void load_queue::submit(const job& load, const job& done, int priority)
+{
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        queued_.insert(entry_map::value_type(priority, entry(load, done, generation_)));
+        pending_++;
+
+        if (!pool_) {
+            pool_.reset(new work_pool(threads_));
+        }
+    }
+
+    // every pool task takes whatever entry has the highest priority by the
+    // time it runs, not necessarily the one submitted here
+    pool_->submit(boost::bind(&load_queue::run_next, this, _1));
+}
+
+void load_queue::run_next(int)
+{
+    entry_map::iterator iter;
+    job load;
+    job done;
+    unsigned long generation;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (queued_.empty()) {
+            // cancelled
+            return;
+        }
+        iter = queued_.begin();
+        load = iter->second.load_;
+        done = iter->second.done_;
+        generation = iter->second.generation_;
+        queued_.erase(iter);
+    }
+
+    if (load) {
+        load();
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+    if (generation == generation_) {
+        finished_.push_back(done);
+    }
+}
+
+int load_queue::poll()
+{
+    std::deque<job> finished;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        finished.swap(finished_);
+        pending_ -= static_cast<int>(finished.size());
+    }
+
+    // outside of the lock, completions may submit more loads
+    BOOST_FOREACH(job& done, finished) {
+        if (done) {
+            done();
+        }
+    }
+    return static_cast<int>(finished.size());
+}
+
+int load_queue::get_pending()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return pending_;
+}
+
+void load_queue::cancel()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    queued_.clear();
+    finished_.clear();
+    generation_++;
+    pending_ = 0;
+}
+
+void load_queue::wait()
+{
+    work_pool* pool = NULL;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        pool = pool_.get();
+    }
+    if (pool != NULL) {
+        pool->wait();
+    }
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
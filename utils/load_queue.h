@@ -0,0 +1,114 @@
+#ifndef _LOAD_QUEUE_H
+#define _LOAD_QUEUE_H       1
+
+/**
+ * @file load_queue.h
+ * @brief Background loading with priorities; completions are handed back
+ *        to the thread which polls the queue (e.g. the UI thread).
+ * @date 10-18-26
+ */
+
+#include <map>
+#include <deque>
+#include <functional>
+
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "work_pool.h"
+
+namespace stan {
+
+/**
+ * Runs load jobs on a thread pool, highest priority first (jobs of equal
+ * priority in submit order). Each load has a completion job which is not
+ * run by the pool but queued until poll() is called, so completions can
+ * touch objects owned by the polling thread without locking.
+ *
+ * cancel() drops the jobs which have not started yet and the completions
+ * of the ones which are running, e.g. when the objects they refer to are
+ * about to be deleted.
+ */
+class load_queue
+{
+public:
+    typedef boost::function<void ()> job;
+
+    /**
+     * @param threads Number of loading threads, 0 = number of hardware
+     *        threads. The threads are started by the first submit().
+     */
+    load_queue(int threads = 0);
+
+    /**
+     * Cancels everything and waits for running loads.
+     */
+    virtual ~load_queue();
+
+    /**
+     * Queue a load. May be called from any thread.
+     * @param load Run on a pool thread
+     * @param done Run by poll() after the load finished, may be empty
+     * @param priority Higher values are loaded first
+     */
+    void submit(const job& load, const job& done, int priority = 0);
+
+    /**
+     * Run the completions of the finished loads on the calling thread.
+     * @return The number of completions run
+     */
+    int poll();
+
+    /**
+     * Number of loads submitted since the last cancel() whose completion
+     * has not been run by poll() yet.
+     */
+    int get_pending();
+
+    /**
+     * Forget the queued loads and the completions of running ones.
+     */
+    void cancel();
+
+    /**
+     * Block until every started load has finished (completions still have
+     * to be polled).
+     */
+    void wait();
+
+private:
+    class entry
+    {
+    public:
+        entry(const job& load, const job& done, unsigned long generation) :
+            load_(load),
+            done_(done),
+            generation_(generation)
+        {
+        }
+
+        job load_;
+        job done_;
+        unsigned long generation_;
+    };
+
+    typedef std::multimap<int, entry, std::greater<int> > entry_map;
+
+    /**
+     * Pool task: load the highest priority entry, if any is left.
+     */
+    void run_next(int worker);
+
+    int threads_;
+    boost::mutex mutex_;                // guards the members below
+    entry_map queued_;                  // by priority, equal keys in submit order
+    std::deque<job> finished_;          // completions waiting for poll()
+    unsigned long generation_;          // bumped by cancel()
+    int pending_;
+    boost::scoped_ptr<work_pool> pool_; // last, so it is stopped first
+};
+
+};  // namespace stan
+
+#endif  // _LOAD_QUEUE_H
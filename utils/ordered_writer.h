@@ -0,0 +1,108 @@
+#ifndef _ORDERED_WRITER_H
+#define _ORDERED_WRITER_H       1
+
+/**
+ * @file ordered_writer.h
+ * @brief Collects results produced out of order by several threads and
+ *        hands them to a sink strictly in sequence.
+ * @date 10-18-26
+ */
+
+#include <map>
+
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace stan {
+
+template <class Item>
+class ordered_writer
+{
+public:
+    /**
+     * Called once per item in sequence order, never concurrently.
+     */
+    typedef boost::function<void (int, Item&)> sink;
+
+    /**
+     * @param s The sink receiving the items
+     * @param first Sequence number of the first item
+     */
+    ordered_writer(const sink& s, int first = 0) :
+        sink_(s),
+        pending_(),
+        next_(first),
+        writing_(false),
+        mutex_(),
+        cond_()
+    {
+    }
+
+    virtual ~ordered_writer() {}
+
+    /**
+     * Hand over the item with the given sequence number. If it is the next
+     * one due, it (and any held items following it) is written by the
+     * calling thread; otherwise it is held until its turn.
+     */
+    void put(int index, const Item& item)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        pending_[index] = item;
+        if (writing_) {
+            return;     // the writing thread will pick it up
+        }
+
+        writing_ = true;
+        typename item_map::iterator iter;
+        while ( (iter = pending_.find(next_)) != pending_.end() ) {
+            Item due = iter->second;
+            pending_.erase(iter);
+
+            // other threads keep queueing items while this one writes
+            lock.unlock();
+            sink_(next_, due);
+            lock.lock();
+
+            next_++;
+            cond_.notify_all();
+        }
+        writing_ = false;
+    }
+
+    /**
+     * Block until the item with sequence number index may be started
+     * without more than window items being held or in progress.
+     */
+    void wait_for_slot(int index, int window)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        while (index >= next_ + window) {
+            cond_.wait(lock);
+        }
+    }
+
+    /**
+     * Sequence number of the next item to be written.
+     */
+    int get_next()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        return next_;
+    }
+
+private:
+    typedef std::map<int, Item> item_map;
+
+    sink sink_;
+    item_map pending_;      // items waiting for their turn
+    int next_;
+    bool writing_;
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+};
+
+};  // namespace stan
+
+#endif  // _ORDERED_WRITER_H
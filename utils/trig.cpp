@@ -90,23 +90,23 @@ double calcRotationAngle(Point& origin, Point& from, Point& to)
         return to_angle - from_angle;
 }
 
-void rotate_figure(figure* src_fig, figure *dst_fig, int origin_node, std::list<int> rot_nodes, double angle)
+void rotate_figure(figure* src_fig, figure *dst_fig, int origin_node, const std::list<int>& rot_nodes, double angle)
 {
     node* on = src_fig->get_node(origin_node);   // pivot node
+    affine rot = affine::rotation(angle, on->get_x(), on->get_y());
     BOOST_FOREACH(int n, rot_nodes) {
 
         node* sn = src_fig->get_node(n);        // source node
         node* dn = dst_fig->get_node(n);        // dest node
 
-        // define origin at 0,0
-        double dx = on->get_x();
-        double dy = on->get_y();
-
         // perform rotation by angle and store into dest node
-        dn->set_x( ((sn->get_x() - dx) * cos(angle) - (sn->get_y() - dy) * sin(angle)) + dx );
-        dn->set_y( ((sn->get_x() - dx) * sin(angle) + (sn->get_y() - dy) * cos(angle)) + dy );
+        double x = sn->get_x();
+        double y = sn->get_y();
+        rot.apply(x, y);
+        dn->move_to(x, y);
     }
 }
+
 void midpoint(Point& p1, Point& p2, Point& mp)
 {
     mp.x = p1.x + (p2.x - p1.x) / 2;
@@ -47,7 +47,7 @@ namespace stan {
     /**
      * rotate nodes from source figure positions into a destination figure (must be structually equivalent)
      */
-    void rotate_figure(figure* src_fig, figure *dst_fig, int origin_node, std::list<int> rot_nodes, double angle);
+    void rotate_figure(figure* src_fig, figure *dst_fig, int origin_node, const std::list<int>& rot_nodes, double angle);
 
     void midpoint(Point& p1, Point& p2, Point& mp);
 
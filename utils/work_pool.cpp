@@ -0,0 +1,156 @@
+/**
+ * @file work_pool.cpp
+ * @brief Implementation of the work stealing thread pool.
+ * @date 10-18-26
+ */
+
+#include <boost/bind.hpp>
+
+#include "work_pool.h"
+
+namespace stan {
+
+work_pool::work_pool(int threads) :
+    queues_(),
+    threads_(),
+    state_mutex_(),
+    work_cond_(),
+    done_cond_(),
+    queued_(0),
+    pending_(0),
+    next_queue_(0),
+    steals_(0),
+    stopping_(false)
+{
+    if (threads <= 0) {
+        threads = static_cast<int>(boost::thread::hardware_concurrency());
+        if (threads <= 0) {
+            threads = 1;
+        }
+    }
+
+    for (int i = 0; i < threads; i++) {
+        queues_.push_back(new task_queue());
+    }
+    for (int i = 0; i < threads; i++) {
+        threads_.create_thread(boost::bind(&work_pool::run, this, i));
+    }
+}
+
+work_pool::~work_pool()
+{
+    wait();
+    {
+        boost::mutex::scoped_lock lock(state_mutex_);
+        stopping_ = true;
+    }
+    work_cond_.notify_all();
+    threads_.join_all();
+
+    for (unsigned i = 0; i < queues_.size(); i++) {
+        delete queues_[i];
+    }
+}
+
+void work_pool::submit(const task& t)
+{
+    {
+        // counted and queued under one lock, so queued_ never runs behind
+        boost::mutex::scoped_lock lock(state_mutex_);
+        task_queue* q = queues_[next_queue_];
+        next_queue_ = (next_queue_ + 1) % queues_.size();
+
+        boost::mutex::scoped_lock queue_lock(q->mutex_);
+        q->tasks_.push_back(t);
+        queued_++;
+        pending_++;
+    }
+    work_cond_.notify_one();
+}
+
+void work_pool::wait()
+{
+    boost::mutex::scoped_lock lock(state_mutex_);
+    while (pending_ > 0) {
+        done_cond_.wait(lock);
+    }
+}
+
+unsigned long work_pool::get_steal_count()
+{
+    boost::mutex::scoped_lock lock(state_mutex_);
+    return steals_;
+}
+
+bool work_pool::take(int worker, task& t, bool& stolen)
+{
+    stolen = false;
+
+    // own queue first, oldest task first
+    {
+        task_queue* own = queues_[worker];
+        boost::mutex::scoped_lock lock(own->mutex_);
+        if (!own->tasks_.empty()) {
+            t = own->tasks_.front();
+            own->tasks_.pop_front();
+            return true;
+        }
+    }
+
+    // steal the newest task of another queue
+    unsigned count = queues_.size();
+    for (unsigned i = 1; i < count; i++) {
+        task_queue* victim = queues_[(worker + i) % count];
+        boost::mutex::scoped_lock lock(victim->mutex_);
+        if (!victim->tasks_.empty()) {
+            t = victim->tasks_.back();
+            victim->tasks_.pop_back();
+            stolen = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void work_pool::run(int worker)
+{
+    for (;;) {
+        {
+            boost::mutex::scoped_lock lock(state_mutex_);
+            while ( (queued_ == 0) && !stopping_ ) {
+                work_cond_.wait(lock);
+            }
+            if ( (queued_ == 0) && stopping_ ) {
+                return;
+            }
+        }
+
+        task t;
+        bool stolen;
+        if (!take(worker, t, stolen)) {
+            continue;   // another worker got there first
+        }
+
+        {
+            boost::mutex::scoped_lock lock(state_mutex_);
+            queued_--;
+            if (stolen) {
+                steals_++;
+            }
+        }
+
+        t(worker);
+
+        {
+            boost::mutex::scoped_lock lock(state_mutex_);
+            pending_--;
+            if (pending_ == 0) {
+                done_cond_.notify_all();
+            }
+        }
+    }
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,96 @@
+#ifndef _WORK_POOL_H
+#define _WORK_POOL_H       1
+
+/**
+ * @file work_pool.h
+ * @brief Fixed size thread pool with per-thread task queues and work
+ *        stealing.
+ * @date 10-18-26
+ */
+
+#include <deque>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace stan {
+
+/**
+ * Tasks are spread over one queue per worker thread. A worker takes tasks
+ * from the front of its own queue and, when that is empty, steals from the
+ * back of the other queues, so uneven tasks still keep every thread busy.
+ *
+ * Each task is passed the index of the worker running it, which lets
+ * callers keep per-thread state (e.g. a render buffer) without locking.
+ */
+class work_pool
+{
+public:
+    typedef boost::function<void (int)> task;
+
+    /**
+     * Start the worker threads.
+     * @param threads Number of threads, 0 = number of hardware threads
+     */
+    work_pool(int threads = 0);
+
+    /**
+     * Waits for all submitted tasks, then stops the threads.
+     */
+    virtual ~work_pool();
+
+    int get_thread_count() const { return static_cast<int>(queues_.size()); }
+
+    /**
+     * Queue a task. May be called from any thread, including tasks.
+     */
+    void submit(const task& t);
+
+    /**
+     * Block until every submitted task has finished.
+     */
+    void wait();
+
+    /**
+     * Number of tasks which were run by a thread other than the one they
+     * were queued for.
+     */
+    unsigned long get_steal_count();
+
+private:
+    class task_queue
+    {
+    public:
+        boost::mutex mutex_;
+        std::deque<task> tasks_;
+    };
+
+    void run(int worker);
+
+    /**
+     * Take a task from the worker's own queue or steal one.
+     * @note Locks only the queues; submit() locks state_mutex_ first and
+     *       then a queue, so the reverse order must not be used here.
+     * @return false if every queue is empty
+     */
+    bool take(int worker, task& t, bool& stolen);
+
+    std::vector<task_queue*> queues_;
+    boost::thread_group threads_;
+
+    boost::mutex state_mutex_;              // guards the members below
+    boost::condition_variable work_cond_;   // tasks were queued or stopping
+    boost::condition_variable done_cond_;   // pending_ dropped to zero
+    unsigned queued_;                       // tasks waiting in the queues
+    unsigned pending_;                      // tasks queued or running
+    unsigned next_queue_;                   // round robin submit position
+    unsigned long steals_;
+    bool stopping_;
+};
+
+};  // namespace stan
+
+#endif  // _WORK_POOL_H
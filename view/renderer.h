@@ -0,0 +1,48 @@
+#ifndef _RENDERER_H
+#define _RENDERER_H   1
+
+/**
+ * @file renderer.h
+ * @brief Interface of a render target for figures and frames.
+ * @date 10-18-26
+ */
+
+#include "animation.h"
+
+namespace stan {
+
+/**
+ * A renderer draws the model into some target (a window, a memory buffer,
+ * ...). Coordinates passed in are model coordinates; each renderer maps
+ * them onto its own target.
+ */
+class Renderer
+{
+public:
+    virtual ~Renderer() {}
+
+    /**
+     * Fill the whole target with a model color.
+     */
+    virtual void clear(int color) = 0;
+
+    /**
+     * Renders a figure with its node positions offset by (xoff, yoff) and
+     * then scaled by (xscale, yscale).
+     */
+    virtual void render_figure(figure* fig, double xoff, double yoff,
+                               double xscale = 1.0, double yscale = 1.0, bool draw_nodes = false) = 0;
+
+    /**
+     * Renders a frame (background and figures) scaled to fill the target.
+     * @param meta The meta data of the animation, used to look up the
+     *        background image. May be NULL.
+     * @param default_image Background image index used when the frame has
+     *        none (during playback the last background stays up).
+     */
+    virtual void render_frame(frame* fr, meta_store* meta, int default_image = -1) = 0;
+};
+
+};   // namespace stan
+
+#endif  // _RENDERER_H
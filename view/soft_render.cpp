@@ -0,0 +1,289 @@
+/**
+ * @file soft_render.cpp
+ * @brief Implementation of the software rasterizer.
+ * @date 10-18-26
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "soft_render.h"
+
+namespace stan {
+
+namespace {
+
+int make_color(unsigned char r, unsigned char g, unsigned char b)
+{
+    // same byte layout as WxRender::set_wx_color() reads
+    int color = 0;
+    unsigned char* p_color_bytes = reinterpret_cast<unsigned char*>(&color);
+    p_color_bytes[0] = r;
+    p_color_bytes[1] = g;
+    p_color_bytes[2] = b;
+    return color;
+}
+
+/**
+ * Squared distance from (px, py) to the segment (x1, y1) - (x2, y2).
+ */
+double segment_distance2(double px, double py, double x1, double y1, double x2, double y2)
+{
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    double len2 = (dx * dx) + (dy * dy);
+
+    double t = 0;
+    if (len2 > 0) {
+        t = (((px - x1) * dx) + ((py - y1) * dy)) / len2;
+        t = std::max(0.0, std::min(1.0, t));
+    }
+    double ex = x1 + (t * dx) - px;
+    double ey = y1 + (t * dy) - py;
+    return (ex * ex) + (ey * ey);
+}
+
+};  // anonymous namespace
+
+SoftRender::SoftRender(int width, int height) :
+    target_(width, height),
+    images_()
+{
+}
+
+void SoftRender::resize(int width, int height)
+{
+    target_ = soft_image(width, height);
+}
+
+int SoftRender::get_color(int x, int y) const
+{
+    const unsigned char* p = target_.get_pixel(x, y);
+    return make_color(p[0], p[1], p[2]);
+}
+
+void SoftRender::add_image(const std::string& path, const soft_image& image)
+{
+    images_[path].reset(new soft_image(image));
+}
+
+void SoftRender::plot(int x, int y, int color)
+{
+    if ( (x < 0) || (y < 0) || (x >= target_.get_width()) || (y >= target_.get_height()) ) {
+        return;
+    }
+
+    const unsigned char* p_color_bytes = reinterpret_cast<const unsigned char*>(&color);
+    unsigned char* p = target_.get_pixel(x, y);
+    p[0] = p_color_bytes[0];
+    p[1] = p_color_bytes[1];
+    p[2] = p_color_bytes[2];
+    p[3] = 255;
+}
+
+void SoftRender::clear(int color)
+{
+    for (int y = 0; y < target_.get_height(); y++) {
+        for (int x = 0; x < target_.get_width(); x++) {
+            plot(x, y, color);
+        }
+    }
+}
+
+void SoftRender::draw_line(double x1, double y1, double x2, double y2, double weight, int color)
+{
+    // a line is every pixel within weight / 2 of the segment
+    double r = std::max(weight, 1.0) / 2;
+    double r2 = r * r;
+
+    int xl = std::max(0, static_cast<int>(floor(std::min(x1, x2) - r)));
+    int xr = std::min(target_.get_width() - 1, static_cast<int>(ceil(std::max(x1, x2) + r)));
+    int yt = std::max(0, static_cast<int>(floor(std::min(y1, y2) - r)));
+    int yb = std::min(target_.get_height() - 1, static_cast<int>(ceil(std::max(y1, y2) + r)));
+
+    for (int y = yt; y <= yb; y++) {
+        for (int x = xl; x <= xr; x++) {
+            if (segment_distance2(x, y, x1, y1, x2, y2) <= r2) {
+                plot(x, y, color);
+            }
+        }
+    }
+}
+
+void SoftRender::draw_circle(double cx, double cy, double radius, double weight, int color)
+{
+    // the outline is every pixel within weight / 2 of the circle
+    double r = std::max(weight, 1.0) / 2;
+
+    int xl = std::max(0, static_cast<int>(floor(cx - radius - r)));
+    int xr = std::min(target_.get_width() - 1, static_cast<int>(ceil(cx + radius + r)));
+    int yt = std::max(0, static_cast<int>(floor(cy - radius - r)));
+    int yb = std::min(target_.get_height() - 1, static_cast<int>(ceil(cy + radius + r)));
+
+    for (int y = yt; y <= yb; y++) {
+        for (int x = xl; x <= xr; x++) {
+            double dx = x - cx;
+            double dy = y - cy;
+            double d = sqrt((dx * dx) + (dy * dy));
+            if (fabs(d - radius) <= r) {
+                plot(x, y, color);
+            }
+        }
+    }
+}
+
+void SoftRender::draw_image(const soft_image& image, Point& p0, Point& p1)
+{
+    double dx = p1.x - p0.x;
+    double dy = p1.y - p0.y;
+    double height = sqrt((dx * dx) + (dy * dy));
+    if ( (height == 0) || (image.get_width() <= 0) || (image.get_height() <= 0) ) {
+        return;
+    }
+
+    // p0 is the bottom center of the image, p1 the top center; the width
+    // keeps the aspect ratio of the image
+    double width = (static_cast<double>(image.get_width()) / image.get_height()) * height;
+    double ux = dx / height;     // unit vector bottom -> top
+    double uy = dy / height;
+    double vx = -uy;            // unit vector across the image
+    double vy = ux;
+
+    double reach = sqrt((height * height) + (width * width / 4));
+    int xl = std::max(0, static_cast<int>(floor(p0.x - reach)));
+    int xr = std::min(target_.get_width() - 1, static_cast<int>(ceil(p0.x + reach)));
+    int yt = std::max(0, static_cast<int>(floor(p0.y - reach)));
+    int yb = std::min(target_.get_height() - 1, static_cast<int>(ceil(p0.y + reach)));
+
+    for (int y = yt; y <= yb; y++) {
+        for (int x = xl; x <= xr; x++) {
+            // map back into the image (nearest neighbour)
+            double t = ((x - p0.x) * ux) + ((y - p0.y) * uy);
+            double s = ((x - p0.x) * vx) + ((y - p0.y) * vy);
+            if ( (t < 0) || (t >= height) || (s < -width / 2) || (s >= width / 2) ) {
+                continue;
+            }
+            int ix = static_cast<int>(((s / width) + 0.5) * image.get_width());
+            int iy = static_cast<int>((1.0 - (t / height)) * image.get_height());
+            ix = std::min(ix, image.get_width() - 1);
+            iy = std::min(std::max(iy, 0), image.get_height() - 1);
+
+            const unsigned char* p = image.get_pixel(ix, iy);
+            if ( (p[3] == 0) || ((p[0] == 0) && (p[1] == 0) && (p[2] == 0)) ) {
+                continue;   // transparent
+            }
+            plot(x, y, make_color(p[0], p[1], p[2]));
+        }
+    }
+}
+
+void SoftRender::draw_background(const soft_image& image)
+{
+    if ( (image.get_width() <= 0) || (image.get_height() <= 0) ) {
+        return;
+    }
+
+    for (int y = 0; y < target_.get_height(); y++) {
+        int iy = (y * image.get_height()) / target_.get_height();
+        for (int x = 0; x < target_.get_width(); x++) {
+            int ix = (x * image.get_width()) / target_.get_width();
+            const unsigned char* p = image.get_pixel(ix, iy);
+            plot(x, y, make_color(p[0], p[1], p[2]));
+        }
+    }
+}
+
+const soft_image* SoftRender::find_image(meta_store* meta, int index)
+{
+    if ( (meta == NULL) || (index < 0) ) {
+        return NULL;
+    }
+
+    meta_data* md = meta->get_meta_data(index);
+    if (md == NULL) {
+        return NULL;
+    }
+
+    image_map::iterator iter = images_.find(md->get_path());
+    return (iter != images_.end()) ? iter->second.get() : NULL;
+}
+
+void SoftRender::render_figure(figure* fig, double xoff, double yoff,
+                               double xscale, double yscale, bool draw_nodes)
+{
+    bool enabled = fig->is_enabled();
+    double weight = fig->get_weight() * xscale;
+
+    const node_store& ns = fig->get_node_store();
+
+    for (unsigned eindex = 0; eindex < fig->get_edges().size(); eindex++) {
+        edge* e = fig->get_edge(eindex);
+        if (e == NULL) {
+            continue;
+        }
+
+        double x1 = (ns.x_[e->get_n1()] + xoff) * xscale;
+        double y1 = (ns.y_[e->get_n1()] + yoff) * yscale;
+        double x2 = (ns.x_[e->get_n2()] + xoff) * xscale;
+        double y2 = (ns.y_[e->get_n2()] + yoff) * yscale;
+
+        // disabled, use background color
+        int color = enabled ? e->get_color() : make_color(136, 136, 136);
+
+        if (e->get_type() == edge::edge_line) {
+            draw_line(x1, y1, x2, y2, weight, color);
+        }
+        else if (e->get_type() == edge::edge_circle) {
+            // the mid-point between n1 and n2 is the center
+            double cx = x1 + (x2 - x1) / 2;
+            double cy = y1 + (y2 - y1) / 2;
+            double radius = sqrt(((x2 - x1) * (x2 - x1)) + ((y2 - y1) * (y2 - y1))) / 2;
+            draw_circle(cx, cy, radius, weight, color);
+        }
+        else if ( (e->get_type() == edge::edge_image) && enabled ) {
+            const soft_image* image = find_image(fig->get_meta_store(), e->get_meta_index());
+            if (image != NULL) {
+                Point p0(x1, y1);
+                Point p1(x2, y2);
+                draw_image(*image, p0, p1);
+            }
+        }
+    }
+
+    if (enabled && draw_nodes) {
+        for (int nindex = 0; nindex < ns.size(); nindex++) {
+            if (ns.is_live(nindex)) {
+                int color = fig->is_root_node(nindex) ? make_color(0, 255, 0) : make_color(255, 0, 0);
+                draw_circle((ns.x_[nindex] + xoff) * xscale, (ns.y_[nindex] + yoff) * yscale,
+                            2, fig->get_weight(), color);
+            }
+        }
+    }
+}
+
+void SoftRender::render_frame(frame* fr, meta_store* meta, int default_image)
+{
+    double xscale = static_cast<double>(target_.get_width()) / static_cast<double>(fr->get_width());
+    double yscale = static_cast<double>(target_.get_height()) / static_cast<double>(fr->get_height());
+
+    clear(make_color(255, 255, 255));
+
+    int img_index = fr->get_image_index();
+    if (img_index < 0) {
+        img_index = default_image;
+    }
+
+    const soft_image* background = find_image(meta, img_index);
+    if (background != NULL) {
+        draw_background(*background);
+    }
+
+    // node positions are relative to the frame
+    BOOST_FOREACH(figure* f, fr->get_figures()) {
+        render_figure(f, 0, 0, xscale, yscale);
+    }
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,129 @@
+#ifndef _SOFT_RENDER_H
+#define _SOFT_RENDER_H   1
+
+/**
+ * @file soft_render.h
+ * @brief Headless renderer which rasterizes into an RGBA memory buffer.
+ * @date 10-18-26
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "renderer.h"
+#include "trig.h"
+
+namespace stan {
+
+/**
+ * An RGBA image (4 bytes per pixel, rows top to bottom) used as source
+ * for image edges and frame backgrounds.
+ */
+class soft_image
+{
+public:
+    soft_image() :
+        width_(0),
+        height_(0),
+        pixels_()
+    {
+    }
+
+    soft_image(int width, int height) :
+        width_(width),
+        height_(height),
+        pixels_(static_cast<unsigned>(width * height * 4), 0)
+    {
+    }
+
+    int get_width() const { return width_; }
+    int get_height() const { return height_; }
+    unsigned char* get_pixel(int x, int y) { return &pixels_[(y * width_ + x) * 4]; }
+    const unsigned char* get_pixel(int x, int y) const { return &pixels_[(y * width_ + x) * 4]; }
+    std::vector<unsigned char>& get_pixels() { return pixels_; }
+
+private:
+    int width_;
+    int height_;
+    std::vector<unsigned char> pixels_;
+};
+
+/**
+ * Software rasterizer. Does not need a display or any GUI toolkit, so it
+ * can render in tests and batch tools.
+ *
+ * Images referenced by the model are looked up by their meta data path;
+ * the caller loads them and registers them with add_image(). Image edges
+ * and backgrounds without a registered image are skipped. As with the
+ * wxWidgets renderer, black image pixels are transparent.
+ *
+ * Copies of a renderer share the registered images, so one renderer per
+ * thread can be made from a prepared one cheaply.
+ */
+class SoftRender : public Renderer
+{
+public:
+    SoftRender(int width, int height);
+
+    virtual ~SoftRender() {}
+
+    /**
+     * Change the size of the target (contents are cleared to black).
+     */
+    void resize(int width, int height);
+
+    int get_width() const { return target_.get_width(); }
+    int get_height() const { return target_.get_height(); }
+
+    /**
+     * The rendered pixels, RGBA with rows top to bottom.
+     */
+    const soft_image& get_target() const { return target_; }
+
+    /**
+     * Get a pixel as a model color (red in the first byte, as set_wx_color).
+     */
+    int get_color(int x, int y) const;
+
+    /**
+     * Register the pixels for images with the given meta data path.
+     */
+    void add_image(const std::string& path, const soft_image& image);
+
+    void clear_images() { images_.clear(); }
+
+    // Renderer interface
+    virtual void clear(int color);
+    virtual void render_figure(figure* fig, double xoff, double yoff,
+                               double xscale = 1.0, double yscale = 1.0, bool draw_nodes = false);
+    virtual void render_frame(frame* fr, meta_store* meta, int default_image = -1);
+
+    /**
+     * Primitives, in target pixel coordinates.
+     */
+    void draw_line(double x1, double y1, double x2, double y2, double weight, int color);
+    void draw_circle(double cx, double cy, double radius, double weight, int color);
+    void draw_image(const soft_image& image, Point& p0, Point& p1);
+    void draw_background(const soft_image& image);
+
+private:
+    /**
+     * Look up a registered image by meta data.
+     * @return NULL if not registered
+     */
+    const soft_image* find_image(meta_store* meta, int index);
+
+    void plot(int x, int y, int color);
+
+    typedef boost::unordered_map<std::string, boost::shared_ptr<const soft_image> > image_map;
+
+    soft_image target_;
+    image_map images_;
+};
+
+};   // namespace stan
+
+#endif  // _SOFT_RENDER_H
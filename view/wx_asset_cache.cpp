@@ -0,0 +1,162 @@
+/**
+ * @file wx_asset_cache.cpp
+ * @brief Implementation of the image and sound cache.
+ * @date 10-18-26
+ */
+
+#include <sstream>
+#include <fstream>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "wx_asset_cache.h"
+#include <wx/wx.h>
+#include <wx/sound.h>
+#include <wx/filename.h>
+#include <wx/thread.h>
+
+namespace stan {
+
+WxAssetCache::WxAssetCache(asset_cache<wxImage>::releaser release_image,
+                           std::size_t image_budget, std::size_t sound_budget) :
+    release_image_(release_image),
+    released_mutex_(),
+    released_images_(),
+    released_sounds_(),
+    images_(&WxAssetCache::load_image, image_budget, boost::bind(&WxAssetCache::release_image, this, _1)),
+    sounds_(&WxAssetCache::load_sound, sound_budget, boost::bind(&WxAssetCache::release_sound, this, _1))
+{
+}
+
+WxAssetCache::~WxAssetCache()
+{
+    images_.clear();
+    sounds_.clear();
+    flush_releases();
+}
+
+boost::shared_ptr<wxImage> WxAssetCache::get_image(const std::string& path)
+{
+    return images_.get(make_key(path), path);
+}
+
+boost::shared_ptr<wxSound> WxAssetCache::get_sound(const std::string& path)
+{
+    return sounds_.get(make_key(path), path);
+}
+
+std::string WxAssetCache::make_key(const std::string& path)
+{
+    wxFileName name(wxString(path.c_str(), wxConvUTF8));
+    name.Normalize(wxPATH_NORM_ALL);
+
+    std::ostringstream key;
+    key << (const char*)name.GetFullPath().mb_str(wxConvUTF8);
+    if (name.FileExists()) {
+        key << "|" << name.GetModificationTime().GetTicks();
+    }
+    return key.str();
+}
+
+std::size_t WxAssetCache::get_resident_bytes()
+{
+    return images_.get_resident_bytes() + sounds_.get_resident_bytes();
+}
+
+std::size_t WxAssetCache::get_live_bytes()
+{
+    return images_.get_live_bytes() + sounds_.get_live_bytes();
+}
+
+void WxAssetCache::report(std::ostream& os)
+{
+    os << "Assets: " << images_.get_live_count() << " images ("
+       << images_.get_live_bytes() / 1024 << " KB), "
+       << sounds_.get_live_count() << " sounds ("
+       << sounds_.get_live_bytes() / 1024 << " KB), "
+       << images_.get_loads() + sounds_.get_loads() << " decoded, "
+       << images_.get_failures() + sounds_.get_failures() << " failed" << std::endl;
+}
+
+void WxAssetCache::clear()
+{
+    images_.clear();
+    sounds_.clear();
+}
+
+void WxAssetCache::flush_releases()
+{
+    std::vector<wxImage*> images;
+    std::vector<wxSound*> sounds;
+    {
+        boost::mutex::scoped_lock lock(released_mutex_);
+        images.swap(released_images_);
+        sounds.swap(released_sounds_);
+    }
+
+    BOOST_FOREACH(wxImage* image, images) {
+        release_image(image);
+    }
+    BOOST_FOREACH(wxSound* sound, sounds) {
+        release_sound(sound);
+    }
+}
+
+void WxAssetCache::release_image(wxImage* image)
+{
+    if (!wxThread::IsMain()) {
+        boost::mutex::scoped_lock lock(released_mutex_);
+        released_images_.push_back(image);
+        return;
+    }
+
+    if (release_image_) {
+        release_image_(image);
+    }
+    else {
+        delete image;
+    }
+}
+
+void WxAssetCache::release_sound(wxSound* sound)
+{
+    if (!wxThread::IsMain()) {
+        boost::mutex::scoped_lock lock(released_mutex_);
+        released_sounds_.push_back(sound);
+        return;
+    }
+    delete sound;
+}
+
+wxImage* WxAssetCache::load_image(const std::string& path, std::size_t& bytes)
+{
+    wxImage* image = new wxImage();
+    if (!image->LoadFile(wxString(path.c_str(), wxConvUTF8)) || !image->IsOk()) {
+        delete image;
+        return NULL;
+    }
+
+    // RGB plus the optional alpha plane
+    std::size_t pixels = static_cast<std::size_t>(image->GetWidth()) * image->GetHeight();
+    bytes = pixels * (image->HasAlpha() ? 4 : 3);
+    return image;
+}
+
+wxSound* WxAssetCache::load_sound(const std::string& path, std::size_t& bytes)
+{
+    wxSound* sound = new wxSound(wxString(path.c_str(), wxConvUTF8));
+    if (!sound->IsOk()) {
+        delete sound;
+        return NULL;
+    }
+
+    // sounds are held as the file data
+    std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    bytes = ifs.good() ? static_cast<std::size_t>(ifs.tellg()) : 0;
+    return sound;
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,102 @@
+#ifndef _WX_ASSET_CACHE_H
+#define _WX_ASSET_CACHE_H   1
+
+/**
+ * @file wx_asset_cache.h
+ * @brief Process wide cache of decoded images and sounds, shared by all
+ *        figures and animations.
+ * @date 10-18-26
+ */
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstddef>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "asset_cache.h"
+
+// forward declarations
+class wxImage;
+class wxSound;
+
+namespace stan {
+
+/**
+ * Assets may be loaded on background threads, where evicting one can drop
+ * the last handle of another. wx objects are only deleted on the UI
+ * thread: releases on other threads are queued until flush_releases().
+ */
+class WxAssetCache
+{
+public:
+    static const std::size_t DEFAULT_IMAGE_BUDGET = 256 * 1024 * 1024;    // bytes
+    static const std::size_t DEFAULT_SOUND_BUDGET = 64 * 1024 * 1024;
+
+    /**
+     * @param release_image Called on the UI thread instead of deleting an
+     *        image which is no longer used (e.g. to drop bitmaps made from
+     *        it first), it must delete the image.
+     */
+    WxAssetCache(asset_cache<wxImage>::releaser release_image = asset_cache<wxImage>::releaser(),
+                 std::size_t image_budget = DEFAULT_IMAGE_BUDGET,
+                 std::size_t sound_budget = DEFAULT_SOUND_BUDGET);
+
+    virtual ~WxAssetCache();
+
+    /**
+     * Get the decoded image or sound for a file.
+     * @return The shared handle, empty if the file can not be loaded
+     */
+    boost::shared_ptr<wxImage> get_image(const std::string& path);
+    boost::shared_ptr<wxSound> get_sound(const std::string& path);
+
+    /**
+     * The cache key of a file: its canonical path and modification time,
+     * so different spellings of a path share an asset and a changed file
+     * is loaded again.
+     */
+    static std::string make_key(const std::string& path);
+
+    /**
+     * Memory used by decoded assets: kept resident by the cache, and
+     * alive in total (including evicted assets still in use).
+     */
+    std::size_t get_resident_bytes();
+    std::size_t get_live_bytes();
+
+    /**
+     * Print asset counts and memory use.
+     */
+    void report(std::ostream& os);
+
+    /**
+     * Drop all resident assets (assets in use stay valid).
+     */
+    void clear();
+
+    /**
+     * Delete the assets released on other threads (UI thread only).
+     */
+    void flush_releases();
+
+private:
+    static wxImage* load_image(const std::string& path, std::size_t& bytes);
+    static wxSound* load_sound(const std::string& path, std::size_t& bytes);
+
+    void release_image(wxImage* image);
+    void release_sound(wxSound* sound);
+
+    asset_cache<wxImage>::releaser release_image_;
+    boost::mutex released_mutex_;
+    std::vector<wxImage*> released_images_;     // waiting for the UI thread
+    std::vector<wxSound*> released_sounds_;
+    asset_cache<wxImage> images_;
+    asset_cache<wxSound> sounds_;
+};
+
+};   // namespace stan
+
+#endif  // _WX_ASSET_CACHE_H
@@ -0,0 +1,189 @@
+/**
+ * @file wx_asset_loader.cpp
+ * @brief Implementation of the background asset loader.
+ * @date 10-18-26
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <set>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "wx_asset_loader.h"
+#include <wx/wx.h>
+#include <wx/sound.h>
+
+namespace stan {
+
+WxAssetLoader::WxAssetLoader(WxAssetCache& cache, int threads) :
+    cache_(cache),
+    queue_(threads),
+    requested_(),
+    ready_(),
+    waiting_(),
+    completed_()
+{
+}
+
+void WxAssetLoader::request(meta_store* meta, int priority)
+{
+    std::vector<meta_data*>& table = meta->get_meta_table();
+    for (unsigned i = 0; i < table.size(); i++) {
+        request(store_ref(meta), static_cast<int>(i), priority);
+    }
+}
+
+void WxAssetLoader::request(boost::shared_ptr<meta_store> meta, int priority)
+{
+    std::vector<meta_data*>& table = meta->get_meta_table();
+    for (unsigned i = 0; i < table.size(); i++) {
+        request(store_ref(meta), static_cast<int>(i), priority);
+    }
+}
+
+void WxAssetLoader::request(meta_store* meta, int index, int priority)
+{
+    request(store_ref(meta), index, priority);
+}
+
+void WxAssetLoader::request(const store_ref& store, int index, int priority)
+{
+    meta_data* data = store.get()->get_meta_data(index);
+    if ( (data == NULL) || (data->get_meta_ptr() != NULL) ) {
+        return;
+    }
+
+    meta_type type = data->get_type();
+    if ( (type != META_IMAGE) && (type != META_SOUND) ) {
+        std::cout << "Invalid meta data type " << type << std::endl;
+        return;
+    }
+
+    std::string path = data->get_path();
+    boost::unordered_map<std::string, boost::shared_ptr<void> >::iterator ready = ready_.find(path);
+    if (ready != ready_.end()) {
+        if (ready->second) {
+            data->set_meta_handle(ready->second);
+        }
+        return;
+    }
+
+    std::vector<store_ref>& waiting = waiting_[path];
+    if (std::find(waiting.begin(), waiting.end(), store) == waiting.end()) {
+        waiting.push_back(store);
+    }
+
+    boost::unordered_map<std::string, int>::iterator iter = requested_.find(path);
+    if (iter != requested_.end()) {
+        if (iter->second >= priority) {
+            return;
+        }
+
+        // queue it again ahead of the rest, whichever load runs second
+        // finds the asset in the cache
+        iter->second = priority;
+    }
+    else {
+        requested_[path] = priority;
+    }
+
+    boost::shared_ptr<result> loaded(new result());
+    queue_.submit(boost::bind(&WxAssetLoader::load, this, path, type, loaded),
+                  boost::bind(&WxAssetLoader::loaded, this, path, loaded),
+                  priority);
+}
+
+int WxAssetLoader::poll()
+{
+    // loads evict assets on the pool threads, delete them here
+    cache_.flush_releases();
+
+    std::size_t ready = ready_.size();
+    queue_.poll();
+    return static_cast<int>(ready_.size() - ready);
+}
+
+bool WxAssetLoader::attach(meta_store* meta)
+{
+    bool complete = true;
+    BOOST_FOREACH(meta_data* data, meta->get_meta_table()) {
+        if (data->get_meta_ptr() != NULL) {
+            continue;
+        }
+
+        std::string path = data->get_path();
+        boost::unordered_map<std::string, boost::shared_ptr<void> >::iterator iter = ready_.find(path);
+        if (iter != ready_.end()) {
+            if (iter->second) {
+                data->set_meta_handle(iter->second);
+            }
+        }
+        else if (requested_.find(path) != requested_.end()) {
+            complete = false;
+        }
+    }
+    return complete;
+}
+
+bool WxAssetLoader::is_loading(const std::string& path)
+{
+    return (requested_.find(path) != requested_.end()) && (ready_.find(path) == ready_.end());
+}
+
+int WxAssetLoader::attach_ready()
+{
+    // a store waiting for several of the assets is filled in once
+    std::set<meta_store*> attached;
+    BOOST_FOREACH(const store_ref& store, completed_) {
+        meta_store* meta = store.get();
+        if ( (meta != NULL) && attached.insert(meta).second ) {
+            attach(meta);
+        }
+    }
+    completed_.clear();
+    return static_cast<int>(attached.size());
+}
+
+void WxAssetLoader::cancel()
+{
+    queue_.cancel();
+    requested_.clear();
+    ready_.clear();
+    waiting_.clear();
+    completed_.clear();
+}
+
+void WxAssetLoader::load(std::string path, meta_type type, boost::shared_ptr<result> loaded)
+{
+    if (type == META_IMAGE) {
+        loaded->asset_ = cache_.get_image(path);
+    }
+    else {
+        loaded->asset_ = cache_.get_sound(path);
+    }
+}
+
+void WxAssetLoader::loaded(std::string path, boost::shared_ptr<result> loaded)
+{
+    if (ready_.find(path) != ready_.end()) {
+        // a second request with a higher priority
+        return;
+    }
+
+    if (!loaded->asset_) {
+        std::cout << "Invalid asset file " << path << std::endl;
+    }
+    ready_[path] = loaded->asset_;
+
+    boost::unordered_map<std::string, std::vector<store_ref> >::iterator iter = waiting_.find(path);
+    if (iter != waiting_.end()) {
+        completed_.insert(completed_.end(), iter->second.begin(), iter->second.end());
+        waiting_.erase(iter);
+    }
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
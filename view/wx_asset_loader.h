@@ -0,0 +1,164 @@
+#ifndef _WX_ASSET_LOADER_H
+#define _WX_ASSET_LOADER_H   1
+
+/**
+ * @file wx_asset_loader.h
+ * @brief Decodes the images and sounds of meta stores in the background.
+ * @date 10-18-26
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "metadata.h"
+#include "load_queue.h"
+#include "wx_asset_cache.h"
+
+namespace stan {
+
+/**
+ * Loads meta data assets through the asset cache on background threads.
+ * Meta data stays without an object (drawn as a placeholder) until
+ * poll() received the decoded asset and attach_ready() stored it in the
+ * stores which requested it. Entries whose asset is already loaded are
+ * filled in by request() right away.
+ *
+ * Only the loads touch other threads: request(), poll() and attach() are
+ * meant to be called from the UI thread, which owns the meta stores.
+ */
+class WxAssetLoader
+{
+public:
+    static const int PRIORITY_VISIBLE = 10;     // e.g. the frame on screen
+    static const int PRIORITY_BACKGROUND = 0;   // everything else
+
+    /**
+     * @param threads Number of decoding threads, 0 = number of hardware
+     *        threads
+     */
+    WxAssetLoader(WxAssetCache& cache, int threads = 0);
+
+    virtual ~WxAssetLoader() {}
+
+    /**
+     * Queue every entry of a store which has no object yet. Paths already
+     * queued are only queued again with a higher priority.
+     * @note The store must stay alive until cancel().
+     */
+    void request(meta_store* meta, int priority);
+
+    /**
+     * Queue every entry of a store shared by figures. The loader does not
+     * keep the store alive, it is skipped if deleted before its assets
+     * are ready.
+     */
+    void request(boost::shared_ptr<meta_store> meta, int priority);
+
+    /**
+     * Queue a single entry of a store (ignores indices out of range).
+     * @note The store must stay alive until cancel().
+     */
+    void request(meta_store* meta, int index, int priority);
+
+    /**
+     * Collect the finished loads and delete the assets they released.
+     * @return The number of assets which became ready
+     */
+    int poll();
+
+    /**
+     * Store the loaded objects in the entries of a store still without one.
+     * @return true if none of its entries is still loading
+     */
+    bool attach(meta_store* meta);
+
+    /**
+     * Attach the assets collected by poll() to the stores which requested
+     * them, leaving all other stores alone.
+     * @return The number of stores updated
+     */
+    int attach_ready();
+
+    bool is_loading(const std::string& path);
+
+    /**
+     * Number of assets not ready yet.
+     */
+    int get_pending() { return queue_.get_pending(); }
+
+    /**
+     * Forget all requests and loaded objects, e.g. before the meta stores
+     * are deleted.
+     */
+    void cancel();
+
+private:
+    class result
+    {
+    public:
+        boost::shared_ptr<void> asset_;
+    };
+
+    /**
+     * A requesting store, followed weakly if it is shared.
+     */
+    class store_ref
+    {
+    public:
+        explicit store_ref(meta_store* meta) :
+            meta_(meta),
+            shared_(),
+            is_shared_(false)
+        {
+        }
+
+        explicit store_ref(boost::shared_ptr<meta_store> meta) :
+            meta_(meta.get()),
+            shared_(meta),
+            is_shared_(true)
+        {
+        }
+
+        /**
+         * @return The store or NULL if it was deleted
+         */
+        meta_store* get() const { return (!is_shared_ || !shared_.expired()) ? meta_ : NULL; }
+
+        bool operator==(const store_ref& other) const
+        {
+            return (meta_ == other.meta_) && !(shared_ < other.shared_) && !(other.shared_ < shared_);
+        }
+
+    private:
+        meta_store* meta_;
+        boost::weak_ptr<meta_store> shared_;
+        bool is_shared_;
+    };
+
+    void request(const store_ref& store, int index, int priority);
+
+    /**
+     * Pool thread: decode through the cache.
+     */
+    void load(std::string path, meta_type type, boost::shared_ptr<result> loaded);
+
+    /**
+     * UI thread: the asset is ready.
+     */
+    void loaded(std::string path, boost::shared_ptr<result> loaded);
+
+    WxAssetCache& cache_;
+    load_queue queue_;
+    boost::unordered_map<std::string, int> requested_;                      // path, priority
+    boost::unordered_map<std::string, boost::shared_ptr<void> > ready_;    // empty if failed
+    boost::unordered_map<std::string, std::vector<store_ref> > waiting_;   // path, stores requesting it
+    std::vector<store_ref> completed_;      // stores with assets ready since attach_ready()
+};
+
+};   // namespace stan
+
+#endif  // _WX_ASSET_LOADER_H
@@ -0,0 +1,35 @@
+/**
+ * @file wx_bg_cache.cpp
+ * @brief Implementation of the background bitmap cache.
+ * @date 10-18-26
+ */
+
+#include "wx_bg_cache.h"
+#include <wx/wx.h>
+
+namespace stan {
+
+wxBitmap* WxBackgroundCache::get_bitmap(int meta_index, wxImage* image, int width, int height)
+{
+    if ( (image == NULL) || !image->IsOk() || (width <= 0) || (height <= 0) ) {
+        return NULL;
+    }
+
+    bg_key key(meta_index, width, height);
+    boost::shared_ptr<wxBitmap>* cached = bitmaps_.get(key);
+    if (cached != NULL) {
+        return cached->get();
+    }
+
+    // miss, scale and convert once for this size
+    wxImage scale_image = image->Scale(width, height);
+    boost::shared_ptr<wxBitmap> bitmap(new wxBitmap(scale_image));
+
+    // 32 bits per pixel is an upper bound on the bitmap size
+    std::size_t cost = static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4;
+    return bitmaps_.put(key, bitmap, cost)->get();
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
@@ -0,0 +1,90 @@
+#ifndef _WX_BG_CACHE_H
+#define _WX_BG_CACHE_H   1
+
+/**
+ * @file wx_bg_cache.h
+ * @brief Cache of frame backgrounds, pre-scaled to the size they are drawn at.
+ * @date 10-18-26
+ */
+
+#include <cstddef>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "lru_cache.h"
+
+// forward declarations
+class wxBitmap;
+class wxImage;
+
+namespace stan {
+
+class WxBackgroundCache
+{
+public:
+    static const std::size_t DEFAULT_BUDGET = 64 * 1024 * 1024;    // bytes
+
+    WxBackgroundCache(std::size_t budget = DEFAULT_BUDGET) :
+        bitmaps_(budget)
+    {
+    }
+
+    virtual ~WxBackgroundCache() {}
+
+    /**
+     * Get a background image scaled to (width, height) as a bitmap ready
+     * to be drawn. The image is only scaled and converted when that size of
+     * it is not already cached.
+     * @param meta_index The meta data index of the image
+     * @param image The full size image stored under meta_index
+     * @param width,height Size to draw the background at
+     * @return The bitmap or NULL if the image is not valid. The pointer is
+     *         valid until the next call.
+     */
+    wxBitmap* get_bitmap(int meta_index, wxImage* image, int width, int height);
+
+    /**
+     * Drop all bitmaps, e.g. when the meta data indices change meaning
+     * because another animation was loaded.
+     */
+    void clear() { bitmaps_.clear(); }
+
+    void set_budget(std::size_t budget) { bitmaps_.set_budget(budget); }
+
+private:
+    class bg_key
+    {
+    public:
+        bg_key(int meta_index, int width, int height) :
+            meta_index_(meta_index),
+            width_(width),
+            height_(height)
+        {
+        }
+
+        bool operator==(const bg_key& other) const
+        {
+            return (meta_index_ == other.meta_index_) && (width_ == other.width_) && (height_ == other.height_);
+        }
+
+        friend std::size_t hash_value(const bg_key& key)
+        {
+            std::size_t seed = 0;
+            boost::hash_combine(seed, key.meta_index_);
+            boost::hash_combine(seed, key.width_);
+            boost::hash_combine(seed, key.height_);
+            return seed;
+        }
+
+        int meta_index_;
+        int width_;
+        int height_;
+    };
+
+    lru_cache<bg_key, boost::shared_ptr<wxBitmap> > bitmaps_;
+};
+
+};   // namespace stan
+
+#endif  // _WX_BG_CACHE_H
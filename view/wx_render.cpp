@@ -9,6 +9,26 @@
 
 namespace stan {
 
+WxSpriteCache WxRender::sprite_cache_;
+WxAssetCache WxRender::asset_cache_(&WxRender::release_image);
+
+void WxRender::release_image(wxImage* image)
+{
+    // the asset cache calls this on the UI thread only, like the painting
+    // which uses the sprite cache; sprites are keyed by image address,
+    // which a new image may reuse
+    sprite_cache_.forget_image(image);
+    delete image;
+}
+
+void WxRender::clear_caches()
+{
+    // releasing images forgets their sprites, so the sprites go last
+    asset_cache_.clear();
+    asset_cache_.flush_releases();
+    sprite_cache_.clear();
+}
+
 void WxRender::set_wx_color(int color, wxColour& wx_color)
 {
     unsigned char* p_color_bytes = reinterpret_cast<unsigned char*>(&color);
@@ -28,71 +48,12 @@ void WxRender::render_nodes(figure* fig, std::list<int>& nodes, wxDC& dc, wxRect
 
 void WxRender::render_image(wxImage* image, wxDC& dc, Point& p0, Point& p1)
 {
-    // calc the angle between the points
-    double theta = calc_angle_vertical(p0, p1);
-    theta = PI - theta;
-
-    double dx = p1.x - p0.x;
-    double dy = p1.y - p0.y;
-
-    if ( dx == 0 && dy == 0 )
-        return;
-    
-    double height = sqrt((dx * dx) + (dy * dy));
-    double image_width = abs(image->GetWidth());
-    double image_height = abs(image->GetHeight());
-    double w2h_ratio = (double)image->GetWidth() / (double)image->GetHeight();
-    double width = w2h_ratio * height;
-
-    wxPoint pc((p1.x - p0.x) / 2, p1.y - p0.y);
-
-    wxImage scale_image = image->Scale((int)width, (int)height);
-    wxImage rot_image = scale_image.Rotate(theta, pc);
-    wxBitmap imageBitmap(rot_image);
-    wxMask* mask = new wxMask(imageBitmap, wxColour(0, 0, 0));
-    imageBitmap.SetMask(mask);
-
-    // calculate where to draw the bitmap so that n1, n2 are placed properly
-    double rot_height = rot_image.GetHeight();
-    double rot_width = rot_image.GetWidth();
-    double l = height;
-    double w = width;
-
-    double a1 = abs(l * sin((PI / 2) - theta));
-    double b1 = abs(l * cos((PI / 2) - theta));
-
-    double a2 = abs(w * sin(theta));
-    double b2 = abs(w * cos(theta));
-
-    Point c1, c2;
-    if (theta >= 0) {   // left hemisphere
-        if (theta <= (PI / 2)) {
-            c1.x = b1 + b2; c1.y = a1;
-            c2.x = b1; c2.y = a1 + a2;
-        }
-        else {
-            c1.x = b1 + b2; c1.y = a2;
-            c2.x = b1; c2.y = 0;
-        }
+    // scaled, rotated and masked once per (image, length, angle)
+    wxCoord x, y;
+    wxBitmap* bitmap = sprite_cache_.get_sprite(image, p0, p1, x, y);
+    if (bitmap != NULL) {
+        dc.DrawBitmap(*bitmap, x, y, true);
     }
-    else {  // right hemisphere
-        if (abs(theta) <= (PI / 2)) {
-            c1.x = 0; c1.y = a1;
-            c2.x = b2; c2.y = a1 + a2;
-        }
-        else {
-            c1.x = b2; c1.y = 0;
-            c2.x = 0; c2.y = a2;
-        }
-    }
-
-    // find the midpoint to determine (x,y) shift
-    Point mid;
-    midpoint(c1, c2, mid);
-    double ximage = p0.x - mid.x;
-    double yimage = p0.y - mid.y;
-
-    dc.DrawBitmap(imageBitmap, static_cast<wxCoord>(ximage), static_cast<wxCoord>(yimage), true);
 }
 
 void WxRender::play_frame_audio(animation* anim, frame* fr)
@@ -108,9 +69,10 @@ void WxRender::play_frame_audio(animation* anim, frame* fr)
             return;
         }
 
+        // NULL while the sound is still loading
         wxSound* sel_sound = static_cast<wxSound*>(md->get_meta_ptr());
-        if (sel_sound->IsOk()) {
-            sel_sound->Play(wxSOUND_SYNC);
+        if ( (sel_sound != NULL) && sel_sound->IsOk() ) {
+            sel_sound->Play(wxSOUND_SYNC);
         }
     }
 }
@@ -124,11 +86,18 @@ void WxRender::render_figure(figure* fig, wxDC& dc, wxRect& rc, bool draw_nodes)
     wxColour edge_color;
     dc.SetBrush(*wxTRANSPARENT_BRUSH);
 
+    // read node positions from the packed store
+    const node_store& ns = fig->get_node_store();
+
     for (unsigned eindex = 0; eindex < fig->get_edges().size(); eindex++) {
         edge* e = fig->get_edge(eindex);
         if (e != NULL) {
-            node* n1 = fig->get_node(e->get_n1());
-            node* n2 = fig->get_node(e->get_n2());
+            int n1 = e->get_n1();
+            int n2 = e->get_n2();
+            double x1 = ns.x_[n1];
+            double y1 = ns.y_[n1];
+            double x2 = ns.x_[n2];
+            double y2 = ns.y_[n2];
 
             WxRender::set_wx_color(e->get_color(), edge_color);
             if (enabled) {
@@ -139,15 +108,15 @@ void WxRender::render_figure(figure* fig, wxDC& dc, wxRect& rc, bool draw_nodes)
             }
 
             if (e->get_type() == edge::edge_line) {
-                dc.DrawLine( xoff + n1->get_x(), yoff + n1->get_y(), xoff + n2->get_x(), yoff + n2->get_y() );
+                dc.DrawLine( xoff + x1, yoff + y1, xoff + x2, yoff + y2 );
             }
             else if (e->get_type() == edge::edge_circle) {
                 // calculate the mid-point between n1 and n2, this will be the center
-                double cx = n1->get_x() + (n2->get_x() - n1->get_x()) / 2;
-                double cy = n1->get_y() + (n2->get_y() - n1->get_y()) / 2;
+                double cx = x1 + (x2 - x1) / 2;
+                double cy = y1 + (y2 - y1) / 2;
 
-                double dx = abs(n2->get_x() - n1->get_x());
-                double dy = abs(n2->get_y() - n1->get_y());
+                double dx = abs(x2 - x1);
+                double dy = abs(y2 - y1);
                 double radius = sqrt((dx * dx) + (dy * dy)) / 2;
 
                 dc.DrawCircle( xoff + cx, yoff + cy, radius);
@@ -155,8 +124,8 @@ void WxRender::render_figure(figure* fig, wxDC& dc, wxRect& rc, bool draw_nodes)
             else if (e->get_type() == edge::edge_image) {
                 if (enabled) {
                     // TODO: get image index from edge, use image_view_ to render
-                    Point p0(n1->get_x(), n1->get_y());
-                    Point p1(n2->get_x(), n2->get_y());
+                    Point p0(x1, y1);
+                    Point p1(x2, y2);
 
                     // Look up cached image object stored in figure
                     meta_store* meta = fig->get_meta_store();
@@ -176,6 +145,11 @@ void WxRender::render_figure(figure* fig, wxDC& dc, wxRect& rc, bool draw_nodes)
                     if (sel_image != NULL) {
                         WxRender::render_image(sel_image, dc, p0, p1);
                     }
+                    else {
+                        // placeholder until the image is loaded
+                        dc.SetPen(wxPen(wxColor(136, 136, 136), 1, wxSHORT_DASH));
+                        dc.DrawLine( xoff + x1, yoff + y1, xoff + x2, yoff + y2 );
+                    }
                 }
             }
         }
@@ -183,16 +157,15 @@ void WxRender::render_figure(figure* fig, wxDC& dc, wxRect& rc, bool draw_nodes)
 
     // draw the nodes if figure is enabled
     if (enabled && draw_nodes) {
-        for (unsigned nindex = 0; nindex < fig->get_nodes().size(); nindex++) {
-            node* n = fig->get_node(nindex);
-            if (n != NULL) {
+        for (int nindex = 0; nindex < ns.size(); nindex++) {
+            if (ns.is_live(nindex)) {
                 if (fig->is_root_node(nindex)) {
                     dc.SetPen( wxPen(wxT("green"), fig->get_weight(), wxSOLID));
                 }
                 else {
                     dc.SetPen( wxPen(wxT("red"), fig->get_weight(), wxSOLID));
                 }
-                dc.DrawCircle(xoff + n->get_x(), yoff + n->get_y(), 2);
+                dc.DrawCircle(xoff + ns.x_[nindex], yoff + ns.y_[nindex], 2);
             }
         }
     }
@@ -253,31 +226,24 @@ int WxRender::cache_anim_metadata(animation* an, std::string& path, meta_type ty
 
 int WxRender::cache_figure_metadata(figure* fig, std::string& path, meta_type type)
 {
-    meta_store* meta = fig->get_meta_store();
+    meta_store* meta = fig->edit_meta_store();
     return cache_metadata(meta, path, type);
 }
 
 int WxRender::cache_metadata(meta_store* meta, std::string& path, meta_type type)
 {
-    void* meta_ptr = NULL;
+    // decoded objects are shared with every other store using the file
+    boost::shared_ptr<void> handle;
     if (type == META_IMAGE) {
-        // create an image object from the path
-        wxImage* image = new wxImage();
-        image->LoadFile(path);
-        if (image->IsOk()) {
-            meta_ptr = static_cast<void*>(image);
-        }
+        handle = asset_cache_.get_image(path);
     }
     else if (type == META_SOUND) {
-        // create a sound object from the path
-        wxSound* sound = new wxSound(path);
-        if (sound->IsOk()) {
-            meta_ptr = static_cast<void*>(sound);
-        }
+        handle = asset_cache_.get_sound(path);
     }
 
     // cache the image and save the index as selected
-    int index = meta->add_meta_data(std::string(path), meta_ptr, type);
+    int index = meta->add_meta_data(std::string(path), NULL, type);
+    meta->get_meta_data(index)->set_meta_handle(handle);
     return index;
 }
 
@@ -286,22 +252,18 @@ void WxRender::init_meta_cache(meta_store* meta)
     std::vector<meta_data*> mdtable = meta->get_meta_table();
     BOOST_FOREACH(meta_data* data, mdtable) {
         if (data->get_type() == META_IMAGE) {
-            wxImage* image = new wxImage();
-            if (!image->LoadFile(data->get_path())) {
-                delete image;
-                image = NULL;
-                printf("Invalid image file %s\n", data->get_path());
+            boost::shared_ptr<wxImage> image = asset_cache_.get_image(data->get_path());
+            if (!image) {
+                std::cout << "Invalid image file " << data->get_path() << std::endl;
             }
-            data->set_meta_ptr((void*)image);
+            data->set_meta_handle(image);
         }
         else if (data->get_type() == META_SOUND) {
-            wxSound* sound = new wxSound(data->get_path());
-            if (!sound->IsOk()) {
-                delete sound;
-                sound = NULL;
+            boost::shared_ptr<wxSound> sound = asset_cache_.get_sound(data->get_path());
+            if (!sound) {
                 std::cout << "Invalid sound file " << data->get_path() << std::endl;
             }
-            data->set_meta_ptr((void*)sound);
+            data->set_meta_handle(sound);
         }
         else {
             std::cout << "Invalid meta data type " << data->get_type() << std::endl;
@@ -311,37 +273,26 @@ void WxRender::init_meta_cache(meta_store* meta)
 
 void WxRender::get_bounding_rect(figure* fig, wxRect& rc)
 {
-    int x1 = 640;
-    int y1 = 480;
-    int x2 = 0;
-    int y2 = 0;
-
     assert(fig != NULL);
-    std::vector<node*> nodes = fig->get_nodes();
-    for (unsigned nindex = 0; nindex < nodes.size(); nindex++) {
-        node* n = nodes[nindex];
-        if (n != NULL) {
-            int x = n->get_x();
-            if (x < x1) {
-                x1 = x;
-            }
-            if (x > x2) {
-                x2 = x;
-            }
-            int y = n->get_y();
-            if (y < y1) {
-                y1 = y;
-            }
-            if (y > y2) {
-                y2 = y;
-            }
-        }
+
+    // cached by the figure, only recomputed after it changed
+    double x1, y1, x2, y2;
+    if (!fig->get_bounds(x1, y1, x2, y2)) {
+        rc = wxRect();
+        return;
     }
 
-    rc.SetX(x1 - 10);
-    rc.SetY(y1 - 10);
-    rc.SetWidth(x2 - x1 + 20);
-    rc.SetHeight(y2 - y1 + 20);
+    // margin around the nodes, grown for thick lines
+    int margin = 10 + fig->get_weight() / 2;
+    int left = static_cast<int>(floor(x1)) - margin;
+    int top = static_cast<int>(floor(y1)) - margin;
+    int right = static_cast<int>(ceil(x2)) + margin;
+    int bottom = static_cast<int>(ceil(y2)) + margin;
+
+    rc.SetX(left);
+    rc.SetY(top);
+    rc.SetWidth(right - left);
+    rc.SetHeight(bottom - top);
 }
 
 };  // namespace stan
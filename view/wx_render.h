@@ -9,6 +9,8 @@
 #include <list>
 #include "animation.h"
 #include "trig.h"
+#include "wx_sprite_cache.h"
+#include "wx_asset_cache.h"
 
 // forward declarations
 class wxColour;
@@ -34,9 +36,26 @@ public:
 
     /**
      * Render an image in a rotated rectangle defined by two points.
+     * Bitmaps are taken from the sprite cache.
      */
     static void render_image(wxImage* image, wxDC& dc, Point& p0, Point& p1);
 
+    /**
+     * The cache of rotated image bitmaps (e.g. for hit / miss statistics).
+     */
+    static WxSpriteCache& get_sprite_cache() { return sprite_cache_; }
+
+    /**
+     * The decoded images and sounds shared by all meta stores.
+     */
+    static WxAssetCache& get_asset_cache() { return asset_cache_; }
+
+    /**
+     * Drop the cached sprites and assets. The caches are statics, destroyed
+     * only after wx has shut down, so the application clears them on exit.
+     */
+    static void clear_caches();
+
     /**
      * Renders a figure and it's contained node positions within a rectangle.
      * A figure is a set of nodes and a set of which define how they are connected.
@@ -66,12 +85,25 @@ public:
     static int cache_metadata(meta_store* imgs, std::string& path, meta_type type);
     static void init_meta_cache(meta_store* imgs);
 
+    /**
+     * Get the rectangle enclosing everything drawn for a figure (in figure
+     * coordinates), using the bounding box cached by the figure.
+     */
     static void get_bounding_rect(figure* fig, wxRect& rc);
 
     /**
      * Play audio associated with a frame.
      */
     static void play_frame_audio(animation* anim, frame* fr);
+
+private:
+    /**
+     * Destroy an image of the asset cache together with its sprites.
+     */
+    static void release_image(wxImage* image);
+
+    static WxSpriteCache sprite_cache_;
+    static WxAssetCache asset_cache_;
 };
 
 };   // namespace stan
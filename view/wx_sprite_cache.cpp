@@ -0,0 +1,121 @@
+/**
+ * @file wx_sprite_cache.cpp
+ * @brief Implementation of the image edge sprite cache.
+ * @date 10-18-26
+ */
+
+#include "wx_sprite_cache.h"
+#include <wx/wx.h>
+
+namespace stan {
+
+void WxSpriteCache::forget_image(wxImage* image)
+{
+    sprites_.erase_if(same_image(image));
+}
+
+wxBitmap* WxSpriteCache::get_sprite(wxImage* image, Point& p0, Point& p1, wxCoord& x, wxCoord& y)
+{
+    if ( (image == NULL) || !image->IsOk() ) {
+        return NULL;
+    }
+
+    double dx = p1.x - p0.x;
+    double dy = p1.y - p0.y;
+    if ( dx == 0 && dy == 0 ) {
+        return NULL;
+    }
+
+    // calc the angle between the points, in [-PI, PI)
+    double theta = PI - calc_angle_vertical(p0, p1);
+
+    // quantize so nearby poses share a sprite
+    int length = static_cast<int>(sqrt((dx * dx) + (dy * dy)) + 0.5);
+    int angle = static_cast<int>(floor((theta * ANGLE_STEPS) / (2 * PI) + 0.5));
+    if (angle >= ANGLE_STEPS / 2) {
+        angle -= ANGLE_STEPS;
+    }
+    else if (angle < -ANGLE_STEPS / 2) {
+        angle += ANGLE_STEPS;
+    }
+
+    sprite_key key(image, length, angle);
+    sprite* spr = sprites_.get(key);
+    if (spr == NULL) {
+        sprite made;
+        std::size_t cost = 0;
+        if (!make_sprite(image, length, (angle * 2 * PI) / ANGLE_STEPS, made, cost)) {
+            return NULL;
+        }
+        spr = sprites_.put(key, made, cost);
+    }
+
+    x = static_cast<wxCoord>(p0.x + spr->xoff_);
+    y = static_cast<wxCoord>(p0.y + spr->yoff_);
+    return spr->bitmap_.get();
+}
+
+bool WxSpriteCache::make_sprite(wxImage* image, int length, double theta, sprite& spr, std::size_t& cost)
+{
+    double height = length;
+    double w2h_ratio = (double)image->GetWidth() / (double)image->GetHeight();
+    double width = w2h_ratio * height;
+    if ( (static_cast<int>(width) < 1) || (static_cast<int>(height) < 1) ) {
+        return false;
+    }
+
+    wxPoint pc(static_cast<int>(width / 2), static_cast<int>(height / 2));
+
+    wxImage scale_image = image->Scale((int)width, (int)height);
+    wxImage rot_image = scale_image.Rotate(theta, pc);
+    wxBitmap* bitmap = new wxBitmap(rot_image);
+    bitmap->SetMask(new wxMask(*bitmap, wxColour(0, 0, 0)));   // bitmap owns the mask
+    spr.bitmap_.reset(bitmap);
+
+    // calculate where to draw the bitmap so that n1, n2 are placed properly
+    double l = height;
+    double w = width;
+
+    double a1 = fabs(l * sin((PI / 2) - theta));
+    double b1 = fabs(l * cos((PI / 2) - theta));
+
+    double a2 = fabs(w * sin(theta));
+    double b2 = fabs(w * cos(theta));
+
+    Point c1, c2;
+    if (theta >= 0) {   // left hemisphere
+        if (theta <= (PI / 2)) {
+            c1.x = b1 + b2; c1.y = a1;
+            c2.x = b1; c2.y = a1 + a2;
+        }
+        else {
+            c1.x = b1 + b2; c1.y = a2;
+            c2.x = b1; c2.y = 0;
+        }
+    }
+    else {  // right hemisphere
+        if (fabs(theta) <= (PI / 2)) {
+            c1.x = 0; c1.y = a1;
+            c2.x = b2; c2.y = a1 + a2;
+        }
+        else {
+            c1.x = b2; c1.y = 0;
+            c2.x = 0; c2.y = a2;
+        }
+    }
+
+    // the midpoint determines the (x,y) shift from p0
+    Point mid;
+    midpoint(c1, c2, mid);
+    spr.xoff_ = -mid.x;
+    spr.yoff_ = -mid.y;
+
+    // bitmap plus a 1 bit mask
+    std::size_t pixels = static_cast<std::size_t>(rot_image.GetWidth()) * static_cast<std::size_t>(rot_image.GetHeight());
+    cost = pixels * 4 + pixels / 8;
+    return true;
+}
+
+};  // namespace stan
+
+// END of this file -----------------------------------------------------------
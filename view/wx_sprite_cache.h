@@ -0,0 +1,135 @@
+#ifndef _WX_SPRITE_CACHE_H
+#define _WX_SPRITE_CACHE_H   1
+
+/**
+ * @file wx_sprite_cache.h
+ * @brief Cache of scaled, rotated and masked bitmaps for image edges.
+ * @date 10-18-26
+ */
+
+#include <cstddef>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <wx/defs.h>
+
+#include "lru_cache.h"
+#include "trig.h"
+
+// forward declarations
+class wxBitmap;
+class wxImage;
+
+namespace stan {
+
+class WxSpriteCache
+{
+public:
+    static const std::size_t DEFAULT_BUDGET = 32 * 1024 * 1024;    // bytes
+    static const int ANGLE_STEPS = 360;     // rotations per full turn
+
+    WxSpriteCache(std::size_t budget = DEFAULT_BUDGET) :
+        sprites_(budget)
+    {
+    }
+
+    virtual ~WxSpriteCache() {}
+
+    /**
+     * Get the bitmap for an image drawn between two points. The length is
+     * rounded to whole pixels and the angle to 1 / ANGLE_STEPS of a turn;
+     * the bitmap is only built when that combination is not cached.
+     * @param image The source image
+     * @param p0 The point at the bottom center of the image
+     * @param p1 The point at the top center of the image
+     * @param x,y Return where to draw the top left corner of the bitmap
+     * @return The masked bitmap or NULL if there is nothing to draw. The
+     *         pointer is valid until the next call.
+     */
+    wxBitmap* get_sprite(wxImage* image, Point& p0, Point& p1, wxCoord& x, wxCoord& y);
+
+    void clear() { sprites_.clear(); }
+
+    /**
+     * Drop all sprites of an image (before it is destroyed, as sprites
+     * are keyed by the image address).
+     */
+    void forget_image(wxImage* image);
+
+    void set_budget(std::size_t budget) { sprites_.set_budget(budget); }
+
+    unsigned long get_hits() const { return sprites_.get_hits(); }
+    unsigned long get_misses() const { return sprites_.get_misses(); }
+    std::size_t get_cost() const { return sprites_.get_cost(); }
+
+private:
+    /**
+     * Image pointers identify the source: meta indices are only unique
+     * within one meta store, while copies of a figure share the images.
+     */
+    class sprite_key
+    {
+    public:
+        sprite_key(wxImage* image, int length, int angle) :
+            image_(image),
+            length_(length),
+            angle_(angle)
+        {
+        }
+
+        bool operator==(const sprite_key& other) const
+        {
+            return (image_ == other.image_) && (length_ == other.length_) && (angle_ == other.angle_);
+        }
+
+        friend std::size_t hash_value(const sprite_key& key)
+        {
+            std::size_t seed = 0;
+            boost::hash_combine(seed, key.image_);
+            boost::hash_combine(seed, key.length_);
+            boost::hash_combine(seed, key.angle_);
+            return seed;
+        }
+
+        wxImage* image_;
+        int length_;    // pixels
+        int angle_;     // in steps of 1 / ANGLE_STEPS turn
+    };
+
+    class same_image
+    {
+    public:
+        same_image(wxImage* image) : image_(image) {}
+        bool operator()(const sprite_key& key) const { return key.image_ == image_; }
+
+        wxImage* image_;
+    };
+
+    class sprite
+    {
+    public:
+        sprite() :
+            bitmap_(),
+            xoff_(0),
+            yoff_(0)
+        {
+        }
+
+        boost::shared_ptr<wxBitmap> bitmap_;
+        double xoff_;   // top left corner relative to p0
+        double yoff_;
+    };
+
+    /**
+     * Scale, rotate and mask an image.
+     * @return false if the image is too small to draw
+     */
+    bool make_sprite(wxImage* image, int length, double theta, sprite& spr, std::size_t& cost);
+
+    lru_cache<sprite_key, sprite> sprites_;
+};
+
+};   // namespace stan
+
+#endif  // _WX_SPRITE_CACHE_H